@@ -9,6 +9,7 @@ public class GASShooterALSTarget : TargetRules
 	{
 		Type = TargetType.Game;
 		DefaultBuildSettings = BuildSettingsVersion.V2;
+		bWithPushModel = true;
 		ExtraModuleNames.AddRange( new string[] { "GASShooterALS" } );
 	}
 }
@@ -16,7 +16,9 @@ public class GASShooterALS : ModuleRules
 			"GameplayAbilities",
 			"GameplayTags",
 			"GameplayTasks",
+			"NetCore",
 			"Paper2D",
+			"ReplicationGraph",
             "ALSV4_CPP"
 		});
 
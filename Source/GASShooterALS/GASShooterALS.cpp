@@ -3,4 +3,6 @@
 #include "GASShooterALS.h"
 #include "Modules/ModuleManager.h"
 
+DEFINE_LOG_CATEGORY(LogGASShooterALS);
+
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, GASShooterALS, "GASShooterALS" );
@@ -4,6 +4,7 @@
 #include "GASShooterALSGameModeBase.h"
 #include "Engine/World.h"
 #include "Characters/Heroes/GSHeroCharacter.h"
+#include "GSActorPoolSubsystem.h"
 #include "Player/GSPlayerController.h"
 #include "Player/GSPlayerState.h"
 #include "GameFramework/SpectatorPawn.h"
@@ -24,9 +25,7 @@ AGASShooterALSGameModeBase::AGASShooterALSGameModeBase()
 
 void AGASShooterALSGameModeBase::HeroDied(AController* Controller)
 {
-	FActorSpawnParameters SpawnParameters;
-	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
-	ASpectatorPawn* SpectatorPawn = GetWorld()->SpawnActor<ASpectatorPawn>(SpectatorClass, Controller->GetPawn()->GetActorTransform(), SpawnParameters);
+	ASpectatorPawn* SpectatorPawn = UGSActorPoolSubsystem::AcquireSpectator(GetWorld(), SpectatorClass, Controller->GetPawn()->GetActorTransform());
 
 	Controller->UnPossess();
 	Controller->Possess(SpectatorPawn);
@@ -78,14 +77,11 @@ void AGASShooterALSGameModeBase::RespawnHero(AController* Controller)
 		// Respawn player hero
 		AActor* PlayerStart = FindPlayerStart(Controller);
 
-		FActorSpawnParameters SpawnParameters;
-		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
-
-		AGSHeroCharacter* Hero = GetWorld()->SpawnActor<AGSHeroCharacter>(HeroClass, PlayerStart->GetActorLocation(), PlayerStart->GetActorRotation(), SpawnParameters);
+		AGSHeroCharacter* Hero = UGSActorPoolSubsystem::AcquireHero(GetWorld(), HeroClass, FTransform(PlayerStart->GetActorRotation(), PlayerStart->GetActorLocation()));
 
 		APawn* OldSpectatorPawn = Controller->GetPawn();
 		Controller->UnPossess();
-		OldSpectatorPawn->Destroy();
+		UGSActorPoolSubsystem::Release(OldSpectatorPawn);
 		Controller->Possess(Hero);
 		
 		AGSPlayerController* PC = Cast<AGSPlayerController>(Controller);
@@ -97,14 +93,11 @@ void AGASShooterALSGameModeBase::RespawnHero(AController* Controller)
 	else
 	{
 		// Respawn AI hero
-		FActorSpawnParameters SpawnParameters;
-		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
-
-		AGSHeroCharacter* Hero = GetWorld()->SpawnActor<AGSHeroCharacter>(HeroClass, EnemySpawnPoint->GetActorTransform(), SpawnParameters);
+		AGSHeroCharacter* Hero = UGSActorPoolSubsystem::AcquireHero(GetWorld(), HeroClass, EnemySpawnPoint->GetActorTransform());
 
 		APawn* OldSpectatorPawn = Controller->GetPawn();
 		Controller->UnPossess();
-		OldSpectatorPawn->Destroy();
+		UGSActorPoolSubsystem::Release(OldSpectatorPawn);
 		Controller->Possess(Hero);
 	}
 }
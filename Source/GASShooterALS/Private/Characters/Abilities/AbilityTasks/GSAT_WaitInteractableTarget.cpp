@@ -6,21 +6,48 @@
 #include "Characters/Heroes/GSHeroCharacter.h"
 #include "DrawDebugHelpers.h"
 #include "GSBlueprintFunctionLibrary.h"
+#include "GSInteractableSubsystem.h"
+#include "HAL/IConsoleManager.h"
 #include "TimerManager.h"
 
+DECLARE_DWORD_COUNTER_STAT(TEXT("Interaction Scans"), STAT_GSInteractables_Scans, STATGROUP_GSInteractables);
+DECLARE_DWORD_COUNTER_STAT(TEXT("View Coherent Skips"), STAT_GSInteractables_ViewCoherentSkips, STATGROUP_GSInteractables);
+
+static TAutoConsoleVariable<int32> CVarViewCoherentScans(
+	TEXT("GS.Interaction.ViewCoherentScans"),
+	1,
+	TEXT("Skip interaction scans while the view and nearby interactables haven't changed since the last trace")
+);
+
+static TAutoConsoleVariable<float> CVarMaxScanCacheAge(
+	TEXT("GS.Interaction.MaxScanCacheAge"),
+	0.5f,
+	TEXT("Seconds a skipped interaction scan's result is reused before tracing again anyway. Catches interactables whose availability changed without calling NotifyAvailabilityChanged, like ones changed by another player.")
+);
+
 UGSAT_WaitInteractableTarget::UGSAT_WaitInteractableTarget(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
 	bTraceAffectsAimPitch = true;
+	CandidateConeHalfAngle = 90.0f;
+	ViewAngleThreshold = 0.5f;
+	ViewDistanceThreshold = 5.0f;
+	bHasScanCache = false;
+	bScanCacheDirty = false;
+	CachedScanTime = 0.0f;
+	CachedNumCandidates = 0;
+	CachedCandidateRevision = 0;
 }
 
-UGSAT_WaitInteractableTarget* UGSAT_WaitInteractableTarget::WaitForInteractableTarget(UGameplayAbility* OwningAbility, FName TaskInstanceName, FCollisionProfileName TraceProfile, float MaxRange, float TimerPeriod, bool bShowDebug)
+UGSAT_WaitInteractableTarget* UGSAT_WaitInteractableTarget::WaitForInteractableTarget(UGameplayAbility* OwningAbility, FName TaskInstanceName, FCollisionProfileName TraceProfile, float MaxRange, float TimerPeriod, bool bShowDebug, float ViewAngleThreshold, float ViewDistanceThreshold)
 {
 	UGSAT_WaitInteractableTarget* MyObj = NewAbilityTask<UGSAT_WaitInteractableTarget>(OwningAbility, TaskInstanceName);		//Register for task list here, providing a given FName as a key
 	MyObj->TraceProfile = TraceProfile;
 	MyObj->MaxRange = MaxRange;
 	MyObj->TimerPeriod = TimerPeriod;
 	MyObj->bShowDebug = bShowDebug;
+	MyObj->ViewAngleThreshold = ViewAngleThreshold;
+	MyObj->ViewDistanceThreshold = ViewDistanceThreshold;
 	
 	AGSHeroCharacter* Hero = Cast<AGSHeroCharacter>(OwningAbility->GetCurrentActorInfo()->AvatarActor);
 
@@ -43,6 +70,11 @@ void UGSAT_WaitInteractableTarget::Activate()
 {
 	UWorld* World = GetWorld();
 	World->GetTimerManager().SetTimer(TraceTimerHandle, this, &UGSAT_WaitInteractableTarget::PerformTrace, TimerPeriod, true);
+
+	if (UGSInteractableSubsystem* Interactables = World->GetSubsystem<UGSInteractableSubsystem>())
+	{
+		AvailabilityChangedHandle = Interactables->OnAvailabilityChanged.AddUObject(this, &UGSAT_WaitInteractableTarget::OnInteractableAvailabilityChanged);
+	}
 }
 
 void UGSAT_WaitInteractableTarget::OnDestroy(bool AbilityEnded)
@@ -50,6 +82,11 @@ void UGSAT_WaitInteractableTarget::OnDestroy(bool AbilityEnded)
 	UWorld* World = GetWorld();
 	World->GetTimerManager().ClearTimer(TraceTimerHandle);
 
+	if (UGSInteractableSubsystem* Interactables = World->GetSubsystem<UGSInteractableSubsystem>())
+	{
+		Interactables->OnAvailabilityChanged.Remove(AvailabilityChangedHandle);
+	}
+
 	Super::OnDestroy(AbilityEnded);
 }
 
@@ -176,6 +213,68 @@ bool UGSAT_WaitInteractableTarget::ClipCameraRayToAbilityRange(FVector CameraLoc
 	return false;
 }
 
+void UGSAT_WaitInteractableTarget::GetViewPoint(const FVector& TraceStart, FVector& OutViewLocation, FVector& OutViewDir) const
+{
+	APlayerController* PC = Ability->GetCurrentActorInfo()->PlayerController.Get();
+
+	// Default to TraceStart if no PlayerController
+	OutViewLocation = TraceStart;
+	FRotator ViewRot(0.0f);
+	if (PC)
+	{
+		PC->GetPlayerViewPoint(OutViewLocation, ViewRot);
+	}
+
+	OutViewDir = ViewRot.Vector();
+}
+
+int32 UGSAT_WaitInteractableTarget::CountInteractableCandidates(const AActor* InSourceActor, const FVector& TraceStart, const FVector& ViewDir, uint32& OutNewestRevision) const
+{
+	OutNewestRevision = 0;
+
+	const UGSInteractableSubsystem* Interactables = GetWorld()->GetSubsystem<UGSInteractableSubsystem>();
+	if (!Interactables)
+	{
+		return INDEX_NONE;
+	}
+
+	// Every hit of the traces is within MaxRange of TraceStart
+	return Interactables->CountInteractableCandidates(TraceStart, ViewDir, MaxRange, FMath::DegreesToRadians(CandidateConeHalfAngle), InSourceActor, OutNewestRevision);
+}
+
+bool UGSAT_WaitInteractableTarget::IsScanCacheValid(const FVector& ViewLocation, const FVector& ViewDir, const FVector& TraceStart, int32 NumCandidates, uint32 CandidateRevision) const
+{
+	if (!bHasScanCache || bScanCacheDirty || CVarViewCoherentScans.GetValueOnGameThread() == 0)
+	{
+		return false;
+	}
+
+	if (GetWorld()->GetTimeSeconds() - CachedScanTime > CVarMaxScanCacheAge.GetValueOnGameThread())
+	{
+		return false;
+	}
+
+	// Without the registry we can't tell if an interactable moved into view
+	if (NumCandidates == INDEX_NONE || NumCandidates != CachedNumCandidates || CandidateRevision != CachedCandidateRevision)
+	{
+		return false;
+	}
+
+	const float DistanceThresholdSquared = ViewDistanceThreshold * ViewDistanceThreshold;
+	if (FVector::DistSquared(ViewLocation, CachedViewLocation) > DistanceThresholdSquared || FVector::DistSquared(TraceStart, CachedTraceStart) > DistanceThresholdSquared)
+	{
+		return false;
+	}
+
+	return FVector::DotProduct(ViewDir, CachedViewDir) >= FMath::Cos(FMath::DegreesToRadians(ViewAngleThreshold));
+}
+
+void UGSAT_WaitInteractableTarget::OnInteractableAvailabilityChanged(AActor* Interactable)
+{
+	// Rare enough that any change can retrace
+	bScanCacheDirty = true;
+}
+
 void UGSAT_WaitInteractableTarget::PerformTrace()
 {
 	bool bTraceComplex = false;
@@ -206,15 +305,51 @@ void UGSAT_WaitInteractableTarget::PerformTrace()
 	Params.bReturnPhysicalMaterial = true;
 	Params.AddIgnoredActors(ActorsToIgnore);
 
+	INC_DWORD_STAT(STAT_GSInteractables_Scans);
+
 	// Calculate TraceEnd
 	FVector TraceStart = StartLocation.GetTargetingTransform().GetLocation();
 	FVector TraceEnd;
-	AimWithPlayerController(SourceActor, Params, TraceStart, TraceEnd); //Effective on server and launching client only
+	FHitResult ReturnHitResult;
 
-	// ------------------------------------------------------
+	FVector ViewLocation, ViewDir;
+	GetViewPoint(TraceStart, ViewLocation, ViewDir);
 
-	FHitResult ReturnHitResult;
-	LineTrace(ReturnHitResult, GetWorld(), TraceStart, TraceEnd, TraceProfile.Name, Params, true);
+	uint32 CandidateRevision;
+	const int32 NumCandidates = CountInteractableCandidates(SourceActor, TraceStart, ViewDir, CandidateRevision);
+
+	if (IsScanCacheValid(ViewLocation, ViewDir, TraceStart, NumCandidates, CandidateRevision))
+	{
+		// Nothing we could see changed, the last result still holds
+		INC_DWORD_STAT(STAT_GSInteractables_ViewCoherentSkips);
+		return;
+	}
+
+	bHasScanCache = true;
+	bScanCacheDirty = false;
+	CachedScanTime = GetWorld()->GetTimeSeconds();
+	CachedViewLocation = ViewLocation;
+	CachedViewDir = ViewDir;
+	CachedTraceStart = TraceStart;
+	CachedNumCandidates = NumCandidates;
+	CachedCandidateRevision = CandidateRevision;
+
+	// INDEX_NONE means there is no registry to ask
+	if (NumCandidates != 0)
+	{
+		AimWithPlayerController(SourceActor, Params, TraceStart, TraceEnd); //Effective on server and launching client only
+
+		// ------------------------------------------------------
+
+		LineTrace(ReturnHitResult, GetWorld(), TraceStart, TraceEnd, TraceProfile.Name, Params, true);
+	}
+	else
+	{
+		// Nothing interactable in range, skip both traces
+		TraceEnd = TraceStart + (ViewDir * MaxRange);
+		ReturnHitResult.TraceStart = TraceStart;
+		ReturnHitResult.TraceEnd = TraceEnd;
+	}
 	
 	// Default to end of trace line if we don't hit a valid, available Interactable Actor
 	// bBlockingHit = valid, available Interactable Actor
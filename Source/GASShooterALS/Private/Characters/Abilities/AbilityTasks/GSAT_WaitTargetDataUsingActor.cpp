@@ -3,6 +3,7 @@
 
 #include "Characters/Abilities/AbilityTasks/GSAT_WaitTargetDataUsingActor.h"
 #include "AbilitySystemComponent.h"
+#include "Characters/Abilities/GSAbilitySystemComponent.h"
 #include "Characters/Abilities/GSGATA_Trace.h"
 
 UGSAT_WaitTargetDataUsingActor::UGSAT_WaitTargetDataUsingActor(const FObjectInitializer& ObjectInitializer)
@@ -102,7 +103,14 @@ void UGSAT_WaitTargetDataUsingActor::OnTargetDataReadyCallback(const FGameplayAb
 		if (!TargetActor->ShouldProduceTargetDataOnServer)
 		{
 			FGameplayTag ApplicationTag; // Fixme: where would this be useful?
-			AbilitySystemComponent->CallServerSetReplicatedTargetData(GetAbilitySpecHandle(), GetActivationPredictionKey(), Data, ApplicationTag, AbilitySystemComponent->ScopedPredictionKey);
+			if (UGSAbilitySystemComponent* GSASC = Cast<UGSAbilitySystemComponent>(AbilitySystemComponent))
+			{
+				GSASC->SendTargetDataToServer(GetAbilitySpecHandle(), GetActivationPredictionKey(), Data, ApplicationTag, AbilitySystemComponent->ScopedPredictionKey);
+			}
+			else
+			{
+				AbilitySystemComponent->CallServerSetReplicatedTargetData(GetAbilitySpecHandle(), GetActivationPredictionKey(), Data, ApplicationTag, AbilitySystemComponent->ScopedPredictionKey);
+			}
 		}
 		else if (ConfirmationType == EGameplayTargetingConfirmation::UserConfirmed)
 		{
@@ -130,6 +138,12 @@ void UGSAT_WaitTargetDataUsingActor::OnTargetDataCancelledCallback(const FGamepl
 
 	if (IsPredictingClient())
 	{
+		// Held shots have to reach the server before the cancel
+		if (UGSAbilitySystemComponent* GSASC = Cast<UGSAbilitySystemComponent>(AbilitySystemComponent))
+		{
+			GSASC->FlushTargetDataBundles();
+		}
+
 		if (!TargetActor->ShouldProduceTargetDataOnServer)
 		{
 			AbilitySystemComponent->ServerSetReplicatedTargetDataCancelled(GetAbilitySpecHandle(), GetActivationPredictionKey(), AbilitySystemComponent->ScopedPredictionKey);
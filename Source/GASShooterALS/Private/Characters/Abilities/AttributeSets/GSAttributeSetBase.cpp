@@ -2,6 +2,7 @@
 
 
 #include "Characters/Abilities/AttributeSets/GSAttributeSetBase.h"
+#include "Characters/Abilities/GSAbilitySystemGlobals.h"
 #include "Characters/GSCharacterBase.h"
 #include "GameplayEffect.h"
 #include "GameplayEffectExtension.h"
@@ -159,24 +160,12 @@ void UGSAttributeSetBase::PostGameplayEffectExecute(const FGameplayEffectModCall
 					// Don't give bounty to self.
 					if (SourceController != TargetController)
 					{
-						// Create a dynamic instant Gameplay Effect to give the bounties
-						UGameplayEffect* GEBounty = NewObject<UGameplayEffect>(GetTransientPackage(), FName(TEXT("Bounty")));
-						GEBounty->DurationPolicy = EGameplayEffectDurationType::Instant;
-
-						int32 Idx = GEBounty->Modifiers.Num();
-						GEBounty->Modifiers.SetNum(Idx + 2);
-
-						FGameplayModifierInfo& InfoXP = GEBounty->Modifiers[Idx];
-						InfoXP.ModifierMagnitude = FScalableFloat(GetXPBounty());
-						InfoXP.ModifierOp = EGameplayModOp::Additive;
-						InfoXP.Attribute = UGSAttributeSetBase::GetXPAttribute();
-
-						FGameplayModifierInfo& InfoGold = GEBounty->Modifiers[Idx + 1];
-						InfoGold.ModifierMagnitude = FScalableFloat(GetGoldBounty());
-						InfoGold.ModifierOp = EGameplayModOp::Additive;
-						InfoGold.Attribute = UGSAttributeSetBase::GetGoldAttribute();
-
-						Source->ApplyGameplayEffectToSelf(GEBounty, 1.0f, Source->MakeEffectContext());
+						// Give the bounties through the shared bounty effect
+						UGSAbilitySystemGlobals& Globals = UGSAbilitySystemGlobals::GSGet();
+						FGameplayEffectSpec BountySpec(Globals.GetBountyEffect(), Source->MakeEffectContext(), 1.0f);
+						BountySpec.SetSetByCallerMagnitude(Globals.BountyXPDataTag, GetXPBounty());
+						BountySpec.SetSetByCallerMagnitude(Globals.BountyGoldDataTag, GetGoldBounty());
+						Source->ApplyGameplayEffectSpecToSelf(BountySpec);
 					}
 				}
 			}
@@ -5,8 +5,14 @@
 #include "AbilitySystemGlobals.h"
 #include "Animation/AnimInstance.h"
 #include "Characters/Abilities/GSGameplayAbility.h"
+#include "Characters/Abilities/GSGameplayCueManager.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
 #include "GameplayCueManager.h"
+#include "GASShooterALS/GASShooterALS.h"
 #include "GSBlueprintFunctionLibrary.h"
+#include "GSNetUpdateFrequencySubsystem.h"
 #include "Net/UnrealNetwork.h"
 #include "Weapons/GSWeapon.h"
 
@@ -16,8 +22,87 @@ static TAutoConsoleVariable<float> CVarReplayMontageErrorThreshold(
 	TEXT("Tolerance level for when montage playback position correction occurs in replays")
 );
 
+static TAutoConsoleVariable<float> CVarMontageRepPositionDriftThreshold(
+	TEXT("GS.Montage.RepPositionDriftThreshold"),
+	0.05f,
+	TEXT("Seconds a montage may drift from its last replicated position, extrapolated by play rate, before the position is replicated again. 0 replicates it every tick.")
+);
+
+static TAutoConsoleVariable<int32> CVarShotBundling(
+	TEXT("GS.Ability.ShotBundling"),
+	1,
+	TEXT("Send the target data of abilities with bBundleTargetData, and of weapons in full auto, in one RPC per GS.Ability.ShotBundleInterval instead of one per shot")
+);
+
+static TAutoConsoleVariable<float> CVarShotBundleInterval(
+	TEXT("GS.Ability.ShotBundleInterval"),
+	0.1f,
+	TEXT("Time in seconds a bundled shot is held before it is sent with the end of frame flush. The server also uses it to clamp how old a bundled shot can claim to be.")
+);
+
+// Bundles are sent early once they hold this many shots
+static const int32 GSMaxBundledShots = 16;
+
+DECLARE_STATS_GROUP(TEXT("GSAbilitySystem"), STATGROUP_GSAbilitySystem, STATCAT_Advanced);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Montage Rep Updates"), STAT_GSAbilitySystem_MontageRepUpdates, STATGROUP_GSAbilitySystem);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Montage Rep Dirty"), STAT_GSAbilitySystem_MontageRepDirty, STATGROUP_GSAbilitySystem);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Bundled Shots"), STAT_GSAbilitySystem_BundledShots, STATGROUP_GSAbilitySystem);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Shot Bundles Sent"), STAT_GSAbilitySystem_ShotBundlesSent, STATGROUP_GSAbilitySystem);
+
+static FAutoConsoleCommandWithWorldAndArgs CmdMontageLookupBenchmark(
+	TEXT("GS.Montage.LookupBenchmark"),
+	TEXT("Times per-mesh montage lookups on the first local player's ASC against the linear scans they replaced. Usage: GS.Montage.LookupBenchmark [Iterations]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		APlayerController* PC = World ? World->GetFirstPlayerController() : nullptr;
+		UGSAbilitySystemComponent* ASC = PC ? UGSAbilitySystemComponent::GetAbilitySystemComponentFromActor(PC->GetPawn()) : nullptr;
+		if (!ASC)
+		{
+			UE_LOG(LogGASShooterALS, Warning, TEXT("GS.Montage.LookupBenchmark: the first local player has no pawn with a UGSAbilitySystemComponent"));
+			return;
+		}
+
+		const int32 Iterations = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 100000;
+		ASC->RunMontageLookupBenchmark(Iterations);
+	})
+);
+
+void FGameplayAbilityRepAnimMontageForMesh::PostReplicatedAdd(const FGameplayAbilityRepAnimMontageForMeshArray& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->OnRep_ReplicatedAnimMontageForMesh(*this);
+	}
+}
+
+void FGameplayAbilityRepAnimMontageForMesh::PostReplicatedChange(const FGameplayAbilityRepAnimMontageForMeshArray& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->OnRep_ReplicatedAnimMontageForMesh(*this);
+	}
+}
+
 UGSAbilitySystemComponent::UGSAbilitySystemComponent()
 {
+	OldestBundledShotTime = 0.0f;
+	CurrentBundledShotAge = 0.0f;
+	bAbilitySpecIndexDirty = true;
+}
+
+void UGSAbilitySystemComponent::InitializeComponent()
+{
+	Super::InitializeComponent();
+
+	// Set here rather than in the constructor so the pointer isn't copied from the archetype into instances
+	RepAnimMontageInfoForMeshes.Owner = this;
+}
+
+void UGSAbilitySystemComponent::BeginDestroy()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(FlushTargetDataBundlesHandle);
+
+	Super::BeginDestroy();
 }
 
 void UGSAbilitySystemComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
@@ -29,13 +114,14 @@ void UGSAbilitySystemComponent::GetLifetimeReplicatedProps(TArray<FLifetimePrope
 
 bool UGSAbilitySystemComponent::GetShouldTick() const
 {
-	for (FGameplayAbilityRepAnimMontageForMesh RepMontageInfo : RepAnimMontageInfoForMeshes)
+	if (IsOwnerActorAuthoritative())
 	{
-		const bool bHasReplicatedMontageInfoToUpdate = (IsOwnerActorAuthoritative() && RepMontageInfo.RepMontageInfo.IsStopped == false);
-
-		if (bHasReplicatedMontageInfoToUpdate)
+		for (const FGameplayAbilityRepAnimMontageForMesh& RepMontageInfo : RepAnimMontageInfoForMeshes.Items)
 		{
-			return true;
+			if (RepMontageInfo.RepMontageInfo.IsStopped == false)
+			{
+				return true;
+			}
 		}
 	}
 
@@ -46,9 +132,13 @@ void UGSAbilitySystemComponent::TickComponent(float DeltaTime, ELevelTick TickTy
 {
 	if (IsOwnerActorAuthoritative())
 	{
-		for (FGameplayAbilityLocalAnimMontageForMesh& MontageInfo : LocalAnimMontageInfoForMeshes)
+		// Stopped montages only change through PlayMontageForMesh() and friends, which update them right away
+		for (FGameplayAbilityRepAnimMontageForMesh& RepMontageInfo : RepAnimMontageInfoForMeshes.Items)
 		{
-			AnimMontage_UpdateReplicatedDataForMesh(MontageInfo.Mesh);
+			if (RepMontageInfo.RepMontageInfo.IsStopped == false)
+			{
+				AnimMontage_UpdateReplicatedDataForMesh(RepMontageInfo);
+			}
 		}
 	}
 
@@ -60,7 +150,17 @@ void UGSAbilitySystemComponent::InitAbilityActorInfo(AActor* InOwnerActor, AActo
 	Super::InitAbilityActorInfo(InOwnerActor, InAvatarActor);
 
 	LocalAnimMontageInfoForMeshes = TArray<FGameplayAbilityLocalAnimMontageForMesh>();
-	RepAnimMontageInfoForMeshes = TArray<FGameplayAbilityRepAnimMontageForMesh>();
+	LocalAnimMontageSlotByMesh.Reset();
+
+	// Clients never modify the replicated array, it would desync the fast array's item IDs
+	if (IsOwnerActorAuthoritative())
+	{
+		RepAnimMontageInfoForMeshes.Items.Reset();
+		RepAnimMontageInfoForMeshes.MarkArrayDirty();
+		RepAnimMontageSlotByMesh.Reset();
+	}
+
+	RefreshMontageMeshSlots();
 
 	if (bPendingMontageRep)
 	{
@@ -68,6 +168,13 @@ void UGSAbilitySystemComponent::InitAbilityActorInfo(AActor* InOwnerActor, AActo
 	}
 }
 
+void UGSAbilitySystemComponent::ForceReplication()
+{
+	Super::ForceReplication();
+
+	UGSNetUpdateFrequencySubsystem::NotifyReplicatedStateChanged(GetOwner());
+}
+
 void UGSAbilitySystemComponent::NotifyAbilityEnded(FGameplayAbilitySpecHandle Handle, UGameplayAbility* Ability, bool bWasCancelled)
 {
 	Super::NotifyAbilityEnded(Handle, Ability, bWasCancelled);
@@ -99,10 +206,17 @@ void UGSAbilitySystemComponent::AbilityLocalInputPressed(int32 InputID)
 	// ---------------------------------------------------------
 
 	ABILITYLIST_SCOPE_LOCK();
-	for (FGameplayAbilitySpec& Spec : ActivatableAbilities.Items)
+
+	// The lock defers any give or remove that activating an ability does, so the specs stay put while we go through them
+	FAbilitySpecHandleList Handles;
+	FindAbilitySpecHandlesForInputID(InputID, Handles);
+
+	for (const FGameplayAbilitySpecHandle& Handle : Handles)
 	{
-		if (Spec.InputID == InputID)
+		FGameplayAbilitySpec* SpecPtr = FindIndexedAbilitySpec(Handle);
+		if (SpecPtr && SpecPtr->InputID == InputID)
 		{
+			FGameplayAbilitySpec& Spec = *SpecPtr;
 			if (Spec.Ability)
 			{
 				Spec.InputPressed = true;
@@ -139,20 +253,97 @@ int32 UGSAbilitySystemComponent::K2_GetTagCount(FGameplayTag TagToCheck) const
 
 FGameplayAbilitySpecHandle UGSAbilitySystemComponent::FindAbilitySpecHandleForClass(TSubclassOf<UGameplayAbility> AbilityClass, UObject* OptionalSourceObject)
 {
-	ABILITYLIST_SCOPE_LOCK();
-	for (FGameplayAbilitySpec& Spec : ActivatableAbilities.Items)
+	// Weapons of the same type grant the same ability class, so there are usually only a few candidates. Return the one
+	// earliest in ActivatableAbilities to match what a scan would find.
+	FGameplayAbilitySpecHandle FoundHandle;
+	int32 FoundIndex = MAX_int32;
+
+	for (auto It = AbilitySpecHandlesByClass.CreateConstKeyIterator(AbilityClass.Get()); It; ++It)
 	{
-		TSubclassOf<UGameplayAbility> SpecAbilityClass = Spec.Ability->GetClass();
-		if (SpecAbilityClass == AbilityClass)
+		const FGameplayAbilitySpec* Spec = FindIndexedAbilitySpec(It.Value());
+		if (!Spec || (OptionalSourceObject && Spec->SourceObject != OptionalSourceObject))
 		{
-			if (!OptionalSourceObject || (OptionalSourceObject && Spec.SourceObject == OptionalSourceObject))
-			{
-				return Spec.Handle;
-			}
+			continue;
+		}
+
+		const int32 SpecIndex = UE_PTRDIFF_TO_INT32(Spec - ActivatableAbilities.Items.GetData());
+		if (SpecIndex < FoundIndex)
+		{
+			FoundIndex = SpecIndex;
+			FoundHandle = Spec->Handle;
+		}
+	}
+
+	return FoundHandle;
+}
+
+void UGSAbilitySystemComponent::FindAbilitySpecHandlesForInputID(int32 InputID, FAbilitySpecHandleList& OutHandles) const
+{
+	OutHandles.Reset();
+	AbilitySpecHandlesByInputID.MultiFind(InputID, OutHandles, true);
+}
+
+void UGSAbilitySystemComponent::OnGiveAbility(FGameplayAbilitySpec& AbilitySpec)
+{
+	Super::OnGiveAbility(AbilitySpec);
+
+	AbilitySpecHandlesByInputID.Add(AbilitySpec.InputID, AbilitySpec.Handle);
+	if (AbilitySpec.Ability)
+	{
+		AbilitySpecHandlesByClass.Add(AbilitySpec.Ability->GetClass(), AbilitySpec.Handle);
+	}
+
+	bAbilitySpecIndexDirty = true;
+}
+
+void UGSAbilitySystemComponent::OnRemoveAbility(FGameplayAbilitySpec& AbilitySpec)
+{
+	AbilitySpecHandlesByInputID.RemoveSingle(AbilitySpec.InputID, AbilitySpec.Handle);
+	if (AbilitySpec.Ability)
+	{
+		AbilitySpecHandlesByClass.RemoveSingle(AbilitySpec.Ability->GetClass(), AbilitySpec.Handle);
+	}
+
+	bAbilitySpecIndexDirty = true;
+
+	Super::OnRemoveAbility(AbilitySpec);
+}
+
+FGameplayAbilitySpec* UGSAbilitySystemComponent::FindIndexedAbilitySpec(FGameplayAbilitySpecHandle Handle)
+{
+	const int32 Index = FindIndexedAbilitySpecIndex(Handle);
+	return Index != INDEX_NONE ? &ActivatableAbilities.Items[Index] : nullptr;
+}
+
+const FGameplayAbilitySpec* UGSAbilitySystemComponent::FindIndexedAbilitySpec(FGameplayAbilitySpecHandle Handle) const
+{
+	const int32 Index = FindIndexedAbilitySpecIndex(Handle);
+	return Index != INDEX_NONE ? &ActivatableAbilities.Items[Index] : nullptr;
+}
+
+int32 UGSAbilitySystemComponent::FindIndexedAbilitySpecIndex(FGameplayAbilitySpecHandle Handle) const
+{
+	const TArray<FGameplayAbilitySpec>& Items = ActivatableAbilities.Items;
+
+	if (!bAbilitySpecIndexDirty)
+	{
+		const int32* Index = AbilitySpecIndexByHandle.Find(Handle);
+		if (Index && Items.IsValidIndex(*Index) && Items[*Index].Handle == Handle)
+		{
+			return *Index;
 		}
 	}
 
-	return FGameplayAbilitySpecHandle();
+	// The list changed since we last looked, or was changed without telling us (replication on clients)
+	AbilitySpecIndexByHandle.Reset();
+	for (int32 Index = 0; Index < Items.Num(); Index++)
+	{
+		AbilitySpecIndexByHandle.Add(Items[Index].Handle, Index);
+	}
+	bAbilitySpecIndexDirty = false;
+
+	const int32* Index = AbilitySpecIndexByHandle.Find(Handle);
+	return Index ? *Index : INDEX_NONE;
 }
 
 void UGSAbilitySystemComponent::K2_AddLooseGameplayTag(const FGameplayTag& GameplayTag, int32 Count)
@@ -199,20 +390,154 @@ bool UGSAbilitySystemComponent::BatchRPCTryActivateAbility(FGameplayAbilitySpecH
 	return AbilityActivated;
 }
 
+void UGSAbilitySystemComponent::SendTargetDataToServer(FGameplayAbilitySpecHandle AbilityHandle, FPredictionKey AbilityOriginalPredictionKey, const FGameplayAbilityTargetDataHandle& TargetData, FGameplayTag ApplicationTag, FPredictionKey CurrentPredictionKey)
+{
+	if (!ShouldBundleTargetData(AbilityHandle))
+	{
+		// Keep the order the server sees shots in
+		FlushTargetDataBundles();
+		CallServerSetReplicatedTargetData(AbilityHandle, AbilityOriginalPredictionKey, TargetData, ApplicationTag, CurrentPredictionKey);
+		return;
+	}
+
+	FPendingTargetDataBundle* Bundle = PendingTargetDataBundles.FindByPredicate([&](const FPendingTargetDataBundle& PendingBundle)
+	{
+		return PendingBundle.AbilityHandle == AbilityHandle && PendingBundle.AbilityOriginalPredictionKey == AbilityOriginalPredictionKey;
+	});
+
+	if (!Bundle)
+	{
+		Bundle = &PendingTargetDataBundles.AddDefaulted_GetRef();
+		Bundle->AbilityHandle = AbilityHandle;
+		Bundle->AbilityOriginalPredictionKey = AbilityOriginalPredictionKey;
+		Bundle->Shots.Reserve(GSMaxBundledShots);
+	}
+
+	FGSBundledTargetData& Shot = Bundle->Shots.AddDefaulted_GetRef();
+	Shot.TargetData = TargetData;
+	Shot.ApplicationTag = ApplicationTag;
+	Shot.PredictionKey = CurrentPredictionKey;
+	Shot.Timestamp = GetWorld()->GetTimeSeconds();
+
+	INC_DWORD_STAT(STAT_GSAbilitySystem_BundledShots);
+
+	if (Bundle->Shots.Num() >= GSMaxBundledShots)
+	{
+		FlushTargetDataBundles();
+	}
+	else if (!FlushTargetDataBundlesHandle.IsValid())
+	{
+		// Sent from the end of a frame, right before the net driver flushes this frame's RPCs
+		OldestBundledShotTime = Shot.Timestamp;
+		FlushTargetDataBundlesHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UGSAbilitySystemComponent::OnWorldPostActorTick);
+	}
+}
+
+void UGSAbilitySystemComponent::OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World != GetWorld())
+	{
+		return;
+	}
+
+	if (World->GetTimeSeconds() - OldestBundledShotTime >= CVarShotBundleInterval.GetValueOnGameThread())
+	{
+		FlushTargetDataBundles();
+	}
+}
+
+void UGSAbilitySystemComponent::FlushTargetDataBundles()
+{
+	if (PendingTargetDataBundles.Num() == 0)
+	{
+		return;
+	}
+
+	FWorldDelegates::OnWorldPostActorTick.Remove(FlushTargetDataBundlesHandle);
+	FlushTargetDataBundlesHandle.Reset();
+
+	const float SendTimestamp = GetWorld() ? GetWorld()->GetTimeSeconds() : 0.0f;
+
+	// Sending can call back into us, so take the bundles first
+	TArray<FPendingTargetDataBundle> Bundles = MoveTemp(PendingTargetDataBundles);
+	PendingTargetDataBundles.Reset();
+
+	for (const FPendingTargetDataBundle& Bundle : Bundles)
+	{
+		if (Bundle.Shots.Num() == 1)
+		{
+			const FGSBundledTargetData& Shot = Bundle.Shots[0];
+			CallServerSetReplicatedTargetData(Bundle.AbilityHandle, Bundle.AbilityOriginalPredictionKey, Shot.TargetData, Shot.ApplicationTag, Shot.PredictionKey);
+		}
+		else if (Bundle.Shots.Num() > 1)
+		{
+			ServerSetReplicatedTargetDataBundle(Bundle.AbilityHandle, Bundle.AbilityOriginalPredictionKey, Bundle.Shots, SendTimestamp);
+		}
+
+		INC_DWORD_STAT(STAT_GSAbilitySystem_ShotBundlesSent);
+	}
+}
+
+bool UGSAbilitySystemComponent::ShouldBundleTargetData(FGameplayAbilitySpecHandle AbilityHandle) const
+{
+	if (CVarShotBundling.GetValueOnGameThread() == 0 || IsOwnerActorAuthoritative())
+	{
+		return false;
+	}
+
+	// The first shot rides along with the activation in the RPC batch
+	if (LocalServerAbilityRPCBatchData.ContainsByPredicate([&AbilityHandle](const FServerAbilityRPCBatch& Batch) { return Batch.AbilitySpecHandle == AbilityHandle; }))
+	{
+		return false;
+	}
+
+	const FGameplayAbilitySpec* Spec = FindAbilitySpecFromHandle(AbilityHandle);
+	const UGSGameplayAbility* Ability = Spec ? Cast<UGSGameplayAbility>(Spec->GetPrimaryInstance()) : nullptr;
+	if (!Ability)
+	{
+		return false;
+	}
+
+	const AGSWeapon* Weapon = Cast<AGSWeapon>(Spec->SourceObject);
+	return Ability->bBundleTargetData || (Weapon && Weapon->ShouldBundleTargetData());
+}
+
+void UGSAbilitySystemComponent::ServerSetReplicatedTargetDataBundle_Implementation(FGameplayAbilitySpecHandle AbilityHandle, FPredictionKey AbilityOriginalPredictionKey, const TArray<FGSBundledTargetData>& Shots, float SendTimestamp)
+{
+	// A client can't claim its shots are older than a bundle is allowed to be held
+	const float MaxShotAge = CVarShotBundleInterval.GetValueOnGameThread();
+
+	for (const FGSBundledTargetData& Shot : Shots)
+	{
+		CurrentBundledShotAge = FMath::Clamp(SendTimestamp - Shot.Timestamp, 0.0f, MaxShotAge);
+
+		// Runs locally on the server, each shot in its own prediction window like it was sent on its own
+		ServerSetReplicatedTargetData(AbilityHandle, AbilityOriginalPredictionKey, Shot.TargetData, Shot.ApplicationTag, Shot.PredictionKey);
+	}
+
+	CurrentBundledShotAge = 0.0f;
+}
+
+bool UGSAbilitySystemComponent::ServerSetReplicatedTargetDataBundle_Validate(FGameplayAbilitySpecHandle AbilityHandle, FPredictionKey AbilityOriginalPredictionKey, const TArray<FGSBundledTargetData>& Shots, float SendTimestamp)
+{
+	// Clients flush at GSMaxBundledShots, a bigger bundle didn't come from this code
+	return Shots.Num() <= GSMaxBundledShots;
+}
+
 void UGSAbilitySystemComponent::ExecuteGameplayCueLocal(const FGameplayTag GameplayCueTag, const FGameplayCueParameters& GameplayCueParameters)
 {
-	UAbilitySystemGlobals::Get().GetGameplayCueManager()->HandleGameplayCue(GetOwner(), GameplayCueTag, EGameplayCueEvent::Type::Executed, GameplayCueParameters);
+	UGSGameplayCueManager::HandleLocalGameplayCue(GetOwner(), GameplayCueTag, EGameplayCueEvent::Type::Executed, GameplayCueParameters);
 }
 
 void UGSAbilitySystemComponent::AddGameplayCueLocal(const FGameplayTag GameplayCueTag, const FGameplayCueParameters& GameplayCueParameters)
 {
-	UAbilitySystemGlobals::Get().GetGameplayCueManager()->HandleGameplayCue(GetOwner(), GameplayCueTag, EGameplayCueEvent::Type::OnActive, GameplayCueParameters);
-	UAbilitySystemGlobals::Get().GetGameplayCueManager()->HandleGameplayCue(GetOwner(), GameplayCueTag, EGameplayCueEvent::Type::WhileActive, GameplayCueParameters);
+	UGSGameplayCueManager::HandleLocalGameplayCue(GetOwner(), GameplayCueTag, EGameplayCueEvent::Type::OnActive, GameplayCueParameters);
+	UGSGameplayCueManager::HandleLocalGameplayCue(GetOwner(), GameplayCueTag, EGameplayCueEvent::Type::WhileActive, GameplayCueParameters);
 }
 
 void UGSAbilitySystemComponent::RemoveGameplayCueLocal(const FGameplayTag GameplayCueTag, const FGameplayCueParameters& GameplayCueParameters)
 {
-	UAbilitySystemGlobals::Get().GetGameplayCueManager()->HandleGameplayCue(GetOwner(), GameplayCueTag, EGameplayCueEvent::Type::Removed, GameplayCueParameters);
+	UGSGameplayCueManager::HandleLocalGameplayCue(GetOwner(), GameplayCueTag, EGameplayCueEvent::Type::Removed, GameplayCueParameters);
 }
 
 FString UGSAbilitySystemComponent::GetCurrentPredictionKeyStatus()
@@ -323,7 +648,7 @@ float UGSAbilitySystemComponent::PlayMontageForMesh(UGameplayAbility* InAnimatin
 					AbilityRepMontageInfo.RepMontageInfo.ForcePlayBit = !bool(AbilityRepMontageInfo.RepMontageInfo.ForcePlayBit);
 
 					// Update parameters that change during Montage life time.
-					AnimMontage_UpdateReplicatedDataForMesh(InMesh);
+					AnimMontage_UpdateReplicatedDataForMesh(AbilityRepMontageInfo, true);
 
 					// Force net update on our avatar actor
 					if (AbilityActorInfo->AvatarActor != nullptr)
@@ -477,7 +802,7 @@ void UGSAbilitySystemComponent::CurrentMontageSetPlayRateForMesh(USkeletalMeshCo
 
 bool UGSAbilitySystemComponent::IsAnimatingAbilityForAnyMesh(UGameplayAbility* InAbility) const
 {
-	for (FGameplayAbilityLocalAnimMontageForMesh GameplayAbilityLocalAnimMontageForMesh : LocalAnimMontageInfoForMeshes)
+	for (const FGameplayAbilityLocalAnimMontageForMesh& GameplayAbilityLocalAnimMontageForMesh : LocalAnimMontageInfoForMeshes)
 	{
 		if (GameplayAbilityLocalAnimMontageForMesh.LocalMontageInfo.AnimatingAbility == InAbility)
 		{
@@ -506,7 +831,7 @@ TArray<UAnimMontage*> UGSAbilitySystemComponent::GetCurrentMontages() const
 {
 	TArray<UAnimMontage*> Montages;
 
-	for (FGameplayAbilityLocalAnimMontageForMesh GameplayAbilityLocalAnimMontageForMesh : LocalAnimMontageInfoForMeshes)
+	for (const FGameplayAbilityLocalAnimMontageForMesh& GameplayAbilityLocalAnimMontageForMesh : LocalAnimMontageInfoForMeshes)
 	{
 		UAnimInstance* AnimInstance = IsValid(GameplayAbilityLocalAnimMontageForMesh.Mesh) 
 			&& GameplayAbilityLocalAnimMontageForMesh.Mesh->GetOwner() == AbilityActorInfo->AvatarActor ? GameplayAbilityLocalAnimMontageForMesh.Mesh->GetAnimInstance() : nullptr;
@@ -612,32 +937,138 @@ float UGSAbilitySystemComponent::GetCurrentMontageSectionTimeLeftForMesh(USkelet
 
 FGameplayAbilityLocalAnimMontageForMesh& UGSAbilitySystemComponent::GetLocalAnimMontageInfoForMesh(USkeletalMeshComponent* InMesh)
 {
-	for (FGameplayAbilityLocalAnimMontageForMesh& MontageInfo : LocalAnimMontageInfoForMeshes)
+	if (const int32* Slot = LocalAnimMontageSlotByMesh.Find(InMesh))
 	{
-		if (MontageInfo.Mesh == InMesh)
-		{
-			return MontageInfo;
-		}
+		return LocalAnimMontageInfoForMeshes[*Slot];
 	}
 
-	FGameplayAbilityLocalAnimMontageForMesh MontageInfo = FGameplayAbilityLocalAnimMontageForMesh(InMesh);
-	LocalAnimMontageInfoForMeshes.Add(MontageInfo);
-	return LocalAnimMontageInfoForMeshes.Last();
+	const int32 Slot = LocalAnimMontageInfoForMeshes.Add(FGameplayAbilityLocalAnimMontageForMesh(InMesh));
+	LocalAnimMontageSlotByMesh.Add(InMesh, Slot);
+	return LocalAnimMontageInfoForMeshes[Slot];
 }
 
 FGameplayAbilityRepAnimMontageForMesh& UGSAbilitySystemComponent::GetGameplayAbilityRepAnimMontageForMesh(USkeletalMeshComponent* InMesh)
 {
-	for (FGameplayAbilityRepAnimMontageForMesh& RepMontageInfo : RepAnimMontageInfoForMeshes)
+	if (const int32* Slot = RepAnimMontageSlotByMesh.Find(InMesh))
+	{
+		return RepAnimMontageInfoForMeshes.Items[*Slot];
+	}
+
+	const int32 Slot = RepAnimMontageInfoForMeshes.Items.Add(FGameplayAbilityRepAnimMontageForMesh(InMesh));
+	RepAnimMontageSlotByMesh.Add(InMesh, Slot);
+
+	FGameplayAbilityRepAnimMontageForMesh& RepMontageInfo = RepAnimMontageInfoForMeshes.Items[Slot];
+	RepAnimMontageInfoForMeshes.MarkItemDirty(RepMontageInfo);
+	return RepMontageInfo;
+}
+
+void UGSAbilitySystemComponent::RefreshMontageMeshSlots()
+{
+	AActor* AvatarActor = AbilityActorInfo.IsValid() ? AbilityActorInfo->AvatarActor.Get() : nullptr;
+	if (!AvatarActor)
+	{
+		return;
+	}
+
+	TInlineComponentArray<USkeletalMeshComponent*> Meshes(AvatarActor);
+	for (USkeletalMeshComponent* Mesh : Meshes)
+	{
+		GetLocalAnimMontageInfoForMesh(Mesh);
+	}
+}
+
+void UGSAbilitySystemComponent::RunMontageLookupBenchmark(int32 Iterations)
+{
+	RefreshMontageMeshSlots();
+
+	TArray<USkeletalMeshComponent*> Meshes;
+	for (const FGameplayAbilityLocalAnimMontageForMesh& MontageInfo : LocalAnimMontageInfoForMeshes)
+	{
+		Meshes.Add(MontageInfo.Mesh);
+	}
+
+	if (Meshes.Num() == 0)
+	{
+		UE_LOG(LogGASShooterALS, Warning, TEXT("%s %s has no skeletal meshes"), *FString(__FUNCTION__), *GetNameSafe(GetAvatarActor()));
+		return;
+	}
+
+	// Only the authority keeps replicated montage data per mesh
+	const bool bLookupRep = IsOwnerActorAuthoritative();
+	if (bLookupRep)
+	{
+		for (USkeletalMeshComponent* Mesh : Meshes)
+		{
+			GetGameplayAbilityRepAnimMontageForMesh(Mesh);
+		}
+	}
+
+	const int32 NumLookups = Iterations * Meshes.Num();
+
+	// Keeps the compiler from dropping the lookups
+	UPTRINT Sink = 0;
+
+	// What GetLocalAnimMontageInfoForMesh() and GetGameplayAbilityRepAnimMontageForMesh() used to do
+	const uint64 ScanStartCycles = FPlatformTime::Cycles64();
+	for (int32 Iteration = 0; Iteration < Iterations; Iteration++)
+	{
+		for (USkeletalMeshComponent* Mesh : Meshes)
+		{
+			for (FGameplayAbilityLocalAnimMontageForMesh& MontageInfo : LocalAnimMontageInfoForMeshes)
+			{
+				if (MontageInfo.Mesh == Mesh)
+				{
+					Sink += (UPTRINT)&MontageInfo;
+					break;
+				}
+			}
+
+			if (bLookupRep)
+			{
+				for (FGameplayAbilityRepAnimMontageForMesh& RepMontageInfo : RepAnimMontageInfoForMeshes.Items)
+				{
+					if (RepMontageInfo.Mesh == Mesh)
+					{
+						Sink += (UPTRINT)&RepMontageInfo;
+						break;
+					}
+				}
+			}
+		}
+	}
+	const uint64 ScanEndCycles = FPlatformTime::Cycles64();
+
+	for (int32 Iteration = 0; Iteration < Iterations; Iteration++)
 	{
-		if (RepMontageInfo.Mesh == InMesh)
+		for (USkeletalMeshComponent* Mesh : Meshes)
 		{
-			return RepMontageInfo;
+			Sink += (UPTRINT)&GetLocalAnimMontageInfoForMesh(Mesh);
+
+			if (bLookupRep)
+			{
+				Sink += (UPTRINT)&GetGameplayAbilityRepAnimMontageForMesh(Mesh);
+			}
 		}
 	}
+	const uint64 IndexEndCycles = FPlatformTime::Cycles64();
 
-	FGameplayAbilityRepAnimMontageForMesh RepMontageInfo = FGameplayAbilityRepAnimMontageForMesh(InMesh);
-	RepAnimMontageInfoForMeshes.Add(RepMontageInfo);
-	return RepAnimMontageInfoForMeshes.Last();
+	for (int32 Iteration = 0; Iteration < Iterations; Iteration++)
+	{
+		for (USkeletalMeshComponent* Mesh : Meshes)
+		{
+			Sink += (UPTRINT)GetCurrentMontageForMesh(Mesh);
+			Sink += GetCurrentMontageSectionIDForMesh(Mesh);
+		}
+	}
+	const uint64 ApiEndCycles = FPlatformTime::Cycles64();
+
+	const double NanosecondsPerLookup = 1000000.0 / NumLookups;
+	UE_LOG(LogGASShooterALS, Log, TEXT("GS.Montage.LookupBenchmark: %d meshes%s, %d iterations. Linear scan %.1f ns, slot index %.1f ns, GetCurrentMontageForMesh + GetCurrentMontageSectionIDForMesh %.1f ns per mesh (%llu)"),
+		Meshes.Num(), bLookupRep ? TEXT(" with replicated data") : TEXT(""), Iterations,
+		FPlatformTime::ToMilliseconds64(ScanEndCycles - ScanStartCycles) * NanosecondsPerLookup,
+		FPlatformTime::ToMilliseconds64(IndexEndCycles - ScanEndCycles) * NanosecondsPerLookup,
+		FPlatformTime::ToMilliseconds64(ApiEndCycles - IndexEndCycles) * NanosecondsPerLookup,
+		(uint64)(Sink & 1));
 }
 
 void UGSAbilitySystemComponent::OnPredictiveMontageRejectedForMesh(USkeletalMeshComponent* InMesh, UAnimMontage* PredictiveMontage)
@@ -662,30 +1093,58 @@ void UGSAbilitySystemComponent::AnimMontage_UpdateReplicatedDataForMesh(USkeleta
 	AnimMontage_UpdateReplicatedDataForMesh(GetGameplayAbilityRepAnimMontageForMesh(InMesh));
 }
 
-void UGSAbilitySystemComponent::AnimMontage_UpdateReplicatedDataForMesh(FGameplayAbilityRepAnimMontageForMesh& OutRepAnimMontageInfo)
+void UGSAbilitySystemComponent::AnimMontage_UpdateReplicatedDataForMesh(FGameplayAbilityRepAnimMontageForMesh& OutRepAnimMontageInfo, bool bForceDirty)
 {
+	INC_DWORD_STAT(STAT_GSAbilitySystem_MontageRepUpdates);
+
 	UAnimInstance* AnimInstance = IsValid(OutRepAnimMontageInfo.Mesh) && OutRepAnimMontageInfo.Mesh->GetOwner() 
 		== AbilityActorInfo->AvatarActor ? OutRepAnimMontageInfo.Mesh->GetAnimInstance() : nullptr;
 	FGameplayAbilityLocalAnimMontageForMesh& AnimMontageInfo = GetLocalAnimMontageInfoForMesh(OutRepAnimMontageInfo.Mesh);
 
 	if (AnimInstance && AnimMontageInfo.LocalMontageInfo.AnimMontage)
 	{
-		OutRepAnimMontageInfo.RepMontageInfo.AnimMontage = AnimMontageInfo.LocalMontageInfo.AnimMontage;
+		FGameplayAbilityRepAnimMontage& RepMontageInfo = OutRepAnimMontageInfo.RepMontageInfo;
+		bool bDirty = bForceDirty;
+
+		if (RepMontageInfo.AnimMontage != AnimMontageInfo.LocalMontageInfo.AnimMontage)
+		{
+			RepMontageInfo.AnimMontage = AnimMontageInfo.LocalMontageInfo.AnimMontage;
+			bDirty = true;
+		}
 
 		// Compressed Flags
 		bool bIsStopped = AnimInstance->Montage_GetIsStopped(AnimMontageInfo.LocalMontageInfo.AnimMontage);
 
+		const float WorldTime = GetWorld()->GetTimeSeconds();
+
 		if (!bIsStopped)
 		{
-			OutRepAnimMontageInfo.RepMontageInfo.PlayRate = AnimInstance->Montage_GetPlayRate(AnimMontageInfo.LocalMontageInfo.AnimMontage);
-			OutRepAnimMontageInfo.RepMontageInfo.Position = AnimInstance->Montage_GetPosition(AnimMontageInfo.LocalMontageInfo.AnimMontage);
-			OutRepAnimMontageInfo.RepMontageInfo.BlendTime = AnimInstance->Montage_GetBlendTime(AnimMontageInfo.LocalMontageInfo.AnimMontage);
+			const float PlayRate = AnimInstance->Montage_GetPlayRate(AnimMontageInfo.LocalMontageInfo.AnimMontage);
+			const float Position = AnimInstance->Montage_GetPosition(AnimMontageInfo.LocalMontageInfo.AnimMontage);
+
+			if (RepMontageInfo.PlayRate != PlayRate)
+			{
+				RepMontageInfo.PlayRate = PlayRate;
+				bDirty = true;
+			}
+
+			// Clients keep playing the montage on their own, only correct them once they'd be noticeably off
+			const float ExpectedPosition = RepMontageInfo.Position + (WorldTime - OutRepAnimMontageInfo.RepPositionTime) * RepMontageInfo.PlayRate;
+			if (bDirty || FMath::Abs(Position - ExpectedPosition) > CVarMontageRepPositionDriftThreshold.GetValueOnGameThread())
+			{
+				RepMontageInfo.Position = Position;
+				OutRepAnimMontageInfo.RepPositionTime = WorldTime;
+				bDirty = true;
+			}
+
+			RepMontageInfo.BlendTime = AnimInstance->Montage_GetBlendTime(AnimMontageInfo.LocalMontageInfo.AnimMontage);
 		}
 
-		if (OutRepAnimMontageInfo.RepMontageInfo.IsStopped != bIsStopped)
+		if (RepMontageInfo.IsStopped != bIsStopped)
 		{
 			// Set this prior to calling UpdateShouldTick, so we start ticking if we are playing a Montage
-			OutRepAnimMontageInfo.RepMontageInfo.IsStopped = bIsStopped;
+			RepMontageInfo.IsStopped = bIsStopped;
+			bDirty = true;
 
 			// When we start or stop an animation, update the clients right away for the Avatar Actor
 			if (AbilityActorInfo->AvatarActor != nullptr)
@@ -699,21 +1158,30 @@ void UGSAbilitySystemComponent::AnimMontage_UpdateReplicatedDataForMesh(FGamepla
 
 		// Replicate NextSectionID to keep it in sync.
 		// We actually replicate NextSectionID+1 on a BYTE to put INDEX_NONE in there.
-		int32 CurrentSectionID = AnimMontageInfo.LocalMontageInfo.AnimMontage->GetSectionIndexFromPosition(OutRepAnimMontageInfo.RepMontageInfo.Position);
+		uint8 RepNextSectionID = 0;
+		int32 CurrentSectionID = AnimMontageInfo.LocalMontageInfo.AnimMontage->GetSectionIndexFromPosition(RepMontageInfo.Position);
 		if (CurrentSectionID != INDEX_NONE)
 		{
 			int32 NextSectionID = AnimInstance->Montage_GetNextSectionID(AnimMontageInfo.LocalMontageInfo.AnimMontage, CurrentSectionID);
 			if (NextSectionID >= (256 - 1))
 			{
 				ABILITY_LOG(Error, TEXT("AnimMontage_UpdateReplicatedData. NextSectionID = %d.  RepAnimMontageInfo.Position: %.2f, CurrentSectionID: %d. LocalAnimMontageInfo.AnimMontage %s"),
-					NextSectionID, OutRepAnimMontageInfo.RepMontageInfo.Position, CurrentSectionID, *GetNameSafe(AnimMontageInfo.LocalMontageInfo.AnimMontage));
+					NextSectionID, RepMontageInfo.Position, CurrentSectionID, *GetNameSafe(AnimMontageInfo.LocalMontageInfo.AnimMontage));
 				ensure(NextSectionID < (256 - 1));
 			}
-			OutRepAnimMontageInfo.RepMontageInfo.NextSectionID = uint8(NextSectionID + 1);
+			RepNextSectionID = uint8(NextSectionID + 1);
 		}
-		else
+
+		if (RepMontageInfo.NextSectionID != RepNextSectionID)
 		{
-			OutRepAnimMontageInfo.RepMontageInfo.NextSectionID = 0;
+			RepMontageInfo.NextSectionID = RepNextSectionID;
+			bDirty = true;
+		}
+
+		if (bDirty)
+		{
+			INC_DWORD_STAT(STAT_GSAbilitySystem_MontageRepDirty);
+			RepAnimMontageInfoForMeshes.MarkItemDirty(OutRepAnimMontageInfo);
 		}
 	}
 }
@@ -727,133 +1195,143 @@ void UGSAbilitySystemComponent::AnimMontage_UpdateForcedPlayFlagsForMesh(FGamepl
 
 void UGSAbilitySystemComponent::OnRep_ReplicatedAnimMontageForMesh()
 {
-	for (FGameplayAbilityRepAnimMontageForMesh& NewRepMontageInfoForMesh : RepAnimMontageInfoForMeshes)
+	for (FGameplayAbilityRepAnimMontageForMesh& NewRepMontageInfoForMesh : RepAnimMontageInfoForMeshes.Items)
 	{
-		FGameplayAbilityLocalAnimMontageForMesh& AnimMontageInfo = GetLocalAnimMontageInfoForMesh(NewRepMontageInfoForMesh.Mesh);
-
-		UWorld* World = GetWorld();
+		OnRep_ReplicatedAnimMontageForMesh(NewRepMontageInfoForMesh);
 
-		if (NewRepMontageInfoForMesh.RepMontageInfo.bSkipPlayRate)
+		if (bPendingMontageRep)
 		{
-			NewRepMontageInfoForMesh.RepMontageInfo.PlayRate = 1.f;
+			return;
 		}
+	}
+}
+
+void UGSAbilitySystemComponent::OnRep_ReplicatedAnimMontageForMesh(FGameplayAbilityRepAnimMontageForMesh& NewRepMontageInfoForMesh)
+{
+	FGameplayAbilityLocalAnimMontageForMesh& AnimMontageInfo = GetLocalAnimMontageInfoForMesh(NewRepMontageInfoForMesh.Mesh);
+
+	UWorld* World = GetWorld();
+
+	if (NewRepMontageInfoForMesh.RepMontageInfo.bSkipPlayRate)
+	{
+		NewRepMontageInfoForMesh.RepMontageInfo.PlayRate = 1.f;
+	}
 
-		const bool bIsPlayingReplay = World && World->IsPlayingReplay();
+	const bool bIsPlayingReplay = World && World->IsPlayingReplay();
 
-		const float MONTAGE_REP_POS_ERR_THRESH = bIsPlayingReplay ? CVarReplayMontageErrorThreshold.GetValueOnGameThread() : 0.1f;
+	const float MONTAGE_REP_POS_ERR_THRESH = bIsPlayingReplay ? CVarReplayMontageErrorThreshold.GetValueOnGameThread() : 0.1f;
+
+	UAnimInstance* AnimInstance = IsValid(NewRepMontageInfoForMesh.Mesh) && NewRepMontageInfoForMesh.Mesh->GetOwner()
+		== AbilityActorInfo->AvatarActor ? NewRepMontageInfoForMesh.Mesh->GetAnimInstance() : nullptr;
+	if (AnimInstance == nullptr || !IsReadyForReplicatedMontageForMesh())
+	{
+		// We can't handle this yet
+		bPendingMontageRep = true;
+		return;
+	}
+	bPendingMontageRep = false;
 
-		UAnimInstance* AnimInstance = IsValid(NewRepMontageInfoForMesh.Mesh) && NewRepMontageInfoForMesh.Mesh->GetOwner()
-			== AbilityActorInfo->AvatarActor ? NewRepMontageInfoForMesh.Mesh->GetAnimInstance() : nullptr;
-		if (AnimInstance == nullptr || !IsReadyForReplicatedMontageForMesh())
+	if (!AbilityActorInfo->IsLocallyControlled())
+	{
+		static const auto CVar = IConsoleManager::Get().FindTConsoleVariableDataInt(TEXT("net.Montage.Debug"));
+		bool DebugMontage = (CVar && CVar->GetValueOnGameThread() == 1);
+		if (DebugMontage)
 		{
-			// We can't handle this yet
-			bPendingMontageRep = true;
-			return;
+			ABILITY_LOG(Warning, TEXT("\n\nOnRep_ReplicatedAnimMontage, %s"), *GetNameSafe(this));
+			ABILITY_LOG(Warning, TEXT("\tAnimMontage: %s\n\tPlayRate: %f\n\tPosition: %f\n\tBlendTime: %f\n\tNextSectionID: %d\n\tIsStopped: %d\n\tForcePlayBit: %d"),
+				*GetNameSafe(NewRepMontageInfoForMesh.RepMontageInfo.AnimMontage),
+				NewRepMontageInfoForMesh.RepMontageInfo.PlayRate,
+				NewRepMontageInfoForMesh.RepMontageInfo.Position,
+				NewRepMontageInfoForMesh.RepMontageInfo.BlendTime,
+				NewRepMontageInfoForMesh.RepMontageInfo.NextSectionID,
+				NewRepMontageInfoForMesh.RepMontageInfo.IsStopped,
+				NewRepMontageInfoForMesh.RepMontageInfo.ForcePlayBit);
+			ABILITY_LOG(Warning, TEXT("\tLocalAnimMontageInfo.AnimMontage: %s\n\tPosition: %f"),
+				*GetNameSafe(AnimMontageInfo.LocalMontageInfo.AnimMontage), AnimInstance->Montage_GetPosition(AnimMontageInfo.LocalMontageInfo.AnimMontage));
 		}
-		bPendingMontageRep = false;
 
-		if (!AbilityActorInfo->IsLocallyControlled())
+		if (NewRepMontageInfoForMesh.RepMontageInfo.AnimMontage)
 		{
-			static const auto CVar = IConsoleManager::Get().FindTConsoleVariableDataInt(TEXT("net.Montage.Debug"));
-			bool DebugMontage = (CVar && CVar->GetValueOnGameThread() == 1);
-			if (DebugMontage)
+			// New Montage to play
+			const bool ReplicatedPlayBit = bool(NewRepMontageInfoForMesh.RepMontageInfo.ForcePlayBit);
+			if ((AnimMontageInfo.LocalMontageInfo.AnimMontage != NewRepMontageInfoForMesh.RepMontageInfo.AnimMontage) || (AnimMontageInfo.LocalMontageInfo.PlayBit != ReplicatedPlayBit))
 			{
-				ABILITY_LOG(Warning, TEXT("\n\nOnRep_ReplicatedAnimMontage, %s"), *GetNameSafe(this));
-				ABILITY_LOG(Warning, TEXT("\tAnimMontage: %s\n\tPlayRate: %f\n\tPosition: %f\n\tBlendTime: %f\n\tNextSectionID: %d\n\tIsStopped: %d\n\tForcePlayBit: %d"),
-					*GetNameSafe(NewRepMontageInfoForMesh.RepMontageInfo.AnimMontage),
-					NewRepMontageInfoForMesh.RepMontageInfo.PlayRate,
-					NewRepMontageInfoForMesh.RepMontageInfo.Position,
-					NewRepMontageInfoForMesh.RepMontageInfo.BlendTime,
-					NewRepMontageInfoForMesh.RepMontageInfo.NextSectionID,
-					NewRepMontageInfoForMesh.RepMontageInfo.IsStopped,
-					NewRepMontageInfoForMesh.RepMontageInfo.ForcePlayBit);
-				ABILITY_LOG(Warning, TEXT("\tLocalAnimMontageInfo.AnimMontage: %s\n\tPosition: %f"),
-					*GetNameSafe(AnimMontageInfo.LocalMontageInfo.AnimMontage), AnimInstance->Montage_GetPosition(AnimMontageInfo.LocalMontageInfo.AnimMontage));
+				AnimMontageInfo.LocalMontageInfo.PlayBit = ReplicatedPlayBit;
+				PlayMontageSimulatedForMesh(NewRepMontageInfoForMesh.Mesh, NewRepMontageInfoForMesh.RepMontageInfo.AnimMontage, NewRepMontageInfoForMesh.RepMontageInfo.PlayRate);
 			}
 
-			if (NewRepMontageInfoForMesh.RepMontageInfo.AnimMontage)
+			if (AnimMontageInfo.LocalMontageInfo.AnimMontage == nullptr)
 			{
-				// New Montage to play
-				const bool ReplicatedPlayBit = bool(NewRepMontageInfoForMesh.RepMontageInfo.ForcePlayBit);
-				if ((AnimMontageInfo.LocalMontageInfo.AnimMontage != NewRepMontageInfoForMesh.RepMontageInfo.AnimMontage) || (AnimMontageInfo.LocalMontageInfo.PlayBit != ReplicatedPlayBit))
-				{
-					AnimMontageInfo.LocalMontageInfo.PlayBit = ReplicatedPlayBit;
-					PlayMontageSimulatedForMesh(NewRepMontageInfoForMesh.Mesh, NewRepMontageInfoForMesh.RepMontageInfo.AnimMontage, NewRepMontageInfoForMesh.RepMontageInfo.PlayRate);
-				}
+				ABILITY_LOG(Warning, TEXT("OnRep_ReplicatedAnimMontage: PlayMontageSimulated failed. Name: %s, AnimMontage: %s"), *GetNameSafe(this), *GetNameSafe(NewRepMontageInfoForMesh.RepMontageInfo.AnimMontage));
+				return;
+			}
 
-				if (AnimMontageInfo.LocalMontageInfo.AnimMontage == nullptr)
-				{
-					ABILITY_LOG(Warning, TEXT("OnRep_ReplicatedAnimMontage: PlayMontageSimulated failed. Name: %s, AnimMontage: %s"), *GetNameSafe(this), *GetNameSafe(NewRepMontageInfoForMesh.RepMontageInfo.AnimMontage));
-					return;
-				}
+			// Play Rate has changed
+			if (AnimInstance->Montage_GetPlayRate(AnimMontageInfo.LocalMontageInfo.AnimMontage) != NewRepMontageInfoForMesh.RepMontageInfo.PlayRate)
+			{
+				AnimInstance->Montage_SetPlayRate(AnimMontageInfo.LocalMontageInfo.AnimMontage, NewRepMontageInfoForMesh.RepMontageInfo.PlayRate);
+			}
+
+			// Compressed Flags
+			const bool bIsStopped = AnimInstance->Montage_GetIsStopped(AnimMontageInfo.LocalMontageInfo.AnimMontage);
+			const bool bReplicatedIsStopped = bool(NewRepMontageInfoForMesh.RepMontageInfo.IsStopped);
 
-				// Play Rate has changed
-				if (AnimInstance->Montage_GetPlayRate(AnimMontageInfo.LocalMontageInfo.AnimMontage) != NewRepMontageInfoForMesh.RepMontageInfo.PlayRate)
+			// Process stopping first, so we don't change sections and cause blending to pop.
+			if (bReplicatedIsStopped)
+			{
+				if (!bIsStopped)
 				{
-					AnimInstance->Montage_SetPlayRate(AnimMontageInfo.LocalMontageInfo.AnimMontage, NewRepMontageInfoForMesh.RepMontageInfo.PlayRate);
+					CurrentMontageStopForMesh(NewRepMontageInfoForMesh.Mesh, NewRepMontageInfoForMesh.RepMontageInfo.BlendTime);
 				}
+			}
+			else if (!NewRepMontageInfoForMesh.RepMontageInfo.SkipPositionCorrection)
+			{
+				const int32 RepSectionID = AnimMontageInfo.LocalMontageInfo.AnimMontage->GetSectionIndexFromPosition(NewRepMontageInfoForMesh.RepMontageInfo.Position);
+				const int32 RepNextSectionID = int32(NewRepMontageInfoForMesh.RepMontageInfo.NextSectionID) - 1;
 
-				// Compressed Flags
-				const bool bIsStopped = AnimInstance->Montage_GetIsStopped(AnimMontageInfo.LocalMontageInfo.AnimMontage);
-				const bool bReplicatedIsStopped = bool(NewRepMontageInfoForMesh.RepMontageInfo.IsStopped);
-
-				// Process stopping first, so we don't change sections and cause blending to pop.
-				if (bReplicatedIsStopped)
+				// And NextSectionID for the replicated SectionID.
+				if (RepSectionID != INDEX_NONE)
 				{
-					if (!bIsStopped)
+					const int32 NextSectionID = AnimInstance->Montage_GetNextSectionID(AnimMontageInfo.LocalMontageInfo.AnimMontage, RepSectionID);
+
+					// If NextSectionID is different than the replicated one, then set it.
+					if (NextSectionID != RepNextSectionID)
 					{
-						CurrentMontageStopForMesh(NewRepMontageInfoForMesh.Mesh, NewRepMontageInfoForMesh.RepMontageInfo.BlendTime);
+						AnimInstance->Montage_SetNextSection(AnimMontageInfo.LocalMontageInfo.AnimMontage->GetSectionName(RepSectionID), AnimMontageInfo.LocalMontageInfo.AnimMontage->GetSectionName(RepNextSectionID), AnimMontageInfo.LocalMontageInfo.AnimMontage);
 					}
-				}
-				else if (!NewRepMontageInfoForMesh.RepMontageInfo.SkipPositionCorrection)
-				{
-					const int32 RepSectionID = AnimMontageInfo.LocalMontageInfo.AnimMontage->GetSectionIndexFromPosition(NewRepMontageInfoForMesh.RepMontageInfo.Position);
-					const int32 RepNextSectionID = int32(NewRepMontageInfoForMesh.RepMontageInfo.NextSectionID) - 1;
 
-					// And NextSectionID for the replicated SectionID.
-					if (RepSectionID != INDEX_NONE)
+					// Make sure we haven't received that update too late and the client hasn't already jumped to another section. 
+					const int32 CurrentSectionID = AnimMontageInfo.LocalMontageInfo.AnimMontage->GetSectionIndexFromPosition(AnimInstance->Montage_GetPosition(AnimMontageInfo.LocalMontageInfo.AnimMontage));
+					if ((CurrentSectionID != RepSectionID) && (CurrentSectionID != RepNextSectionID))
 					{
-						const int32 NextSectionID = AnimInstance->Montage_GetNextSectionID(AnimMontageInfo.LocalMontageInfo.AnimMontage, RepSectionID);
-
-						// If NextSectionID is different than the replicated one, then set it.
-						if (NextSectionID != RepNextSectionID)
-						{
-							AnimInstance->Montage_SetNextSection(AnimMontageInfo.LocalMontageInfo.AnimMontage->GetSectionName(RepSectionID), AnimMontageInfo.LocalMontageInfo.AnimMontage->GetSectionName(RepNextSectionID), AnimMontageInfo.LocalMontageInfo.AnimMontage);
-						}
-
-						// Make sure we haven't received that update too late and the client hasn't already jumped to another section. 
-						const int32 CurrentSectionID = AnimMontageInfo.LocalMontageInfo.AnimMontage->GetSectionIndexFromPosition(AnimInstance->Montage_GetPosition(AnimMontageInfo.LocalMontageInfo.AnimMontage));
-						if ((CurrentSectionID != RepSectionID) && (CurrentSectionID != RepNextSectionID))
-						{
-							// Client is in a wrong section, teleport him into the begining of the right section
-							const float SectionStartTime = AnimMontageInfo.LocalMontageInfo.AnimMontage->GetAnimCompositeSection(RepSectionID).GetTime();
-							AnimInstance->Montage_SetPosition(AnimMontageInfo.LocalMontageInfo.AnimMontage, SectionStartTime);
-						}
+						// Client is in a wrong section, teleport him into the begining of the right section
+						const float SectionStartTime = AnimMontageInfo.LocalMontageInfo.AnimMontage->GetAnimCompositeSection(RepSectionID).GetTime();
+						AnimInstance->Montage_SetPosition(AnimMontageInfo.LocalMontageInfo.AnimMontage, SectionStartTime);
 					}
+				}
 
-					// Update Position. If error is too great, jump to replicated position.
-					const float CurrentPosition = AnimInstance->Montage_GetPosition(AnimMontageInfo.LocalMontageInfo.AnimMontage);
-					const int32 CurrentSectionID = AnimMontageInfo.LocalMontageInfo.AnimMontage->GetSectionIndexFromPosition(CurrentPosition);
-					const float DeltaPosition = NewRepMontageInfoForMesh.RepMontageInfo.Position - CurrentPosition;
+				// Update Position. If error is too great, jump to replicated position.
+				const float CurrentPosition = AnimInstance->Montage_GetPosition(AnimMontageInfo.LocalMontageInfo.AnimMontage);
+				const int32 CurrentSectionID = AnimMontageInfo.LocalMontageInfo.AnimMontage->GetSectionIndexFromPosition(CurrentPosition);
+				const float DeltaPosition = NewRepMontageInfoForMesh.RepMontageInfo.Position - CurrentPosition;
 
-					// Only check threshold if we are located in the same section. Different sections require a bit more work as we could be jumping around the timeline.
-					// And therefore DeltaPosition is not as trivial to determine.
-					if ((CurrentSectionID == RepSectionID) && (FMath::Abs(DeltaPosition) > MONTAGE_REP_POS_ERR_THRESH) && (NewRepMontageInfoForMesh.RepMontageInfo.IsStopped == 0))
+				// Only check threshold if we are located in the same section. Different sections require a bit more work as we could be jumping around the timeline.
+				// And therefore DeltaPosition is not as trivial to determine.
+				if ((CurrentSectionID == RepSectionID) && (FMath::Abs(DeltaPosition) > MONTAGE_REP_POS_ERR_THRESH) && (NewRepMontageInfoForMesh.RepMontageInfo.IsStopped == 0))
+				{
+					// fast forward to server position and trigger notifies
+					if (FAnimMontageInstance* MontageInstance = AnimInstance->GetActiveInstanceForMontage(NewRepMontageInfoForMesh.RepMontageInfo.AnimMontage))
 					{
-						// fast forward to server position and trigger notifies
-						if (FAnimMontageInstance* MontageInstance = AnimInstance->GetActiveInstanceForMontage(NewRepMontageInfoForMesh.RepMontageInfo.AnimMontage))
+						// Skip triggering notifies if we're going backwards in time, we've already triggered them.
+						const float DeltaTime = !FMath::IsNearlyZero(NewRepMontageInfoForMesh.RepMontageInfo.PlayRate) ? (DeltaPosition / NewRepMontageInfoForMesh.RepMontageInfo.PlayRate) : 0.f;
+						if (DeltaTime >= 0.f)
 						{
-							// Skip triggering notifies if we're going backwards in time, we've already triggered them.
-							const float DeltaTime = !FMath::IsNearlyZero(NewRepMontageInfoForMesh.RepMontageInfo.PlayRate) ? (DeltaPosition / NewRepMontageInfoForMesh.RepMontageInfo.PlayRate) : 0.f;
-							if (DeltaTime >= 0.f)
-							{
-								MontageInstance->UpdateWeight(DeltaTime);
-								MontageInstance->HandleEvents(CurrentPosition, NewRepMontageInfoForMesh.RepMontageInfo.Position, nullptr);
-								AnimInstance->TriggerAnimNotifies(DeltaTime);
-							}
+							MontageInstance->UpdateWeight(DeltaTime);
+							MontageInstance->HandleEvents(CurrentPosition, NewRepMontageInfoForMesh.RepMontageInfo.Position, nullptr);
+							AnimInstance->TriggerAnimNotifies(DeltaTime);
 						}
-						AnimInstance->Montage_SetPosition(AnimMontageInfo.LocalMontageInfo.AnimMontage, NewRepMontageInfoForMesh.RepMontageInfo.Position);
 					}
+					AnimInstance->Montage_SetPosition(AnimMontageInfo.LocalMontageInfo.AnimMontage, NewRepMontageInfoForMesh.RepMontageInfo.Position);
 				}
 			}
 		}
@@ -2,11 +2,95 @@
 
 
 #include "Characters/Abilities/GSAbilitySystemGlobals.h"
+#include "AbilitySystemComponent.h"
+#include "Characters/Abilities/AttributeSets/GSAmmoAttributeSet.h"
+#include "Characters/Abilities/AttributeSets/GSAttributeSetBase.h"
 #include "Characters/Abilities/GSGameplayEffectTypes.h"
+#include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameplayEffect.h"
+#include "GASShooterALS/GASShooterALS.h"
+#include "HAL/IConsoleManager.h"
+#include "Player/GSPlayerState.h"
+#include "UObject/UObjectArray.h"
+
+static FAutoConsoleCommandWithWorldAndArgs CmdEffectsBenchmark(
+	TEXT("GS.Effects.Benchmark"),
+	TEXT("Applies a kill's worth of bounty and ammo refill effects to the first player's ASC [Count] times, once through transient effects built with NewObject like before and once through the shared SetByCaller effects. Logs the time and UObjects created by each. Magnitudes are 0 so no attributes change."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		AGameStateBase* GameState = World && World->GetNetMode() != NM_Client ? World->GetGameState() : nullptr;
+		UAbilitySystemComponent* ASC = nullptr;
+		if (GameState)
+		{
+			for (APlayerState* PlayerState : GameState->PlayerArray)
+			{
+				if (AGSPlayerState* PS = Cast<AGSPlayerState>(PlayerState))
+				{
+					ASC = PS->GetAbilitySystemComponent();
+					break;
+				}
+			}
+		}
+
+		if (!ASC)
+		{
+			UE_LOG(LogGASShooterALS, Warning, TEXT("GS.Effects.Benchmark: run on the server with at least one player"));
+			return;
+		}
+
+		const int32 Count = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 1000;
+		UGSAbilitySystemGlobals& Globals = UGSAbilitySystemGlobals::GSGet();
+		const FGameplayTag RifleAmmoTag = FGameplayTag::RequestGameplayTag(FName("Weapon.Ammo.Rifle"));
+
+		const int32 TransientStartObjects = GUObjectArray.GetObjectArrayNumMinusAvailable();
+		const uint64 TransientStartCycles = FPlatformTime::Cycles64();
+		for (int32 i = 0; i < Count; i++)
+		{
+			UGameplayEffect* GEBounty = NewObject<UGameplayEffect>(GetTransientPackage(), NAME_None);
+			GEBounty->DurationPolicy = EGameplayEffectDurationType::Instant;
+			GEBounty->Modifiers.SetNum(2);
+			GEBounty->Modifiers[0].ModifierMagnitude = FScalableFloat(0.0f);
+			GEBounty->Modifiers[0].Attribute = UGSAttributeSetBase::GetXPAttribute();
+			GEBounty->Modifiers[1].ModifierMagnitude = FScalableFloat(0.0f);
+			GEBounty->Modifiers[1].Attribute = UGSAttributeSetBase::GetGoldAttribute();
+			ASC->ApplyGameplayEffectToSelf(GEBounty, 1.0f, ASC->MakeEffectContext());
+
+			UGameplayEffect* GEAmmo = NewObject<UGameplayEffect>(GetTransientPackage(), NAME_None);
+			GEAmmo->DurationPolicy = EGameplayEffectDurationType::Instant;
+			GEAmmo->Modifiers.SetNum(1);
+			GEAmmo->Modifiers[0].ModifierMagnitude = FScalableFloat(0.0f);
+			GEAmmo->Modifiers[0].Attribute = UGSAmmoAttributeSet::GetRifleReserveAmmoAttribute();
+			ASC->ApplyGameplayEffectToSelf(GEAmmo, 1.0f, ASC->MakeEffectContext());
+		}
+		const uint64 TransientEndCycles = FPlatformTime::Cycles64();
+		const int32 TransientObjects = GUObjectArray.GetObjectArrayNumMinusAvailable() - TransientStartObjects;
+
+		const int32 SharedStartObjects = GUObjectArray.GetObjectArrayNumMinusAvailable();
+		const uint64 SharedStartCycles = FPlatformTime::Cycles64();
+		for (int32 i = 0; i < Count; i++)
+		{
+			FGameplayEffectSpec BountySpec(Globals.GetBountyEffect(), ASC->MakeEffectContext(), 1.0f);
+			BountySpec.SetSetByCallerMagnitude(Globals.BountyXPDataTag, 0.0f);
+			BountySpec.SetSetByCallerMagnitude(Globals.BountyGoldDataTag, 0.0f);
+			ASC->ApplyGameplayEffectSpecToSelf(BountySpec);
+
+			FGameplayEffectSpec AmmoSpec(Globals.GetAmmoRefillEffect(RifleAmmoTag), ASC->MakeEffectContext(), 1.0f);
+			AmmoSpec.SetSetByCallerMagnitude(RifleAmmoTag, 0.0f);
+			ASC->ApplyGameplayEffectSpecToSelf(AmmoSpec);
+		}
+		const uint64 SharedEndCycles = FPlatformTime::Cycles64();
+		const int32 SharedObjects = GUObjectArray.GetObjectArrayNumMinusAvailable() - SharedStartObjects;
+
+		UE_LOG(LogGASShooterALS, Log, TEXT("GS.Effects.Benchmark: %d kills. Transient effects %.3f ms, %d UObjects created. Shared SetByCaller effects %.3f ms, %d UObjects created."),
+			Count, FPlatformTime::ToMilliseconds64(TransientEndCycles - TransientStartCycles), TransientObjects,
+			FPlatformTime::ToMilliseconds64(SharedEndCycles - SharedStartCycles), SharedObjects);
+	})
+);
 
 UGSAbilitySystemGlobals::UGSAbilitySystemGlobals()
 {
-
+	BountyEffect = nullptr;
 }
 
 FGameplayEffectContext* UGSAbilitySystemGlobals::AllocGameplayEffectContext() const
@@ -22,4 +106,58 @@ void UGSAbilitySystemGlobals::InitGlobalTags()
 	KnockedDownTag = FGameplayTag::RequestGameplayTag("State.KnockedDown");
 	InteractingTag = FGameplayTag::RequestGameplayTag("State.Interacting");
 	InteractingRemovalTag = FGameplayTag::RequestGameplayTag("State.InteractingRemoval");
+	BountyXPDataTag = FGameplayTag::RequestGameplayTag("Data.Bounty.XP");
+	BountyGoldDataTag = FGameplayTag::RequestGameplayTag("Data.Bounty.Gold");
+}
+
+UGameplayEffect* UGSAbilitySystemGlobals::GetAmmoRefillEffect(const FGameplayTag& AmmoType)
+{
+	if (UGameplayEffect** Effect = AmmoRefillEffects.Find(AmmoType))
+	{
+		return *Effect;
+	}
+
+	FGameplayTag AmmoTypeKey = AmmoType;
+	FGameplayAttribute Attribute = UGSAmmoAttributeSet::GetReserveAmmoAttributeFromTag(AmmoTypeKey);
+	if (!Attribute.IsValid())
+	{
+		return nullptr;
+	}
+
+	// Tags contain '.', which isn't allowed in object names
+	UGameplayEffect* Effect = MakeInstantEffect(*FString::Printf(TEXT("GE_AmmoRefill_%s"), *AmmoType.ToString().Replace(TEXT("."), TEXT("_"))));
+	AddSetByCallerModifier(Effect, Attribute, AmmoType);
+	AmmoRefillEffects.Add(AmmoType, Effect);
+	return Effect;
+}
+
+UGameplayEffect* UGSAbilitySystemGlobals::GetBountyEffect()
+{
+	if (!BountyEffect)
+	{
+		BountyEffect = MakeInstantEffect(FName("GE_Bounty"));
+		AddSetByCallerModifier(BountyEffect, UGSAttributeSetBase::GetXPAttribute(), BountyXPDataTag);
+		AddSetByCallerModifier(BountyEffect, UGSAttributeSetBase::GetGoldAttribute(), BountyGoldDataTag);
+	}
+
+	return BountyEffect;
+}
+
+UGameplayEffect* UGSAbilitySystemGlobals::MakeInstantEffect(FName Name)
+{
+	// Outered to us so it lives as long as the globals
+	UGameplayEffect* Effect = NewObject<UGameplayEffect>(this, Name);
+	Effect->DurationPolicy = EGameplayEffectDurationType::Instant;
+	return Effect;
+}
+
+void UGSAbilitySystemGlobals::AddSetByCallerModifier(UGameplayEffect* Effect, const FGameplayAttribute& Attribute, const FGameplayTag& DataTag)
+{
+	FSetByCallerFloat SetByCaller;
+	SetByCaller.DataTag = DataTag;
+
+	FGameplayModifierInfo& Info = Effect->Modifiers.AddDefaulted_GetRef();
+	Info.ModifierMagnitude = FGameplayEffectModifierMagnitude(SetByCaller);
+	Info.ModifierOp = EGameplayModOp::Additive;
+	Info.Attribute = Attribute;
 }
@@ -4,6 +4,10 @@
 #include "Characters/Abilities/GSAbilityTypes.h"
 #include "AbilitySystemGlobals.h"
 #include "Characters/Abilities/GSAbilitySystemComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/Character.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
 
 bool FGSGameplayEffectContainerSpec::HasValidEffects() const
 {
@@ -24,7 +28,7 @@ void FGSGameplayEffectContainerSpec::AddTargets(const TArray<FGameplayAbilityTar
 
 	for (const FHitResult& HitResult : HitResults)
 	{
-		FGameplayAbilityTargetData_SingleTargetHit* NewData = new FGameplayAbilityTargetData_SingleTargetHit(HitResult);
+		FGSTargetData_CompactHit* NewData = new FGSTargetData_CompactHit(HitResult);
 		TargetData.Add(NewData);
 	}
 
@@ -40,3 +44,304 @@ void FGSGameplayEffectContainerSpec::ClearTargets()
 {
 	TargetData.Clear();
 }
+
+namespace GSAbilityTypes
+{
+	// The skeletal mesh that bone indices in compact target data refer to
+	static USkeletalMeshComponent* GetBoneIndexMesh(const AActor* Actor)
+	{
+		if (const ACharacter* Character = Cast<ACharacter>(Actor))
+		{
+			return Character->GetMesh();
+		}
+
+		return Actor ? Actor->FindComponentByClass<USkeletalMeshComponent>() : nullptr;
+	}
+}
+
+bool FGSTargetData_CompactHit::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	enum ECompactHitFlags : uint8
+	{
+		CHF_BlockingHit = 1 << 0,
+		CHF_Bone = 1 << 1,
+		CHF_PhysMaterial = 1 << 2,
+	};
+
+	uint8 Flags = 0;
+	if (Ar.IsSaving())
+	{
+		Flags |= HitResult.bBlockingHit ? CHF_BlockingHit : 0;
+		Flags |= HitResult.BoneName != NAME_None ? CHF_Bone : 0;
+		Flags |= HitResult.PhysMaterial.IsValid() ? CHF_PhysMaterial : 0;
+	}
+	Ar.SerializeBits(&Flags, 3);
+
+	Ar << HitResult.Actor;
+
+	FVector_NetQuantize10 ImpactPoint = HitResult.ImpactPoint;
+	ImpactPoint.NetSerialize(Ar, Map, bOutSuccess);
+
+	FVector_NetQuantizeNormal ImpactNormal = HitResult.ImpactNormal;
+	ImpactNormal.NetSerialize(Ar, Map, bOutSuccess);
+
+	FVector_NetQuantize TraceStart = HitResult.TraceStart;
+	TraceStart.NetSerialize(Ar, Map, bOutSuccess);
+
+	FVector_NetQuantize TraceEnd = HitResult.TraceEnd;
+	TraceEnd.NetSerialize(Ar, Map, bOutSuccess);
+
+	// Bones travel as an index into the hit Actor's mesh instead of an FName
+	USkeletalMeshComponent* Mesh = GSAbilityTypes::GetBoneIndexMesh(HitResult.Actor.Get());
+	if (Flags & CHF_Bone)
+	{
+		uint32 PackedBoneIndex = 0;
+		if (Ar.IsSaving() && Mesh)
+		{
+			PackedBoneIndex = (uint32)(Mesh->GetBoneIndex(HitResult.BoneName) + 1);
+		}
+		Ar.SerializeIntPacked(PackedBoneIndex);
+
+		if (Ar.IsLoading())
+		{
+			HitResult.BoneName = (Mesh && PackedBoneIndex > 0) ? Mesh->GetBoneName((int32)PackedBoneIndex - 1) : NAME_None;
+		}
+	}
+
+	if (Flags & CHF_PhysMaterial)
+	{
+		Ar << HitResult.PhysMaterial;
+	}
+
+	if (Ar.IsLoading())
+	{
+		HitResult.bBlockingHit = (Flags & CHF_BlockingHit) != 0;
+		HitResult.ImpactPoint = ImpactPoint;
+		HitResult.Location = ImpactPoint;
+		HitResult.ImpactNormal = ImpactNormal;
+		HitResult.Normal = ImpactNormal;
+		HitResult.TraceStart = TraceStart;
+		HitResult.TraceEnd = TraceEnd;
+		HitResult.Distance = FVector::Dist(HitResult.TraceStart, HitResult.ImpactPoint);
+
+		const float TraceLength = FVector::Dist(HitResult.TraceStart, HitResult.TraceEnd);
+		HitResult.Time = TraceLength > 0.0f ? FMath::Min(1.0f, HitResult.Distance / TraceLength) : 0.0f;
+
+		if (!(Flags & CHF_Bone))
+		{
+			HitResult.BoneName = NAME_None;
+		}
+
+		if (!(Flags & CHF_PhysMaterial))
+		{
+			HitResult.PhysMaterial = nullptr;
+		}
+
+		if (HitResult.BoneName != NAME_None)
+		{
+			HitResult.Component = Mesh;
+		}
+		else
+		{
+			AActor* HitActor = HitResult.Actor.Get();
+			HitResult.Component = HitActor ? Cast<UPrimitiveComponent>(HitActor->GetRootComponent()) : nullptr;
+		}
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+int32 FGSTargetData_SpreadShot::MakeSpreadSeed(const FPredictionKey& ActivationPredictionKey, uint16 InShotIndex)
+{
+	return (int32)HashCombine(GetTypeHash(ActivationPredictionKey.Current), GetTypeHash(InShotIndex));
+}
+
+void FGSTargetData_SpreadShot::QuantizeShot(FVector& InOutOrigin, FVector& InOutAimDirection, float& InOutConeHalfAngle)
+{
+	FGSTargetData_SpreadShot Shot;
+	Shot.Origin = InOutOrigin;
+	Shot.AimDirection = InOutAimDirection;
+	Shot.ConeHalfAngle = InOutConeHalfAngle;
+
+	// Round trip through our own NetSerialize so this can never drift from what goes over the wire.
+	// There are no Actors in Shot so no PackageMap is needed.
+	bool bSuccess = false;
+	FBitWriter Writer(256, true);
+	Shot.NetSerialize(Writer, nullptr, bSuccess);
+
+	FGSTargetData_SpreadShot QuantizedShot;
+	FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+	QuantizedShot.NetSerialize(Reader, nullptr, bSuccess);
+
+	InOutOrigin = QuantizedShot.Origin;
+	InOutAimDirection = QuantizedShot.AimDirection;
+	InOutConeHalfAngle = QuantizedShot.ConeHalfAngle;
+}
+
+void FGSTargetData_SpreadShot::AddHit(const FHitResult& HitResult, int32 PelletIndex)
+{
+	FGSSpreadShotHit& Hit = Hits.AddDefaulted_GetRef();
+	Hit.PelletIndex = (uint8)PelletIndex;
+	Hit.Distance = FVector::Dist(Origin, HitResult.Location);
+	Hit.bBlockingHit = HitResult.bBlockingHit;
+
+	AActor* HitActor = HitResult.Actor.Get();
+	if (HitActor)
+	{
+		int32 ActorIndex = HitActors.IndexOfByKey(HitActor);
+		if (ActorIndex == INDEX_NONE)
+		{
+			ActorIndex = HitActors.Add(HitActor);
+		}
+		Hit.ActorIndex = (uint8)ActorIndex;
+
+		const USkeletalMeshComponent* Mesh = GSAbilityTypes::GetBoneIndexMesh(HitActor);
+		if (Mesh && HitResult.BoneName != NAME_None)
+		{
+			Hit.BoneIndex = Mesh->GetBoneIndex(HitResult.BoneName);
+		}
+	}
+}
+
+void FGSTargetData_SpreadShot::GeneratePelletDirections(int32 Seed, TArray<FVector>& OutDirections) const
+{
+	OutDirections.Reset(NumPellets);
+
+	FRandomStream WeaponRandomStream(Seed);
+	for (int32 PelletIndex = 0; PelletIndex < NumPellets; PelletIndex++)
+	{
+		OutDirections.Add(WeaponRandomStream.VRandCone(AimDirection, ConeHalfAngle, ConeHalfAngle));
+	}
+}
+
+void FGSTargetData_SpreadShot::ExpandToHitResults(int32 Seed, float MaxRange, const FVector& HitResultTraceStart, TArray<FHitResult>& OutHitResults) const
+{
+	TArray<FVector> PelletDirections;
+	GeneratePelletDirections(Seed, PelletDirections);
+
+	OutHitResults.Reset(FMath::Max<int32>(NumPellets, Hits.Num()));
+
+	for (int32 PelletIndex = 0; PelletIndex < NumPellets; PelletIndex++)
+	{
+		const FVector& PelletDirection = PelletDirections[PelletIndex];
+		const FVector TraceEnd = Origin + (PelletDirection * MaxRange);
+		bool bPelletHit = false;
+
+		// Hits were added per pellet in trace order so they are already sorted by distance
+		for (const FGSSpreadShotHit& Hit : Hits)
+		{
+			if (Hit.PelletIndex != PelletIndex)
+			{
+				continue;
+			}
+
+			bPelletHit = true;
+
+			FHitResult& HitResult = OutHitResults.AddDefaulted_GetRef();
+			HitResult.TraceStart = HitResultTraceStart;
+			HitResult.TraceEnd = TraceEnd;
+			HitResult.Location = Origin + (PelletDirection * Hit.Distance);
+			HitResult.ImpactPoint = HitResult.Location;
+			HitResult.Normal = -PelletDirection;
+			HitResult.ImpactNormal = -PelletDirection;
+			HitResult.Distance = Hit.Distance;
+			HitResult.Time = MaxRange > 0.0f ? Hit.Distance / MaxRange : 0.0f;
+			HitResult.bBlockingHit = Hit.bBlockingHit;
+
+			AActor* HitActor = HitActors.IsValidIndex(Hit.ActorIndex) ? HitActors[Hit.ActorIndex].Get() : nullptr;
+			if (HitActor)
+			{
+				HitResult.Actor = HitActor;
+
+				USkeletalMeshComponent* Mesh = GSAbilityTypes::GetBoneIndexMesh(HitActor);
+				if (Mesh && Hit.BoneIndex != INDEX_NONE)
+				{
+					HitResult.Component = Mesh;
+					HitResult.BoneName = Mesh->GetBoneName(Hit.BoneIndex);
+				}
+				else
+				{
+					HitResult.Component = Cast<UPrimitiveComponent>(HitActor->GetRootComponent());
+				}
+			}
+		}
+
+		if (!bPelletHit)
+		{
+			// If there were no hits, add a default HitResult at the end of the trace
+			FHitResult& HitResult = OutHitResults.AddDefaulted_GetRef();
+			HitResult.TraceStart = HitResultTraceStart;
+			HitResult.TraceEnd = TraceEnd;
+			HitResult.Location = TraceEnd;
+			HitResult.ImpactPoint = TraceEnd;
+		}
+	}
+}
+
+bool FGSTargetData_SpreadShot::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	Origin.NetSerialize(Ar, Map, bOutSuccess);
+	AimDirection.NetSerialize(Ar, Map, bOutSuccess);
+
+	// Hundredths of a degree are plenty for a spread cone
+	uint16 QuantizedConeHalfAngle = 0;
+	if (Ar.IsSaving())
+	{
+		QuantizedConeHalfAngle = (uint16)FMath::Clamp(FMath::RoundToInt(FMath::RadiansToDegrees(ConeHalfAngle) * 100.0f), 0, (int32)MAX_uint16);
+	}
+	Ar << QuantizedConeHalfAngle;
+	if (Ar.IsLoading())
+	{
+		ConeHalfAngle = FMath::DegreesToRadians(QuantizedConeHalfAngle * 0.01f);
+	}
+
+	Ar << ShotIndex;
+	Ar << NumPellets;
+
+	SafeNetSerializeTArray_Default<31>(Ar, HitActors);
+
+	// AGSGATA_Trace::UsesSeededSpreadTargetData() keeps weapons that could hit more than this on the per hit target data
+	if (Ar.IsSaving() && Hits.Num() > MAX_uint8)
+	{
+		ensureMsgf(false, TEXT("FGSTargetData_SpreadShot has %d hits, more than the %d that can be sent"), Hits.Num(), (int32)MAX_uint8);
+		Ar.SetError();
+		bOutSuccess = false;
+		return true;
+	}
+
+	uint8 NumHits = (uint8)Hits.Num();
+	Ar << NumHits;
+	if (Ar.IsLoading())
+	{
+		Hits.SetNum(NumHits);
+	}
+
+	for (int32 HitIndex = 0; HitIndex < NumHits; HitIndex++)
+	{
+		FGSSpreadShotHit& Hit = Hits[HitIndex];
+
+		Ar << Hit.PelletIndex;
+		Ar << Hit.ActorIndex;
+
+		// Bone indices and distances are small, pack them. Bones are offset by one so INDEX_NONE packs to zero.
+		uint32 PackedBoneIndex = (uint32)(Hit.BoneIndex + 1);
+		Ar.SerializeIntPacked(PackedBoneIndex);
+
+		uint32 PackedDistance = (uint32)FMath::Max(0, FMath::RoundToInt(Hit.Distance));
+		Ar.SerializeIntPacked(PackedDistance);
+
+		uint8 bBlockingHit = Hit.bBlockingHit ? 1 : 0;
+		Ar.SerializeBits(&bBlockingHit, 1);
+
+		if (Ar.IsLoading())
+		{
+			Hit.BoneIndex = (int32)PackedBoneIndex - 1;
+			Hit.Distance = (float)PackedDistance;
+			Hit.bBlockingHit = bBlockingHit != 0;
+		}
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
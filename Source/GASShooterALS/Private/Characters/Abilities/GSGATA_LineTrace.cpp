@@ -65,7 +65,12 @@ void AGSGATA_LineTrace::DoTrace(TArray<FHitResult>& HitResults, const UWorld* Wo
 	LineTraceWithFilter(HitResults, World, FilterHandle, Start, End, ProfileName, Params);
 }
 
-void AGSGATA_LineTrace::ShowDebugTrace(TArray<FHitResult>& HitResults, EDrawDebugTrace::Type DrawDebugType, float Duration)
+FTraceHandle AGSGATA_LineTrace::DoAsyncTrace(UWorld* World, const FVector& Start, const FVector& End, FName ProfileName, const FCollisionQueryParams& Params, FTraceDelegate* InDelegate, uint32 UserData)
+{
+	return World->AsyncLineTraceByProfile(EAsyncTraceType::Multi, Start, End, ProfileName, Params, InDelegate, UserData);
+}
+
+void AGSGATA_LineTrace::ShowDebugTrace(const TArray<FHitResult>& HitResults, EDrawDebugTrace::Type DrawDebugType, float Duration)
 {
 #if ENABLE_DRAW_DEBUG
 	if (bDebug)
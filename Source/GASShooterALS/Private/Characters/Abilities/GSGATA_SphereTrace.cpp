@@ -68,30 +68,11 @@ void AGSGATA_SphereTrace::SphereTraceWithFilter(TArray<FHitResult>& OutHitResult
 {
 	check(World);
 
-	TArray<FHitResult> HitResults;
-	World->SweepMultiByProfile(HitResults, Start, End, FQuat::Identity, ProfileName, FCollisionShape::MakeSphere(Radius), Params);
+	// Sweep and filter in place so OutHitResults' allocation is reused from trace to trace
+	OutHitResults.Reset();
+	World->SweepMultiByProfile(OutHitResults, Start, End, FQuat::Identity, ProfileName, FCollisionShape::MakeSphere(Radius), Params);
 
-	TArray<FHitResult> FilteredHitResults;
-
-	// Start param could be player ViewPoint. We want HitResult to always display the StartLocation.
-	FVector TraceStart = StartLocation.GetTargetingTransform().GetLocation();
-
-	for (int32 HitIdx = 0; HitIdx < HitResults.Num(); ++HitIdx)
-	{
-		FHitResult& Hit = HitResults[HitIdx];
-
-		if (!Hit.Actor.IsValid() || FilterHandle.FilterPassesForActor(Hit.Actor))
-		{
-			Hit.TraceStart = TraceStart;
-			Hit.TraceEnd = End;
-
-			FilteredHitResults.Add(Hit);
-		}
-	}
-
-	OutHitResults = FilteredHitResults;
-
-	return;
+	FilterHitResults(OutHitResults, FilterHandle, End);
 }
 
 void AGSGATA_SphereTrace::DoTrace(TArray<FHitResult>& HitResults, const UWorld* World, const FGameplayTargetDataFilterHandle FilterHandle, const FVector& Start, const FVector& End, FName ProfileName, const FCollisionQueryParams Params)
@@ -99,7 +80,12 @@ void AGSGATA_SphereTrace::DoTrace(TArray<FHitResult>& HitResults, const UWorld*
 	SphereTraceWithFilter(HitResults, World, FilterHandle, Start, End, TraceSphereRadius, ProfileName, Params);
 }
 
-void AGSGATA_SphereTrace::ShowDebugTrace(TArray<FHitResult>& HitResults, EDrawDebugTrace::Type DrawDebugType, float Duration)
+FTraceHandle AGSGATA_SphereTrace::DoAsyncTrace(UWorld* World, const FVector& Start, const FVector& End, FName ProfileName, const FCollisionQueryParams& Params, FTraceDelegate* InDelegate, uint32 UserData)
+{
+	return World->AsyncSweepByProfile(EAsyncTraceType::Multi, Start, End, FQuat::Identity, ProfileName, FCollisionShape::MakeSphere(TraceSphereRadius), Params, InDelegate, UserData);
+}
+
+void AGSGATA_SphereTrace::ShowDebugTrace(const TArray<FHitResult>& HitResults, EDrawDebugTrace::Type DrawDebugType, float Duration)
 {
 #if ENABLE_DRAW_DEBUG
 	if (bDebug)
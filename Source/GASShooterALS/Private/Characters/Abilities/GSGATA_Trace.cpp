@@ -3,9 +3,47 @@
 
 #include "Characters/Abilities/GSGATA_Trace.h"
 #include "AbilitySystemComponent.h"
+#include "Characters/Abilities/GSAbilitySystemComponent.h"
+#include "Characters/Abilities/GSAbilityTypes.h"
 #include "DrawDebugHelpers.h"
+#include "Engine/NetConnection.h"
 #include "GameFramework/PlayerController.h"
 #include "GameplayAbilitySpec.h"
+#include "GASShooterALS/GASShooterALS.h"
+#include "GSLagCompensationSubsystem.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/CoreNet.h"
+
+DECLARE_STATS_GROUP(TEXT("GSTrace"), STATGROUP_GSTrace, STATCAT_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Perform Trace"), STAT_GSTrace_PerformTrace, STATGROUP_GSTrace);
+DECLARE_CYCLE_STAT(TEXT("Aim"), STAT_GSTrace_Aim, STATGROUP_GSTrace);
+DECLARE_CYCLE_STAT(TEXT("Pellet Traces"), STAT_GSTrace_PelletTraces, STATGROUP_GSTrace);
+DECLARE_CYCLE_STAT(TEXT("Async Tick Trace"), STAT_GSTrace_AsyncTickTrace, STATGROUP_GSTrace);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Async Traces Queued"), STAT_GSTrace_AsyncTracesQueued, STATGROUP_GSTrace);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pellets"), STAT_GSTrace_Pellets, STATGROUP_GSTrace);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Reticles Spawned"), STAT_GSTrace_ReticlesSpawned, STATGROUP_GSTrace);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Reticles Reused"), STAT_GSTrace_ReticlesReused, STATGROUP_GSTrace);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Scratch Buffer Growths"), STAT_GSTrace_ScratchGrowths, STATGROUP_GSTrace);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Last Shot Target Data Bytes"), STAT_GSTrace_TargetDataBytes, STATGROUP_GSTrace);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Last Shot SingleTargetHit Bytes"), STAT_GSTrace_SingleTargetHitBytes, STATGROUP_GSTrace);
+
+static TAutoConsoleVariable<int32> CVarBatchMultiTraces(
+	TEXT("GS.Trace.BatchMultiTraces"),
+	-1,
+	TEXT("Overrides bBatchMultiTraces on every trace TargetActor for A/B profiling with \"stat GSTrace\". -1 uses the TargetActor's setting, 0 forces per pellet aiming, 1 forces batched pellets")
+);
+
+static TAutoConsoleVariable<int32> CVarAsyncTickTrace(
+	TEXT("GS.Trace.AsyncTickTrace"),
+	-1,
+	TEXT("Overrides bUseAsyncTickTrace on every trace TargetActor. -1 uses the TargetActor's setting, 0 forces synchronous tick traces, 1 forces async tick traces")
+);
+
+static TAutoConsoleVariable<int32> CVarLogTargetDataBandwidth(
+	TEXT("GS.TargetData.LogBandwidth"),
+	0,
+	TEXT("Client only. Logs the serialized size of each confirmed shot's target data next to the size it would be as one SingleTargetHit per HitResult")
+);
 
 AGSGATA_Trace::AGSGATA_Trace()
 {
@@ -25,6 +63,21 @@ AGSGATA_Trace::AGSGATA_Trace()
 	TargetingSpreadMax = 0.0f;
 	CurrentTargetingSpread = 0.0f;
 	bUsePersistentHitResults = false;
+	PersistentTargetEvictionPolicy = EGSTargetEvictionPolicy::Oldest;
+	bValidateHitsWithLagCompensation = true;
+	bBatchMultiTraces = false;
+	bUseSeededSpreadTargetData = false;
+	bUseAsyncTickTrace = false;
+	AsyncTraceGeneration = 0;
+	bAsyncAimTracePending = false;
+	bAsyncTargetTracePending = false;
+	bHasAsyncAimDirection = false;
+	AsyncAimDirection = FVector::ForwardVector;
+	LastShotOrigin = FVector::ZeroVector;
+	LastShotAimDirection = FVector::ForwardVector;
+	LastShotConeHalfAngle = 0.0f;
+	SpreadShotIndex = 0;
+	LastAcceptedSpreadShotIndex = INDEX_NONE;
 }
 
 void AGSGATA_Trace::ResetSpread()
@@ -77,21 +130,14 @@ void AGSGATA_Trace::StartTargeting(UGameplayAbility* Ability)
 	OwningAbility = Ability;
 	SourceActor = Ability->GetCurrentActorInfo()->AvatarActor.Get();
 
-	// This is a lazy way of emptying and repopulating the ReticleActors.
-	// We could come up with a solution that reuses them.
-	DestroyReticleActors();
+	// Reuse the reticles from the last time we targeted and only spawn the ones we're missing
+	AcquireReticleActors(MaxHitResultsPerTrace * NumberOfTraces);
 
-	if (ReticleClass)
-	{
-		for (int32 i = 0; i < MaxHitResultsPerTrace * NumberOfTraces; i++)
-		{
-			SpawnReticleActor(GetActorLocation(), GetActorRotation());
-		}
-	}
+	ResetAsyncTickTrace();
 
 	if (bUsePersistentHitResults)
 	{
-		PersistentHitResults.Empty();
+		PersistentTargets.Init(MaxHitResultsPerTrace, PersistentTargetEvictionPolicy);
 	}
 }
 
@@ -100,8 +146,30 @@ void AGSGATA_Trace::ConfirmTargetingAndContinue()
 	check(ShouldProduceTargetData());
 	if (SourceActor)
 	{
-		TArray<FHitResult> HitResults = PerformTrace(SourceActor);
+#if !UE_BUILD_SHIPPING
+		const SIZE_T ScratchSizeBeforeTrace = GetTraceScratchAllocatedSize();
+#endif
+
+		const TArray<FHitResult>& HitResults = PerformTrace(SourceActor);
+
+#if !UE_BUILD_SHIPPING
+		CheckTraceScratchGrowth(ScratchSizeBeforeTrace);
+#endif
+
 		FGameplayAbilityTargetDataHandle Handle = MakeTargetData(HitResults);
+
+#if !UE_BUILD_SHIPPING
+		if (CVarLogTargetDataBandwidth.GetValueOnGameThread() > 0)
+		{
+			LogTargetDataBandwidth(HitResults, Handle);
+		}
+#endif
+
+		if (UsesSeededSpreadTargetData())
+		{
+			SpreadShotIndex++;
+		}
+
 		TargetDataReadyDelegate.Broadcast(Handle);
 
 #if ENABLE_DRAW_DEBUG
@@ -114,7 +182,7 @@ void AGSGATA_Trace::ConfirmTargetingAndContinue()
 
 	if (bUsePersistentHitResults)
 	{
-		PersistentHitResults.Empty();
+		PersistentTargets.Reset();
 	}
 }
 
@@ -135,10 +203,47 @@ void AGSGATA_Trace::CancelTargeting()
 
 	SetActorTickEnabled(false);
 
+	ResetAsyncTickTrace();
+
 	if (bUsePersistentHitResults)
 	{
-		PersistentHitResults.Empty();
+		PersistentTargets.Reset();
+	}
+}
+
+bool AGSGATA_Trace::OnReplicatedTargetDataReceived(FGameplayAbilityTargetDataHandle& Data) const
+{
+	if (!ExpandSpreadShotTargetData(Data))
+	{
+		return false;
+	}
+
+	if (!bValidateHitsWithLagCompensation)
+	{
+		return Super::OnReplicatedTargetDataReceived(Data);
 	}
+
+	UGSLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UGSLagCompensationSubsystem>();
+	if (!LagCompensation)
+	{
+		return Super::OnReplicatedTargetDataReceived(Data);
+	}
+
+	// All hits in one confirmation were fired at the same time. Bundled shots were fired before the bundle was sent.
+	const UGSAbilitySystemComponent* ASC = OwningAbility ? Cast<UGSAbilitySystemComponent>(OwningAbility->GetAbilitySystemComponentFromActorInfo()) : nullptr;
+	const float RewindTime = LagCompensation->GetRewindTimeForShooter(MasterPC, ASC ? ASC->GetBundledShotAge() : 0.0f);
+
+	for (int32 DataIndex = 0; DataIndex < Data.Num(); DataIndex++)
+	{
+		const FGameplayAbilityTargetData* TargetData = Data.Get(DataIndex);
+		if (TargetData && TargetData->HasHitResult() && !LagCompensation->ValidateHit(*TargetData->GetHitResult(), RewindTime))
+		{
+			// Reject the whole shot. The task treats this as a cancel.
+			return false;
+		}
+	}
+
+	return Super::OnReplicatedTargetDataReceived(Data);
 }
 
 void AGSGATA_Trace::BeginPlay()
@@ -148,10 +253,18 @@ void AGSGATA_Trace::BeginPlay()
 	// Start with Tick disabled. We'll enable it in StartTargeting() and disable it again in StopTargeting().
 	// For instant confirmations, tick will never happen because we StartTargeting(), ConfirmTargeting(), and immediately StopTargeting().
 	SetActorTickEnabled(false);
+
+	AsyncAimTraceDelegate.BindUObject(this, &AGSGATA_Trace::OnAsyncAimTraceCompleted);
+	AsyncTargetTraceDelegate.BindUObject(this, &AGSGATA_Trace::OnAsyncTargetTraceCompleted);
 }
 
 void AGSGATA_Trace::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
+	// Each queued trace holds its own copy of the delegate, so results still in the async queue reach us next frame if we
+	// haven't been collected by then. Bumping the generation makes the completion handlers drop them. Once we're gone
+	// the copies' weak binding no longer executes.
+	ResetAsyncTickTrace();
+
 	DestroyReticleActors();
 
 	Super::EndPlay(EndPlayReason);
@@ -161,17 +274,26 @@ void AGSGATA_Trace::Tick(float DeltaSeconds)
 {
 	Super::Tick(DeltaSeconds);
 
-	TArray<FHitResult> HitResults;
+	const TArray<FHitResult>* HitResults = nullptr;
 	if (bDebug || bUsePersistentHitResults)
 	{
 		// Only need to trace on Tick if we're showing debug or if we use persistent hit results, otherwise we just use the confirmation trace
-		HitResults = PerformTrace(SourceActor);
+		if (ShouldUseAsyncTickTrace())
+		{
+			PerformAsyncTickTrace(SourceActor);
+			HitResults = &AsyncTickHitResults;
+		}
+		else
+		{
+			HitResults = &PerformTrace(SourceActor);
+		}
 	}
 
 #if ENABLE_DRAW_DEBUG
-	if (SourceActor && bDebug)
+	// Async tick traces have nothing to show until the first one completes
+	if (SourceActor && bDebug && HitResults && HitResults->Num() > 0)
 	{
-		ShowDebugTrace(HitResults, EDrawDebugTrace::Type::ForOneFrame);
+		ShowDebugTrace(*HitResults, EDrawDebugTrace::Type::ForOneFrame);
 	}
 #endif
 }
@@ -180,62 +302,74 @@ void AGSGATA_Trace::LineTraceWithFilter(TArray<FHitResult>& OutHitResults, const
 {
 	check(World);
 
-	TArray<FHitResult> HitResults;
-	World->LineTraceMultiByProfile(HitResults, Start, End, ProfileName, Params);
-
-	TArray<FHitResult> FilteredHitResults;
+	// Trace and filter in place so OutHitResults' allocation is reused from trace to trace
+	OutHitResults.Reset();
+	World->LineTraceMultiByProfile(OutHitResults, Start, End, ProfileName, Params);
 
-	// Start param could be player ViewPoint. We want HitResult to always display the StartLocation.
-	FVector TraceStart = StartLocation.GetTargetingTransform().GetLocation();
+	FilterHitResults(OutHitResults, FilterHandle, End);
+}
 
-	for (int32 HitIdx = 0; HitIdx < HitResults.Num(); ++HitIdx)
+void AGSGATA_Trace::AimWithPlayerController(const AActor* InSourceActor, FCollisionQueryParams Params, const FVector& TraceStart, FVector& OutTraceEnd, bool bIgnorePitch)
+{
+	FVector AdjustedAimDir;
+	if (!GetAdjustedAimDirection(InSourceActor, Params, TraceStart, AdjustedAimDir)) // Server and launching client only
 	{
-		FHitResult& Hit = HitResults[HitIdx];
-
-		if (!Hit.Actor.IsValid() || FilterHandle.FilterPassesForActor(Hit.Actor))
-		{
-			Hit.TraceStart = TraceStart;
-			Hit.TraceEnd = End;
-
-			FilteredHitResults.Add(Hit);
-		}
+		return;
 	}
 
-	OutHitResults = FilteredHitResults;
+	const float CurrentSpread = GetCurrentSpread();
 
-	return;
+	const float ConeHalfAngle = FMath::DegreesToRadians(CurrentSpread * 0.5f);
+	const int32 RandomSeed = FMath::Rand();
+	FRandomStream WeaponRandomStream(RandomSeed);
+	const FVector ShootDir = WeaponRandomStream.VRandCone(AdjustedAimDir, ConeHalfAngle, ConeHalfAngle);
+
+	OutTraceEnd = TraceStart + (ShootDir * MaxRange);
 }
 
-void AGSGATA_Trace::AimWithPlayerController(const AActor* InSourceActor, FCollisionQueryParams Params, const FVector& TraceStart, FVector& OutTraceEnd, bool bIgnorePitch)
+bool AGSGATA_Trace::GetAdjustedAimDirection(const AActor* InSourceActor, const FCollisionQueryParams& Params, const FVector& TraceStart, FVector& OutAimDir)
 {
+	SCOPE_CYCLE_COUNTER(STAT_GSTrace_Aim);
+
 	if (!OwningAbility) // Server and launching client only
 	{
-		return;
+		return false;
 	}
 
+	FVector ViewStart, ViewDir, ViewEnd;
+	GetAimViewPoint(TraceStart, ViewStart, ViewDir, ViewEnd);
+
+	// Use first hit
+	LineTraceWithFilter(AimHitResults, InSourceActor->GetWorld(), Filter, ViewStart, ViewEnd, TraceProfile.Name, Params);
+
+	OutAimDir = AdjustAimDirection(TraceStart, ViewDir, ViewEnd, AimHitResults.Num() > 0 ? &AimHitResults[0] : nullptr);
+	return true;
+}
+
+void AGSGATA_Trace::GetAimViewPoint(const FVector& TraceStart, FVector& OutViewStart, FVector& OutViewDir, FVector& OutViewEnd) const
+{
 	// Default values in case of AI Controller
-	FVector ViewStart = TraceStart;
+	OutViewStart = TraceStart;
 	FRotator ViewRot = StartLocation.GetTargetingTransform().GetRotation().Rotator();
 
 	if (MasterPC)
 	{
-		MasterPC->GetPlayerViewPoint(ViewStart, ViewRot);
+		MasterPC->GetPlayerViewPoint(OutViewStart, ViewRot);
 	}
 
-	const FVector ViewDir = ViewRot.Vector();
-	FVector ViewEnd = ViewStart + (ViewDir * MaxRange);
+	OutViewDir = ViewRot.Vector();
+	OutViewEnd = OutViewStart + (OutViewDir * MaxRange);
 
-	ClipCameraRayToAbilityRange(ViewStart, ViewDir, TraceStart, MaxRange, ViewEnd);
-
-	// Use first hit
-	TArray<FHitResult> HitResults;
-	LineTraceWithFilter(HitResults, InSourceActor->GetWorld(), Filter, ViewStart, ViewEnd, TraceProfile.Name, Params);
+	ClipCameraRayToAbilityRange(OutViewStart, OutViewDir, TraceStart, MaxRange, OutViewEnd);
+}
 
+FVector AGSGATA_Trace::AdjustAimDirection(const FVector& TraceStart, const FVector& ViewDir, const FVector& ViewEnd, const FHitResult* AimHit)
+{
 	CurrentTargetingSpread = FMath::Min(TargetingSpreadMax, CurrentTargetingSpread + TargetingSpreadIncrement);
 
-	const bool bUseTraceResult = HitResults.Num() > 0 && (FVector::DistSquared(TraceStart, HitResults[0].Location) <= (MaxRange * MaxRange));
+	const bool bUseTraceResult = AimHit && (FVector::DistSquared(TraceStart, AimHit->Location) <= (MaxRange * MaxRange));
 
-	const FVector AdjustedEnd = (bUseTraceResult) ? HitResults[0].Location : ViewEnd;
+	const FVector AdjustedEnd = (bUseTraceResult) ? AimHit->Location : ViewEnd;
 
 	FVector AdjustedAimDir = (AdjustedEnd - TraceStart).GetSafeNormal();
 	if (AdjustedAimDir.IsZero())
@@ -259,14 +393,14 @@ void AGSGATA_Trace::AimWithPlayerController(const AActor* InSourceActor, FCollis
 		}
 	}
 
-	const float CurrentSpread = GetCurrentSpread();
-
-	const float ConeHalfAngle = FMath::DegreesToRadians(CurrentSpread * 0.5f);
-	const int32 RandomSeed = FMath::Rand();
-	FRandomStream WeaponRandomStream(RandomSeed);
-	const FVector ShootDir = WeaponRandomStream.VRandCone(AdjustedAimDir, ConeHalfAngle, ConeHalfAngle);
+	return AdjustedAimDir;
+}
 
-	OutTraceEnd = TraceStart + (ShootDir * MaxRange);
+TArray<AActor*> AGSGATA_Trace::GetPersistentTargetActors() const
+{
+	TArray<AActor*> Actors;
+	PersistentTargets.GetActors(Actors);
+	return Actors;
 }
 
 bool AGSGATA_Trace::ClipCameraRayToAbilityRange(FVector CameraLocation, FVector CameraDirection, FVector AbilityCenter, float AbilityRange, FVector& ClippedPosition)
@@ -292,7 +426,9 @@ void AGSGATA_Trace::StopTargeting()
 {
 	SetActorTickEnabled(false);
 
-	DestroyReticleActors();
+	ReleaseReticleActors();
+
+	ResetAsyncTickTrace();
 
 	// Clear added callbacks
 	TargetDataReadyDelegate.Clear();
@@ -310,31 +446,322 @@ FGameplayAbilityTargetDataHandle AGSGATA_Trace::MakeTargetData(const TArray<FHit
 {
 	FGameplayAbilityTargetDataHandle ReturnDataHandle;
 
+	// Only clients send target data to the server. The server's own target data goes straight to the ability.
+	const FGameplayAbilityActorInfo* ActorInfo = (OwningAbility ? OwningAbility->GetCurrentActorInfo() : nullptr);
+	if (UsesSeededSpreadTargetData() && ActorInfo && !ActorInfo->IsNetAuthority())
+	{
+		/** Note: This is cleaned up by the FGameplayAbilityTargetDataHandle (via an internal TSharedPtr) */
+		FGSTargetData_SpreadShot* ReturnData = new FGSTargetData_SpreadShot();
+		ReturnData->Origin = LastShotOrigin;
+		ReturnData->AimDirection = LastShotAimDirection;
+		ReturnData->ConeHalfAngle = LastShotConeHalfAngle;
+		ReturnData->ShotIndex = SpreadShotIndex;
+		ReturnData->NumPellets = (uint8)NumberOfTraces;
+
+		for (int32 i = 0; i < HitResults.Num(); i++)
+		{
+			const FHitResult& HitResult = HitResults[i];
+
+			// Default end of trace HitResults are regenerated by the server
+			if ((HitResult.Actor.IsValid() || HitResult.bBlockingHit) && BatchHitPelletIndices.IsValidIndex(i))
+			{
+				ReturnData->AddHit(HitResult, BatchHitPelletIndices[i]);
+			}
+		}
+
+		ReturnDataHandle.Add(ReturnData);
+		return ReturnDataHandle;
+	}
+
 	for (int32 i = 0; i < HitResults.Num(); i++)
 	{
 		/** Note: These are cleaned up by the FGameplayAbilityTargetDataHandle (via an internal TSharedPtr) */
-		FGameplayAbilityTargetData_SingleTargetHit* ReturnData = new FGameplayAbilityTargetData_SingleTargetHit();
-		ReturnData->HitResult = HitResults[i];
+		FGSTargetData_CompactHit* ReturnData = new FGSTargetData_CompactHit(HitResults[i]);
 		ReturnDataHandle.Add(ReturnData);
 	}
 
 	return ReturnDataHandle;
 }
 
-TArray<FHitResult> AGSGATA_Trace::PerformTrace(AActor* InSourceActor)
+bool AGSGATA_Trace::UsesSeededSpreadTargetData() const
 {
-	bool bTraceComplex = false;
-	TArray<AActor*> ActorsToIgnore;
+	// FGSTargetData_SpreadShot holds at most MAX_uint8 pellets and hits
+	return bUseSeededSpreadTargetData && !bUsePersistentHitResults && NumberOfTraces > 0
+		&& NumberOfTraces * FMath::Max(1, MaxHitResultsPerTrace) <= MAX_uint8;
+}
+
+int32 AGSGATA_Trace::GetSpreadSeed()
+{
+	const FPredictionKey ActivationPredictionKey = OwningAbility->GetCurrentActivationInfo().GetActivationPredictionKey();
+	if (ActivationPredictionKey.Current != SpreadShotPredictionKey.Current)
+	{
+		SpreadShotPredictionKey = ActivationPredictionKey;
+		SpreadShotIndex = 0;
+	}
+
+	return FGSTargetData_SpreadShot::MakeSpreadSeed(ActivationPredictionKey, SpreadShotIndex);
+}
+
+bool AGSGATA_Trace::ExpandSpreadShotTargetData(FGameplayAbilityTargetDataHandle& Data) const
+{
+	bool bHasSpreadShot = false;
+	for (int32 DataIndex = 0; DataIndex < Data.Num(); DataIndex++)
+	{
+		const FGameplayAbilityTargetData* TargetData = Data.Get(DataIndex);
+		if (TargetData && TargetData->GetScriptStruct() == FGSTargetData_SpreadShot::StaticStruct())
+		{
+			bHasSpreadShot = true;
+			break;
+		}
+	}
+
+	if (!bHasSpreadShot)
+	{
+		return true;
+	}
+
+	if (!OwningAbility)
+	{
+		return false;
+	}
+
+	const FPredictionKey ActivationPredictionKey = OwningAbility->GetCurrentActivationInfo().GetActivationPredictionKey();
+
+	// The client can't ask for a tighter cone than this weapon's best case. Allow for the quantization to hundredths of a degree.
+	const float MinSpread = BaseSpread * (bUseAimingSpreadMod ? FMath::Min(1.0f, AimingSpreadMod) : 1.0f);
+	const float MinConeHalfAngle = FMath::DegreesToRadians(FMath::Max(0.0f, MinSpread * 0.5f - 0.01f));
+	const int32 MaxHits = NumberOfTraces * FMath::Max(1, MaxHitResultsPerTrace);
+	const FVector HitResultTraceStart = StartLocation.GetTargetingTransform().GetLocation();
+
+	FGameplayAbilityTargetDataHandle ExpandedData;
+	TArray<FHitResult> ExpandedHitResults;
+
+	for (int32 DataIndex = 0; DataIndex < Data.Num(); DataIndex++)
+	{
+		const FGameplayAbilityTargetData* TargetData = Data.Get(DataIndex);
+		if (!TargetData || TargetData->GetScriptStruct() != FGSTargetData_SpreadShot::StaticStruct())
+		{
+			ExpandedData.Data.Add(Data.Data[DataIndex]);
+			continue;
+		}
+
+		const FGSTargetData_SpreadShot* SpreadShot = static_cast<const FGSTargetData_SpreadShot*>(TargetData);
+
+		if (SpreadShot->NumPellets != NumberOfTraces || SpreadShot->ConeHalfAngle < MinConeHalfAngle || SpreadShot->Hits.Num() > MaxHits)
+		{
+			ABILITY_LOG(Warning, TEXT("%s Rejected spread shot from %s that doesn't match the weapon"), *FString(__FUNCTION__), *GetNameSafe(SourceActor));
+			return false;
+		}
+
+		// Target data arrives reliably and in order, so every shot in an activation must have the next index. Accepting
+		// any higher index would let a client skip seeds until it found a tight cone.
+		const uint16 ExpectedShotIndex = ActivationPredictionKey.Current == LastAcceptedSpreadShotKey.Current ? (uint16)(LastAcceptedSpreadShotIndex + 1) : 0;
+		if (SpreadShot->ShotIndex != ExpectedShotIndex)
+		{
+			ABILITY_LOG(Warning, TEXT("%s Rejected spread shot %d from %s, expected shot %d"), *FString(__FUNCTION__), SpreadShot->ShotIndex, *GetNameSafe(SourceActor), ExpectedShotIndex);
+			return false;
+		}
+
+		for (const FGSSpreadShotHit& Hit : SpreadShot->Hits)
+		{
+			if (Hit.PelletIndex >= SpreadShot->NumPellets || Hit.Distance > MaxRange + 1.0f)
+			{
+				return false;
+			}
+		}
+
+		LastAcceptedSpreadShotKey = ActivationPredictionKey;
+		LastAcceptedSpreadShotIndex = SpreadShot->ShotIndex;
+
+		const int32 Seed = FGSTargetData_SpreadShot::MakeSpreadSeed(ActivationPredictionKey, SpreadShot->ShotIndex);
+		SpreadShot->ExpandToHitResults(Seed, MaxRange, HitResultTraceStart, ExpandedHitResults);
+
+		for (const FHitResult& HitResult : ExpandedHitResults)
+		{
+			/** Note: These are cleaned up by the FGameplayAbilityTargetDataHandle (via an internal TSharedPtr) */
+			ExpandedData.Add(new FGameplayAbilityTargetData_SingleTargetHit(HitResult));
+		}
+	}
+
+	Data = ExpandedData;
+	return true;
+}
+
+void AGSGATA_Trace::LogTargetDataBandwidth(const TArray<FHitResult>& HitResults, FGameplayAbilityTargetDataHandle& Data) const
+{
+	UNetConnection* Connection = MasterPC ? MasterPC->GetNetConnection() : nullptr;
+	UPackageMap* PackageMap = Connection ? Connection->PackageMap : nullptr;
+	if (!PackageMap)
+	{
+		return;
+	}
+
+	FGameplayAbilityTargetDataHandle SingleTargetHitData;
+	for (const FHitResult& HitResult : HitResults)
+	{
+		SingleTargetHitData.Add(new FGameplayAbilityTargetData_SingleTargetHit(HitResult));
+	}
+
+	bool bOutSuccess = false;
+
+	FNetBitWriter Writer(PackageMap, 0);
+	Data.NetSerialize(Writer, PackageMap, bOutSuccess);
+	const int64 DataBytes = Writer.GetNumBytes();
+
+	FNetBitWriter SingleTargetHitWriter(PackageMap, 0);
+	SingleTargetHitData.NetSerialize(SingleTargetHitWriter, PackageMap, bOutSuccess);
+	const int64 SingleTargetHitBytes = SingleTargetHitWriter.GetNumBytes();
+
+	SET_DWORD_STAT(STAT_GSTrace_TargetDataBytes, DataBytes);
+	SET_DWORD_STAT(STAT_GSTrace_SingleTargetHitBytes, SingleTargetHitBytes);
+
+	UE_LOG(LogGASShooterALS, Log, TEXT("%s %s %d HitResults: %lld bytes sent, %lld bytes as SingleTargetHits"), *FString(__FUNCTION__), *GetName(), HitResults.Num(), DataBytes, SingleTargetHitBytes);
+}
+
+bool AGSGATA_Trace::ShouldBatchMultiTraces() const
+{
+	// Persistent hits only ever do one trace
+	if (NumberOfTraces <= 1 || bUsePersistentHitResults)
+	{
+		return false;
+	}
+
+	const int32 BatchOverride = CVarBatchMultiTraces.GetValueOnGameThread();
+	return BatchOverride < 0 ? bBatchMultiTraces : BatchOverride > 0;
+}
+
+bool AGSGATA_Trace::ShouldUseAsyncTickTrace() const
+{
+	const int32 AsyncTickTraceOverride = CVarAsyncTickTrace.GetValueOnGameThread();
+	if (AsyncTickTraceOverride >= 0)
+	{
+		return AsyncTickTraceOverride > 0;
+	}
+
+	return bUseAsyncTickTrace;
+}
+
+void AGSGATA_Trace::PerformAsyncTickTrace(AActor* InSourceActor)
+{
+	SCOPE_CYCLE_COUNTER(STAT_GSTrace_AsyncTickTrace);
+
+	UWorld* World = GetWorld();
+	if (!InSourceActor || !World || !OwningAbility) // Server and launching client only
+	{
+		return;
+	}
+
+	const FCollisionQueryParams Params = MakeTraceQueryParams(InSourceActor);
+	const FVector TraceStart = GetTraceStartLocation();
+
+	// The world only runs one batch of async traces per frame, so at most one of each is ever in flight
+	if (!bAsyncAimTracePending)
+	{
+		FVector ViewStart;
+		GetAimViewPoint(TraceStart, ViewStart, AsyncAimViewDir, AsyncAimViewEnd);
+		AsyncAimTraceStart = TraceStart;
+
+		World->AsyncLineTraceByProfile(EAsyncTraceType::Multi, ViewStart, AsyncAimViewEnd, TraceProfile.Name, Params, &AsyncAimTraceDelegate, AsyncTraceGeneration);
+		bAsyncAimTracePending = true;
+		INC_DWORD_STAT(STAT_GSTrace_AsyncTracesQueued);
+	}
+
+	if (bHasAsyncAimDirection && !bAsyncTargetTracePending)
+	{
+		// Reminder: if bUsePersistentHitResults, Number of Traces = 1
+		const float ConeHalfAngle = FMath::DegreesToRadians(GetCurrentSpread() * 0.5f);
+		FRandomStream WeaponRandomStream(FMath::Rand());
+		const FVector ShootDir = WeaponRandomStream.VRandCone(AsyncAimDirection, ConeHalfAngle, ConeHalfAngle);
+
+		AsyncTargetTraceStart = TraceStart;
+		AsyncTargetTraceEnd = TraceStart + (ShootDir * MaxRange);
+
+		DoAsyncTrace(World, AsyncTargetTraceStart, AsyncTargetTraceEnd, TraceProfile.Name, Params, &AsyncTargetTraceDelegate, AsyncTraceGeneration);
+		bAsyncTargetTracePending = true;
+		INC_DWORD_STAT(STAT_GSTrace_AsyncTracesQueued);
+	}
+}
+
+void AGSGATA_Trace::OnAsyncAimTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	if (TraceDatum.UserData != AsyncTraceGeneration)
+	{
+		return;
+	}
+
+	bAsyncAimTracePending = false;
+
+	FilterHitResults(TraceDatum.OutHits, Filter, TraceDatum.End);
+
+	// Use first hit
+	AsyncAimDirection = AdjustAimDirection(AsyncAimTraceStart, AsyncAimViewDir, AsyncAimViewEnd, TraceDatum.OutHits.Num() > 0 ? &TraceDatum.OutHits[0] : nullptr);
+	bHasAsyncAimDirection = true;
+}
+
+void AGSGATA_Trace::OnAsyncTargetTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	if (TraceDatum.UserData != AsyncTraceGeneration)
+	{
+		return;
+	}
 
-	ActorsToIgnore.Add(InSourceActor);
+	bAsyncTargetTracePending = false;
 
+	if (!SourceActor)
+	{
+		return;
+	}
+
+	SetActorLocationAndRotation(AsyncTargetTraceEnd, SourceActor->GetActorRotation());
+	CurrentTraceEnd = AsyncTargetTraceEnd;
+
+	if (bUsePersistentHitResults)
+	{
+		PurgePersistentHitResults(AsyncTargetTraceStart);
+	}
+
+	TArray<FHitResult>& TraceHitResults = TraceDatum.OutHits;
+	FilterHitResults(TraceHitResults, Filter, AsyncTargetTraceEnd);
+	ProcessTraceHitResults(0, TraceHitResults, AsyncTargetTraceEnd);
+
+	if (bUsePersistentHitResults && MaxHitResultsPerTrace > 0)
+	{
+		UpdatePersistentReticles();
+
+		PersistentTargets.CopyTo(AsyncTickHitResults);
+	}
+	else
+	{
+		AsyncTickHitResults = MoveTemp(TraceHitResults);
+	}
+}
+
+void AGSGATA_Trace::ResetAsyncTickTrace()
+{
+	// Anything already queued completes with the old generation and is ignored
+	AsyncTraceGeneration++;
+	bAsyncAimTracePending = false;
+	bAsyncTargetTracePending = false;
+	bHasAsyncAimDirection = false;
+	AsyncTickHitResults.Reset();
+}
+
+FCollisionQueryParams AGSGATA_Trace::MakeTraceQueryParams(AActor* InSourceActor) const
+{
+	bool bTraceComplex = false;
+
+	// Ignored actors live in the params' inline storage
 	FCollisionQueryParams Params(SCENE_QUERY_STAT(AGSGATA_LineTrace), bTraceComplex);
 	Params.bReturnPhysicalMaterial = true;
-	Params.AddIgnoredActors(ActorsToIgnore);
+	Params.AddIgnoredActor(InSourceActor);
 	Params.bIgnoreBlocks = bIgnoreBlockingHits;
 
+	return Params;
+}
+
+FVector AGSGATA_Trace::GetTraceStartLocation() const
+{
 	FVector TraceStart = StartLocation.GetTargetingTransform().GetLocation();
-	FVector TraceEnd;
 
 	if (MasterPC)
 	{
@@ -345,196 +772,313 @@ TArray<FHitResult> AGSGATA_Trace::PerformTrace(AActor* InSourceActor)
 		TraceStart = bTraceFromPlayerViewPoint ? ViewStart : TraceStart;
 	}
 
-	if (bUsePersistentHitResults)
+	return TraceStart;
+}
+
+void AGSGATA_Trace::FilterHitResults(TArray<FHitResult>& InOutHitResults, const FGameplayTargetDataFilterHandle& FilterHandle, const FVector& End) const
+{
+	// Start param could be player ViewPoint. We want HitResult to always display the StartLocation.
+	const FVector TraceStart = StartLocation.GetTargetingTransform().GetLocation();
+
+	int32 NumKept = 0;
+	for (int32 HitIdx = 0; HitIdx < InOutHitResults.Num(); ++HitIdx)
 	{
-		// Clear any blocking hit results, invalid Actors, or actors out of range
-		//TODO Check for visibility if we add AIPerceptionComponent in the future
-		for (int32 i = PersistentHitResults.Num() - 1; i >= 0; i--)
+		FHitResult& Hit = InOutHitResults[HitIdx];
+
+		if (!Hit.Actor.IsValid() || FilterHandle.FilterPassesForActor(Hit.Actor))
 		{
-			FHitResult& HitResult = PersistentHitResults[i];
+			Hit.TraceStart = TraceStart;
+			Hit.TraceEnd = End;
 
-			if (HitResult.bBlockingHit || !HitResult.Actor.IsValid() || FVector::DistSquared(TraceStart, HitResult.Actor.Get()->GetActorLocation()) > (MaxRange * MaxRange))
+			if (NumKept != HitIdx)
 			{
-				PersistentHitResults.RemoveAt(i);
+				InOutHitResults[NumKept] = MoveTemp(Hit);
 			}
+			NumKept++;
 		}
 	}
 
-	TArray<FHitResult> ReturnHitResults;
+	InOutHitResults.SetNum(NumKept, false);
+}
 
-	for (int32 TraceIndex = 0; TraceIndex < NumberOfTraces; TraceIndex++)
+void AGSGATA_Trace::PurgePersistentHitResults(const FVector& TraceStart)
+{
+	// Clear any blocking hit results, invalid Actors, or actors out of range
+	//TODO Check for visibility if we add AIPerceptionComponent in the future
+	const float MaxRangeSquared = MaxRange * MaxRange;
+	PersistentTargets.RemoveAll([&TraceStart, MaxRangeSquared](const FHitResult& HitResult)
 	{
-		AimWithPlayerController(InSourceActor, Params, TraceStart, TraceEnd);		//Effective on server and launching client only
-
-		// ------------------------------------------------------
-
-		SetActorLocationAndRotation(TraceEnd, SourceActor->GetActorRotation());
+		return HitResult.bBlockingHit || !HitResult.Actor.IsValid() || FVector::DistSquared(TraceStart, HitResult.Actor.Get()->GetActorLocation()) > MaxRangeSquared;
+	});
+}
 
-		CurrentTraceEnd = TraceEnd;
+void AGSGATA_Trace::ProcessTraceHitResults(int32 TraceIndex, TArray<FHitResult>& TraceHitResults, const FVector& TraceEnd)
+{
+	for (int32 j = TraceHitResults.Num() - 1; j >= 0; j--)
+	{
+		if (MaxHitResultsPerTrace >= 0 && j + 1 > MaxHitResultsPerTrace)
+		{
+			// Trim to MaxHitResultsPerTrace without shrinking the scratch buffer
+			TraceHitResults.RemoveAt(j, 1, false);
+			continue;
+		}
 
-		TArray<FHitResult> TraceHitResults;
-		DoTrace(TraceHitResults, InSourceActor->GetWorld(), Filter, TraceStart, TraceEnd, TraceProfile.Name, Params);
+		FHitResult& HitResult = TraceHitResults[j];
 
-		for (int32 j = TraceHitResults.Num() - 1; j >= 0; j--)
+		// Reminder: if bUsePersistentHitResults, Number of Traces = 1
+		if (bUsePersistentHitResults)
 		{
-			if (MaxHitResultsPerTrace >= 0 && j + 1 > MaxHitResultsPerTrace)
+			// This is looping backwards so that further objects from player are added first to the queue.
+			// This results in closer actors taking precedence as the further actors will get bumped out of the tracker.
+			if (HitResult.Actor.IsValid() && (!HitResult.bBlockingHit || PersistentTargets.Num() < 1))
 			{
-				// Trim to MaxHitResultsPerTrace
-				TraceHitResults.RemoveAt(j);
-				continue;
+				// Already tracked Actors are skipped. When full, PersistentTargetEvictionPolicy picks the target to replace.
+				PersistentTargets.Add(HitResult, HitResult.TraceStart);
 			}
-
-			FHitResult& HitResult = TraceHitResults[j];
-
-			// Reminder: if bUsePersistentHitResults, Number of Traces = 1
-			if (bUsePersistentHitResults)
+		}
+		else
+		{
+			// ReticleActors for PersistentHitResults are handled later
+			int32 ReticleIndex = TraceIndex * MaxHitResultsPerTrace + j;
+			if (ReticleIndex < ReticleActors.Num())
 			{
-				// This is looping backwards so that further objects from player are added first to the queue.
-				// This results in closer actors taking precedence as the further actors will get bumped out of the TArray.
-				if (HitResult.Actor.IsValid() && (!HitResult.bBlockingHit || PersistentHitResults.Num() < 1))
+				if (AGameplayAbilityWorldReticle* LocalReticleActor = ReticleActors[ReticleIndex].Get())
 				{
-					bool bActorAlreadyInPersistentHits = false;
+					const bool bHitActor = HitResult.Actor != nullptr;
 
-					// Make sure PersistentHitResults doesn't have this hit actor already
-					for (int32 k = 0; k < PersistentHitResults.Num(); k++)
+					if (bHitActor && !HitResult.bBlockingHit)
 					{
-						FHitResult& PersistentHitResult = PersistentHitResults[k];
+						LocalReticleActor->SetActorHiddenInGame(false);
 
-						if (PersistentHitResult.Actor.Get() == HitResult.Actor.Get())
-						{
-							bActorAlreadyInPersistentHits = true;
-							break;
-						}
-					}
+						const FVector ReticleLocation = (bHitActor && LocalReticleActor->bSnapToTargetedActor) ? HitResult.Actor->GetActorLocation() : HitResult.Location;
 
-					if (bActorAlreadyInPersistentHits)
-					{
-						continue;
+						LocalReticleActor->SetActorLocation(ReticleLocation);
+						LocalReticleActor->SetIsTargetAnActor(bHitActor);
 					}
-
-					if (PersistentHitResults.Num() >= MaxHitResultsPerTrace)
+					else
 					{
-						// Treat PersistentHitResults like a queue, remove first element
-						PersistentHitResults.RemoveAt(0);
+						LocalReticleActor->SetActorHiddenInGame(true);
 					}
-
-					PersistentHitResults.Add(HitResult);
 				}
 			}
-			else
+		}
+	} // for TraceHitResults
+
+	if (!bUsePersistentHitResults)
+	{
+		if (TraceHitResults.Num() < ReticleActors.Num())
+		{
+			// We have less hit results than ReticleActors, hide the extra ones
+			for (int32 j = TraceHitResults.Num(); j < ReticleActors.Num(); j++)
 			{
-				// ReticleActors for PersistentHitResults are handled later
-				int32 ReticleIndex = TraceIndex * MaxHitResultsPerTrace + j;
-				if (ReticleIndex < ReticleActors.Num())
+				if (AGameplayAbilityWorldReticle* LocalReticleActor = ReticleActors[j].Get())
 				{
-					if (AGameplayAbilityWorldReticle* LocalReticleActor = ReticleActors[ReticleIndex].Get())
-					{
-						const bool bHitActor = HitResult.Actor != nullptr;
+					LocalReticleActor->SetIsTargetAnActor(false);
+					LocalReticleActor->SetActorHiddenInGame(true);
+				}
+			}
+		}
+	}
+
+	if (TraceHitResults.Num() < 1)
+	{
+		// If there were no hits, add a default HitResult at the end of the trace
+		FHitResult HitResult;
+		// Start param could be player ViewPoint. We want HitResult to always display the StartLocation.
+		HitResult.TraceStart = StartLocation.GetTargetingTransform().GetLocation();
+		HitResult.TraceEnd = TraceEnd;
+		HitResult.Location = TraceEnd;
+		HitResult.ImpactPoint = TraceEnd;
+		TraceHitResults.Add(HitResult);
+
+		if (bUsePersistentHitResults && PersistentTargets.Num() < 1)
+		{
+			PersistentTargets.Add(HitResult, HitResult.TraceStart);
+		}
+	}
+}
 
-						if (bHitActor && !HitResult.bBlockingHit)
-						{
-							LocalReticleActor->SetActorHiddenInGame(false);
+void AGSGATA_Trace::UpdatePersistentReticles()
+{
+	// Reminder: if bUsePersistentHitResults, Number of Traces = 1
+	for (int32 PersistentHitResultIndex = 0; PersistentHitResultIndex < PersistentTargets.Num(); PersistentHitResultIndex++)
+	{
+		FHitResult& HitResult = PersistentTargets[PersistentHitResultIndex];
 
-							const FVector ReticleLocation = (bHitActor && LocalReticleActor->bSnapToTargetedActor) ? HitResult.Actor->GetActorLocation() : HitResult.Location;
+		// Update TraceStart because old persistent HitResults will have their original TraceStart and the player could have moved since then
+		HitResult.TraceStart = StartLocation.GetTargetingTransform().GetLocation();
 
-							LocalReticleActor->SetActorLocation(ReticleLocation);
-							LocalReticleActor->SetIsTargetAnActor(bHitActor);
-						}
-						else
-						{
-							LocalReticleActor->SetActorHiddenInGame(true);
-						}
-					}
-				}
-			}
-		} // for TraceHitResults
+		if (!ReticleActors.IsValidIndex(PersistentHitResultIndex))
+		{
+			continue;
+		}
 
-		if (!bUsePersistentHitResults)
+		if (AGameplayAbilityWorldReticle* LocalReticleActor = ReticleActors[PersistentHitResultIndex].Get())
 		{
-			if (TraceHitResults.Num() < ReticleActors.Num())
+			const bool bHitActor = HitResult.Actor != nullptr;
+
+			if (bHitActor && !HitResult.bBlockingHit)
 			{
-				// We have less hit results than ReticleActors, hide the extra ones
-				for (int32 j = TraceHitResults.Num(); j < ReticleActors.Num(); j++)
-				{
-					if (AGameplayAbilityWorldReticle* LocalReticleActor = ReticleActors[j].Get())
-					{
-						LocalReticleActor->SetIsTargetAnActor(false);
-						LocalReticleActor->SetActorHiddenInGame(true);
-					}
-				}
+				LocalReticleActor->SetActorHiddenInGame(false);
+
+				const FVector ReticleLocation = (bHitActor && LocalReticleActor->bSnapToTargetedActor) ? HitResult.Actor->GetActorLocation() : HitResult.Location;
+
+				LocalReticleActor->SetActorLocation(ReticleLocation);
+				LocalReticleActor->SetIsTargetAnActor(bHitActor);
+			}
+			else
+			{
+				LocalReticleActor->SetActorHiddenInGame(true);
 			}
 		}
+	}
 
-		if (TraceHitResults.Num() < 1)
+	if (PersistentTargets.Num() < ReticleActors.Num())
+	{
+		// We have less hit results than ReticleActors, hide the extra ones
+		for (int32 PersistentHitResultIndex = PersistentTargets.Num(); PersistentHitResultIndex < ReticleActors.Num(); PersistentHitResultIndex++)
 		{
-			// If there were no hits, add a default HitResult at the end of the trace
-			FHitResult HitResult;
-			// Start param could be player ViewPoint. We want HitResult to always display the StartLocation.
-			HitResult.TraceStart = StartLocation.GetTargetingTransform().GetLocation();
-			HitResult.TraceEnd = TraceEnd;
-			HitResult.Location = TraceEnd;
-			HitResult.ImpactPoint = TraceEnd;
-			TraceHitResults.Add(HitResult);
-
-			if (bUsePersistentHitResults && PersistentHitResults.Num() < 1)
+			if (AGameplayAbilityWorldReticle* LocalReticleActor = ReticleActors[PersistentHitResultIndex].Get())
 			{
-				PersistentHitResults.Add(HitResult);
+				LocalReticleActor->SetIsTargetAnActor(false);
+				LocalReticleActor->SetActorHiddenInGame(true);
 			}
 		}
+	}
+}
 
-		ReturnHitResults.Append(TraceHitResults);
-	} // for NumberOfTraces
+const TArray<FHitResult>& AGSGATA_Trace::PerformTrace(AActor* InSourceActor)
+{
+	SCOPE_CYCLE_COUNTER(STAT_GSTrace_PerformTrace);
+	INC_DWORD_STAT_BY(STAT_GSTrace_Pellets, NumberOfTraces);
 
-	// Reminder: if bUsePersistentHitResults, Number of Traces = 1
-	if (bUsePersistentHitResults && MaxHitResultsPerTrace > 0)
+	const FCollisionQueryParams Params = MakeTraceQueryParams(InSourceActor);
+
+	FVector TraceStart = GetTraceStartLocation();
+	FVector TraceEnd;
+
+	if (bUsePersistentHitResults)
 	{
-		// Handle ReticleActors
-		for (int32 PersistentHitResultIndex = 0; PersistentHitResultIndex < PersistentHitResults.Num(); PersistentHitResultIndex++)
+		PurgePersistentHitResults(TraceStart);
+	}
+
+	TArray<FHitResult>& ReturnHitResults = PerformTraceHitResults;
+	ReturnHitResults.Reset();
+
+	const bool bSeededSpread = UsesSeededSpreadTargetData();
+	const bool bBatchTraces = bSeededSpread || ShouldBatchMultiTraces();
+	if (bBatchTraces)
+	{
+		// Aim once for the whole shot and generate every pellet direction up front
+		BatchTraceEnds.Reset(NumberOfTraces);
+		BatchHitPelletIndices.Reset();
+
+		FVector AimDir;
+		if (GetAdjustedAimDirection(InSourceActor, Params, TraceStart, AimDir))		//Effective on server and launching client only
 		{
-			FHitResult& HitResult = PersistentHitResults[PersistentHitResultIndex];
+			float ConeHalfAngle = FMath::DegreesToRadians(GetCurrentSpread() * 0.5f);
+			int32 RandomSeed = 0;
 
-			// Update TraceStart because old persistent HitResults will have their original TraceStart and the player could have moved since then
-			HitResult.TraceStart = StartLocation.GetTargetingTransform().GetLocation();
+			if (bSeededSpread)
+			{
+				// Trace exactly what the server will regenerate from FGSTargetData_SpreadShot
+				FGSTargetData_SpreadShot::QuantizeShot(TraceStart, AimDir, ConeHalfAngle);
+				RandomSeed = GetSpreadSeed();
 
-			if (AGameplayAbilityWorldReticle* LocalReticleActor = ReticleActors[PersistentHitResultIndex].Get())
+				LastShotOrigin = TraceStart;
+				LastShotAimDirection = AimDir;
+				LastShotConeHalfAngle = ConeHalfAngle;
+			}
+			else
 			{
-				const bool bHitActor = HitResult.Actor != nullptr;
+				RandomSeed = FMath::Rand();
+			}
 
-				if (bHitActor && !HitResult.bBlockingHit)
-				{
-					LocalReticleActor->SetActorHiddenInGame(false);
+			FRandomStream WeaponRandomStream(RandomSeed);
 
-					const FVector ReticleLocation = (bHitActor && LocalReticleActor->bSnapToTargetedActor) ? HitResult.Actor->GetActorLocation() : HitResult.Location;
+			for (int32 TraceIndex = 0; TraceIndex < NumberOfTraces; TraceIndex++)
+			{
+				BatchTraceEnds.Add(TraceStart + (WeaponRandomStream.VRandCone(AimDir, ConeHalfAngle, ConeHalfAngle) * MaxRange));
+			}
 
-					LocalReticleActor->SetActorLocation(ReticleLocation);
-					LocalReticleActor->SetIsTargetAnActor(bHitActor);
-				}
-				else
-				{
-					LocalReticleActor->SetActorHiddenInGame(true);
-				}
+			// Move once to the center of the cone instead of once per pellet
+			SetActorLocationAndRotation(TraceStart + (AimDir * MaxRange), SourceActor->GetActorRotation());
+		}
+
+		ReturnHitResults.Reserve(NumberOfTraces * FMath::Max(1, MaxHitResultsPerTrace));
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_GSTrace_PelletTraces);
+
+	for (int32 TraceIndex = 0; TraceIndex < NumberOfTraces; TraceIndex++)
+	{
+		if (bBatchTraces)
+		{
+			if (!BatchTraceEnds.IsValidIndex(TraceIndex))
+			{
+				// No OwningAbility to aim with
+				break;
 			}
+
+			TraceEnd = BatchTraceEnds[TraceIndex];
+		}
+		else
+		{
+			AimWithPlayerController(InSourceActor, Params, TraceStart, TraceEnd);		//Effective on server and launching client only
+
+			// ------------------------------------------------------
+
+			SetActorLocationAndRotation(TraceEnd, SourceActor->GetActorRotation());
 		}
 
-		if (PersistentHitResults.Num() < ReticleActors.Num())
+		CurrentTraceEnd = TraceEnd;
+
+		TArray<FHitResult>& TraceHitResults = PelletHitResults;
+		TraceHitResults.Reset();
+		DoTrace(TraceHitResults, InSourceActor->GetWorld(), Filter, TraceStart, TraceEnd, TraceProfile.Name, Params);
+
+		ProcessTraceHitResults(TraceIndex, TraceHitResults, TraceEnd);
+
+		if (bBatchTraces)
 		{
-			// We have less hit results than ReticleActors, hide the extra ones
-			for (int32 PersistentHitResultIndex = PersistentHitResults.Num(); PersistentHitResultIndex < ReticleActors.Num(); PersistentHitResultIndex++)
+			for (int32 j = 0; j < TraceHitResults.Num(); j++)
 			{
-				if (AGameplayAbilityWorldReticle* LocalReticleActor = ReticleActors[PersistentHitResultIndex].Get())
-				{
-					LocalReticleActor->SetIsTargetAnActor(false);
-					LocalReticleActor->SetActorHiddenInGame(true);
-				}
+				BatchHitPelletIndices.Add((uint8)TraceIndex);
 			}
 		}
 
-		return PersistentHitResults;
+		ReturnHitResults.Append(TraceHitResults);
+	} // for NumberOfTraces
+
+	// Reminder: if bUsePersistentHitResults, Number of Traces = 1
+	if (bUsePersistentHitResults && MaxHitResultsPerTrace > 0)
+	{
+		// Handle ReticleActors
+		UpdatePersistentReticles();
+
+		PersistentTargets.CopyTo(ReturnHitResults);
+		return ReturnHitResults;
 	}
 
 	return ReturnHitResults;
 }
 
+SIZE_T AGSGATA_Trace::GetTraceScratchAllocatedSize() const
+{
+	return PerformTraceHitResults.GetAllocatedSize() + PelletHitResults.GetAllocatedSize() + AimHitResults.GetAllocatedSize()
+		+ BatchTraceEnds.GetAllocatedSize() + BatchHitPelletIndices.GetAllocatedSize();
+}
+
+void AGSGATA_Trace::CheckTraceScratchGrowth(SIZE_T ScratchSizeBeforeTrace)
+{
+	const SIZE_T ScratchSizeAfterTrace = GetTraceScratchAllocatedSize();
+
+	if (ScratchSizeAfterTrace != ScratchSizeBeforeTrace)
+	{
+		INC_DWORD_STAT(STAT_GSTrace_ScratchGrowths);
+	}
+}
+
 AGameplayAbilityWorldReticle* AGSGATA_Trace::SpawnReticleActor(FVector Location, FRotator Rotation)
 {
 	if (ReticleClass)
@@ -546,6 +1090,8 @@ AGameplayAbilityWorldReticle* AGSGATA_Trace::SpawnReticleActor(FVector Location,
 			SpawnedReticleActor->SetActorHiddenInGame(true);
 			ReticleActors.Add(SpawnedReticleActor);
 
+			INC_DWORD_STAT(STAT_GSTrace_ReticlesSpawned);
+
 			// This is to catch cases of playing on a listen server where we are using a replicated reticle actor.
 			// (In a client controlled player, this would only run on the client and therefor never replicate. If it runs
 			// on a listen server, the reticle actor may replicate. We want consistancy between client/listen server players.
@@ -563,15 +1109,82 @@ AGameplayAbilityWorldReticle* AGSGATA_Trace::SpawnReticleActor(FVector Location,
 	return nullptr;
 }
 
+void AGSGATA_Trace::AcquireReticleActors(int32 NumReticles)
+{
+	ReleaseReticleActors();
+
+	if (!ReticleClass)
+	{
+		return;
+	}
+
+	// Drop reticles that were destroyed out from under us (e.g. level streaming)
+	ReticlePool.RemoveAllSwap([](const TWeakObjectPtr<AGameplayAbilityWorldReticle>& Reticle) { return !Reticle.IsValid(); }, false);
+
+	// A pooled reticle may have been made local only by targeting that didn't produce data on the server
+	const bool bReplicateReticles = ShouldProduceTargetDataOnServer && ReticleClass->GetDefaultObject<AActor>()->GetIsReplicated();
+
+	// One pass over the pool. Walking backwards keeps the swapped in elements ones we have already looked at.
+	// The pool can hold reticles of other classes if this TargetActor is configured by different abilities.
+	for (int32 PoolIndex = ReticlePool.Num() - 1; PoolIndex >= 0 && ReticleActors.Num() < NumReticles; PoolIndex--)
+	{
+		AGameplayAbilityWorldReticle* PooledReticleActor = ReticlePool[PoolIndex].Get();
+		if (PooledReticleActor->GetClass() != ReticleClass)
+		{
+			continue;
+		}
+
+		ReticlePool.RemoveAtSwap(PoolIndex, 1, false);
+
+		// Same setup as SpawnReticleActor(). The params and the replication rule may have changed since it was spawned.
+		PooledReticleActor->InitializeReticle(this, MasterPC, ReticleParams);
+		PooledReticleActor->SetActorHiddenInGame(true);
+		PooledReticleActor->SetIsTargetAnActor(false);
+		if (PooledReticleActor->GetIsReplicated() != bReplicateReticles)
+		{
+			PooledReticleActor->SetReplicates(bReplicateReticles);
+		}
+
+		ReticleActors.Add(PooledReticleActor);
+
+		INC_DWORD_STAT(STAT_GSTrace_ReticlesReused);
+	}
+
+	while (ReticleActors.Num() < NumReticles)
+	{
+		if (!SpawnReticleActor(GetActorLocation(), GetActorRotation()))
+		{
+			break;
+		}
+	}
+}
+
+void AGSGATA_Trace::ReleaseReticleActors()
+{
+	for (const TWeakObjectPtr<AGameplayAbilityWorldReticle>& Reticle : ReticleActors)
+	{
+		if (AGameplayAbilityWorldReticle* LocalReticleActor = Reticle.Get())
+		{
+			LocalReticleActor->SetIsTargetAnActor(false);
+			LocalReticleActor->SetActorHiddenInGame(true);
+			ReticlePool.Add(LocalReticleActor);
+		}
+	}
+
+	ReticleActors.Reset();
+}
+
 void AGSGATA_Trace::DestroyReticleActors()
 {
-	for (int32 i = ReticleActors.Num() - 1; i >= 0; i--)
+	ReleaseReticleActors();
+
+	for (int32 i = ReticlePool.Num() - 1; i >= 0; i--)
 	{
-		if (ReticleActors[i].IsValid())
+		if (ReticlePool[i].IsValid())
 		{
-			ReticleActors[i].Get()->Destroy();
+			ReticlePool[i].Get()->Destroy();
 		}
 	}
 
-	ReticleActors.Empty();
+	ReticlePool.Empty();
 }
@@ -22,6 +22,7 @@ UGSGameplayAbility::UGSGameplayAbility()
 	bActivateOnInput = true;
 	bSourceObjectMustEqualCurrentWeaponToActivate = false;
 	bCannotActivateWhileInteracting = true;
+	bBundleTargetData = false;
 
 	// UGSAbilitySystemGlobals hasn't initialized tags yet to set ActivationBlockedTags
 	ActivationBlockedTags.AddTag(FGameplayTag::RequestGameplayTag("State.Dead"));
@@ -37,6 +38,10 @@ void UGSGameplayAbility::OnAvatarSet(const FGameplayAbilityActorInfo* ActorInfo,
 {
 	Super::OnAvatarSet(ActorInfo, Spec);
 
+	// The previous avatar's meshes are gone
+	CurrentAbilityMeshMontages.Reset();
+	AbilityMeshMontageSlotByMesh.Reset();
+
 	if (bActivateAbilityOnGranted)
 	{
 		bool ActivatedAbility = ActorInfo->AbilitySystemComponent->TryActivateAbility(Spec.Handle, false);
@@ -61,7 +66,7 @@ FGameplayAbilityTargetDataHandle UGSGameplayAbility::MakeGameplayAbilityTargetDa
 
 	for (const FHitResult& HitResult : HitResults)
 	{
-		FGameplayAbilityTargetData_SingleTargetHit* NewData = new FGameplayAbilityTargetData_SingleTargetHit(HitResult);
+		FGSTargetData_CompactHit* NewData = new FGSTargetData_CompactHit(HitResult);
 		TargetData.Add(NewData);
 	}
 
@@ -193,6 +198,26 @@ bool UGSGameplayAbility::CanActivateAbility(const FGameplayAbilitySpecHandle Han
 	return Super::CanActivateAbility(Handle, ActorInfo, SourceTags, TargetTags, OptionalRelevantTags);
 }
 
+void UGSGameplayAbility::CancelAbility(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo, bool bReplicateCancelAbility)
+{
+	if (UGSAbilitySystemComponent* GSASC = ActorInfo ? Cast<UGSAbilitySystemComponent>(ActorInfo->AbilitySystemComponent.Get()) : nullptr)
+	{
+		GSASC->FlushTargetDataBundles();
+	}
+
+	Super::CancelAbility(Handle, ActorInfo, ActivationInfo, bReplicateCancelAbility);
+}
+
+void UGSGameplayAbility::EndAbility(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo, bool bReplicateEndAbility, bool bWasCancelled)
+{
+	if (UGSAbilitySystemComponent* GSASC = ActorInfo ? Cast<UGSAbilitySystemComponent>(ActorInfo->AbilitySystemComponent.Get()) : nullptr)
+	{
+		GSASC->FlushTargetDataBundles();
+	}
+
+	Super::EndAbility(Handle, ActorInfo, ActivationInfo, bReplicateEndAbility, bWasCancelled);
+}
+
 bool UGSGameplayAbility::CheckCost(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, OUT FGameplayTagContainer* OptionalRelevantTags) const
 {
 	return Super::CheckCost(Handle, ActorInfo, OptionalRelevantTags) && GSCheckCost(Handle, *ActorInfo);
@@ -245,8 +270,14 @@ void UGSGameplayAbility::SendTargetDataToServer(const FGameplayAbilityTargetData
 		FScopedPredictionWindow	ScopedPrediction(ASC, IsPredictingClient());
 
 		FGameplayTag ApplicationTag; // Fixme: where would this be useful?
-		CurrentActorInfo->AbilitySystemComponent->CallServerSetReplicatedTargetData(CurrentSpecHandle,
-			CurrentActivationInfo.GetActivationPredictionKey(), TargetData, ApplicationTag, ASC->ScopedPredictionKey);
+		if (UGSAbilitySystemComponent* GSASC = Cast<UGSAbilitySystemComponent>(ASC))
+		{
+			GSASC->SendTargetDataToServer(CurrentSpecHandle, CurrentActivationInfo.GetActivationPredictionKey(), TargetData, ApplicationTag, ASC->ScopedPredictionKey);
+		}
+		else
+		{
+			ASC->CallServerSetReplicatedTargetData(CurrentSpecHandle, CurrentActivationInfo.GetActivationPredictionKey(), TargetData, ApplicationTag, ASC->ScopedPredictionKey);
+		}
 	}
 }
 
@@ -258,44 +289,42 @@ bool UGSGameplayAbility::IsInputPressed() const
 
 UAnimMontage* UGSGameplayAbility::GetCurrentMontageForMesh(USkeletalMeshComponent* InMesh)
 {
-	FAbilityMeshMontage AbilityMeshMontage;
-	if (FindAbillityMeshMontage(InMesh, AbilityMeshMontage))
-	{
-		return AbilityMeshMontage.Montage;
-	}
-
-	return nullptr;
+	const FAbilityMeshMontage* AbilityMeshMontage = FindAbillityMeshMontage(InMesh);
+	return AbilityMeshMontage ? AbilityMeshMontage->Montage : nullptr;
 }
 
 void UGSGameplayAbility::SetCurrentMontageForMesh(USkeletalMeshComponent* InMesh, UAnimMontage* InCurrentMontage)
 {
 	ensure(IsInstantiated());
 
-	FAbilityMeshMontage AbilityMeshMontage;
-	if (FindAbillityMeshMontage(InMesh, AbilityMeshMontage))
+	if (FAbilityMeshMontage* AbilityMeshMontage = FindAbillityMeshMontage(InMesh))
 	{
-		AbilityMeshMontage.Montage = InCurrentMontage;
+		AbilityMeshMontage->Montage = InCurrentMontage;
 	}
 	else
 	{
-		CurrentAbilityMeshMontages.Add(FAbilityMeshMontage(InMesh, InCurrentMontage));
+		const int32 Slot = CurrentAbilityMeshMontages.Add(FAbilityMeshMontage(InMesh, InCurrentMontage));
+		AbilityMeshMontageSlotByMesh.Add(InMesh, Slot);
 	}
 }
 
 bool UGSGameplayAbility::FindAbillityMeshMontage(USkeletalMeshComponent* InMesh, FAbilityMeshMontage& InAbilityMeshMontage)
 {
-	for (FAbilityMeshMontage& MeshMontage : CurrentAbilityMeshMontages)
+	if (const FAbilityMeshMontage* AbilityMeshMontage = FindAbillityMeshMontage(InMesh))
 	{
-		if (MeshMontage.Mesh == InMesh)
-		{
-			InAbilityMeshMontage = MeshMontage;
-			return true;
-		}
+		InAbilityMeshMontage = *AbilityMeshMontage;
+		return true;
 	}
 
 	return false;
 }
 
+FAbilityMeshMontage* UGSGameplayAbility::FindAbillityMeshMontage(const USkeletalMeshComponent* InMesh)
+{
+	const int32* Slot = AbilityMeshMontageSlotByMesh.Find(MakeWeakObjectPtr(InMesh));
+	return Slot ? &CurrentAbilityMeshMontages[*Slot] : nullptr;
+}
+
 void UGSGameplayAbility::MontageJumpToSectionForMesh(USkeletalMeshComponent* InMesh, FName SectionName)
 {
 	check(CurrentActorInfo);
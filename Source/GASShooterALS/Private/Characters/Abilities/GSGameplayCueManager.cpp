@@ -2,4 +2,548 @@
 
 
 #include "Characters/Abilities/GSGameplayCueManager.h"
+#include "AbilitySystemGlobals.h"
+#include "Characters/Abilities/GSAbilitySystemGlobals.h"
+#include "Characters/Abilities/GSGameplayCueManifest.h"
+#include "Engine/AssetManager.h"
+#include "Engine/World.h"
+#include "GameplayCueNotify_Actor.h"
+#include "GameplayCueSet.h"
+#include "GASShooterALS/GASShooterALS.h"
+#include "HAL/IConsoleManager.h"
+#include "Weapons/GSWeapon.h"
 
+DECLARE_DWORD_COUNTER_STAT(TEXT("Local Cues Queued"), STAT_GSGameplayCues_LocalCuesQueued, STATGROUP_GSGameplayCues);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Local Cues Merged"), STAT_GSGameplayCues_LocalCuesMerged, STATGROUP_GSGameplayCues);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Local Cues Per Frame"), STAT_GSGameplayCues_LocalCuesPerFrame, STATGROUP_GSGameplayCues);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Cue Actors Reused"), STAT_GSGameplayCues_CueActorsReused, STATGROUP_GSGameplayCues);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Cue Actors Released"), STAT_GSGameplayCues_CueActorsReleased, STATGROUP_GSGameplayCues);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Cue Actors Pooled"), STAT_GSGameplayCues_CueActorsPooled, STATGROUP_GSGameplayCues);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Cue Notifies Preloaded"), STAT_GSGameplayCues_NotifiesPreloaded, STATGROUP_GSGameplayCues);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Cue Loads On First Use"), STAT_GSGameplayCues_LoadsOnFirstUse, STATGROUP_GSGameplayCues);
+
+static TAutoConsoleVariable<int32> CVarBatchLocalCues(
+	TEXT("GS.Cue.BatchLocalCues"),
+	1,
+	TEXT("Queue local gameplay cues and handle them once at the end of the frame, merging duplicates. 0 handles them as soon as they're triggered.")
+);
+
+static TAutoConsoleVariable<float> CVarLocalCueMergeDistance(
+	TEXT("GS.Cue.MergeDistance"),
+	10.0f,
+	TEXT("Distance (cm) within which two executions of the same local cue on the same target in one frame are merged into one")
+);
+
+static TAutoConsoleVariable<int32> CVarMaxPooledCueActorsPerClass(
+	TEXT("GS.Cue.MaxPooledActorsPerClass"),
+	16,
+	TEXT("Most finished GameplayCueNotify actors of one class kept for recycling. Finished actors past this are destroyed. -1 keeps all of them.")
+);
+
+#if !UE_BUILD_SHIPPING
+static TAutoConsoleVariable<int32> CVarRecordCueManifest(
+	TEXT("GS.Cue.RecordManifest"),
+	0,
+	TEXT("Record which GameplayCues each map, weapon and ability uses. Save them to the manifest with GS.Cue.SaveManifest.")
+);
+
+static FAutoConsoleCommand CmdSaveCueManifest(
+	TEXT("GS.Cue.SaveManifest"),
+	TEXT("Merges the cues recorded with GS.Cue.RecordManifest into the GameplayCue manifest. The config manifest is written to DefaultGame.ini, a manifest asset has to be saved afterwards."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		if (UGSGameplayCueManager* CueManager = Cast<UGSGameplayCueManager>(UAbilitySystemGlobals::Get().GetGameplayCueManager()))
+		{
+			CueManager->SaveRecordedManifest();
+		}
+	})
+);
+#endif // !UE_BUILD_SHIPPING
+
+static FAutoConsoleCommand CmdCuePreloadReport(
+	TEXT("GS.Cue.PreloadReport"),
+	TEXT("Logs how many GameplayCue notifies were preloaded for this map and which cues still had to be loaded on first use"),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		if (UGSGameplayCueManager* CueManager = Cast<UGSGameplayCueManager>(UAbilitySystemGlobals::Get().GetGameplayCueManager()))
+		{
+			CueManager->LogPreloadReport();
+		}
+	})
+);
+
+void UGSGameplayCueManager::OnCreated()
+{
+	Super::OnCreated();
+
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UGSGameplayCueManager::OnWorldPostActorTick);
+	WorldCleanupHandle = FWorldDelegates::OnWorldCleanup.AddUObject(this, &UGSGameplayCueManager::OnWorldCleanup);
+	WorldInitializedHandle = FWorldDelegates::OnPostWorldInitialization.AddUObject(this, &UGSGameplayCueManager::OnWorldInitialized);
+}
+
+void UGSGameplayCueManager::BeginDestroy()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	FWorldDelegates::OnWorldCleanup.Remove(WorldCleanupHandle);
+	FWorldDelegates::OnPostWorldInitialization.Remove(WorldInitializedHandle);
+
+	Super::BeginDestroy();
+}
+
+void UGSGameplayCueManager::HandleGameplayCue(AActor* TargetActor, FGameplayTag GameplayCueTag, EGameplayCueEvent::Type EventType, const FGameplayCueParameters& Parameters, EGameplayCueExecutionOptions Options)
+{
+#if !UE_BUILD_SHIPPING
+	if (CVarRecordCueManifest.GetValueOnGameThread() != 0)
+	{
+		RecordGameplayCue(TargetActor, GameplayCueTag, Parameters);
+	}
+#endif
+
+	if (IsRunningDedicatedServer() || LoadedCues.Contains(GameplayCueTag) || CueFirstUseSeconds.Contains(GameplayCueTag) || PendingFirstUseLoads.Contains(GameplayCueTag))
+	{
+		Super::HandleGameplayCue(TargetActor, GameplayCueTag, EventType, Parameters, Options);
+		return;
+	}
+
+	TArray<FSoftObjectPath> UnloadedPaths;
+	GetNotifyPaths(GameplayCueTag, UnloadedPaths, true);
+	if (UnloadedPaths.Num() == 0)
+	{
+		LoadedCues.Add(GameplayCueTag);
+		Super::HandleGameplayCue(TargetActor, GameplayCueTag, EventType, Parameters, Options);
+		return;
+	}
+
+	// This is the load the manifest is meant to prevent. Time it so a missing manifest entry shows up.
+	INC_DWORD_STAT(STAT_GSGameplayCues_LoadsOnFirstUse);
+	const double StartTime = FPlatformTime::Seconds();
+	Super::HandleGameplayCue(TargetActor, GameplayCueTag, EventType, Parameters, Options);
+
+	UnloadedPaths.Reset();
+	GetNotifyPaths(GameplayCueTag, UnloadedPaths, true);
+	if (UnloadedPaths.Num() == 0)
+	{
+		// Loaded synchronously, the game thread was blocked the whole time
+		OnFirstUseLoadComplete(GameplayCueTag, StartTime, false);
+		return;
+	}
+
+	// By default missing cues are async loaded and played once they're in, late instead of with a hitch. Ours joins the
+	// engine's request, so its callback runs when the notifies have actually loaded.
+	PendingFirstUseLoads.Add(GameplayCueTag);
+	UAssetManager::GetStreamableManager().RequestAsyncLoad(UnloadedPaths,
+		FStreamableDelegate::CreateUObject(this, &UGSGameplayCueManager::OnFirstUseLoadComplete, GameplayCueTag, StartTime, true));
+}
+
+void UGSGameplayCueManager::OnFirstUseLoadComplete(FGameplayTag GameplayCueTag, double StartTime, bool bAsync)
+{
+	// A load requested before the last map change
+	if (bAsync && PendingFirstUseLoads.Remove(GameplayCueTag) == 0)
+	{
+		return;
+	}
+
+	const double Seconds = FPlatformTime::Seconds() - StartTime;
+	CueFirstUseSeconds.Add(GameplayCueTag, Seconds);
+	if (bAsync)
+	{
+		AsyncFirstUseCues.Add(GameplayCueTag);
+	}
+
+	UE_LOG(LogGASShooterALS, Log, TEXT("%s %s wasn't preloaded. Loading it on first use took %.2f ms, %s."), *FString(__FUNCTION__), *GameplayCueTag.ToString(), Seconds * 1000.0,
+		bAsync ? TEXT("asynchronously so the cue played that late") : TEXT("synchronously so the game thread hitched"));
+}
+
+void UGSGameplayCueManager::PreloadGameplayCuesForWeapon(const AGSWeapon* Weapon)
+{
+	UGSGameplayCueManager* CueManager = Cast<UGSGameplayCueManager>(UAbilitySystemGlobals::Get().GetGameplayCueManager());
+	UGSGameplayCueManifest* CueManifest = CueManager && Weapon && !IsRunningDedicatedServer() ? CueManager->GetManifest() : nullptr;
+	if (!CueManifest)
+	{
+		return;
+	}
+
+	FGameplayTagContainer Cues;
+	CueManifest->GetCuesForWeapon(Weapon, Cues);
+	CueManager->PreloadGameplayCues(Cues, Weapon->GetClass()->GetName());
+}
+
+void UGSGameplayCueManager::PreloadGameplayCues(const FGameplayTagContainer& Cues, const FString& Reason)
+{
+	if (IsRunningDedicatedServer())
+	{
+		return;
+	}
+
+	// Loaded notifies are requested too so the handle keeps them from being garbage collected
+	TArray<FSoftObjectPath> Paths;
+	for (const FGameplayTag& Cue : Cues)
+	{
+		if (!PreloadedCues.HasTagExact(Cue))
+		{
+			PreloadedCues.AddTagFast(Cue);
+			GetNotifyPaths(Cue, Paths, false);
+		}
+	}
+
+	if (Paths.Num() == 0)
+	{
+		return;
+	}
+
+	INC_DWORD_STAT_BY(STAT_GSGameplayCues_NotifiesPreloaded, Paths.Num());
+
+	TSharedPtr<FStreamableHandle> Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(Paths,
+		FStreamableDelegate::CreateUObject(this, &UGSGameplayCueManager::OnCuePreloadComplete, Reason, Paths.Num(), FPlatformTime::Seconds()));
+	if (Handle.IsValid())
+	{
+		CuePreloadHandles.Add(Handle);
+	}
+}
+
+void UGSGameplayCueManager::OnCuePreloadComplete(FString Reason, int32 NumNotifies, double StartTime)
+{
+	UE_LOG(LogGASShooterALS, Log, TEXT("%s Preloaded %d GameplayCue notifies for %s in %.2f ms"), *FString(__FUNCTION__), NumNotifies, *Reason,
+		(FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
+
+UGSGameplayCueManifest* UGSGameplayCueManager::GetManifest()
+{
+	if (!bManifestLoaded)
+	{
+		bManifestLoaded = true;
+
+		const FSoftObjectPath& ManifestName = UGSAbilitySystemGlobals::GSGet().GameplayCueManifestName;
+		if (ManifestName.IsValid())
+		{
+			Manifest = Cast<UGSGameplayCueManifest>(ManifestName.TryLoad());
+			if (!Manifest)
+			{
+				UE_LOG(LogGASShooterALS, Warning, TEXT("%s GameplayCueManifestName %s isn't a UGSGameplayCueManifest"), *FString(__FUNCTION__), *ManifestName.ToString());
+			}
+		}
+		else
+		{
+			// The manifest recorded into DefaultGame.ini
+			Manifest = GetMutableDefault<UGSGameplayCueManifest>();
+		}
+	}
+
+	return Manifest;
+}
+
+void UGSGameplayCueManager::GetNotifyPaths(FGameplayTag GameplayCueTag, TArray<FSoftObjectPath>& OutPaths, bool bOnlyUnloaded)
+{
+	const UGameplayCueSet* CueSet = GetRuntimeCueSet();
+	const int32* DataIndex = CueSet ? CueSet->GameplayCueDataMap.Find(GameplayCueTag) : nullptr;
+	if (!DataIndex)
+	{
+		return;
+	}
+
+	// Parent cues are handled along with their children unless the child overrides them
+	for (int32 Index = *DataIndex; CueSet->GameplayCueData.IsValidIndex(Index); Index = CueSet->GameplayCueData[Index].ParentDataIdx)
+	{
+		const FGameplayCueNotifyData& Data = CueSet->GameplayCueData[Index];
+		if (!Data.GameplayCueNotifyObj.IsValid())
+		{
+			continue;
+		}
+
+		if (!bOnlyUnloaded || (!Data.LoadedGameplayCueClass && !Data.GameplayCueNotifyObj.ResolveObject()))
+		{
+			OutPaths.AddUnique(Data.GameplayCueNotifyObj);
+		}
+	}
+}
+
+void UGSGameplayCueManager::RecordGameplayCue(AActor* TargetActor, FGameplayTag GameplayCueTag, const FGameplayCueParameters& Parameters)
+{
+	if (!RecordedManifest)
+	{
+		// Starts out with the config manifest's cues, only record what's played from here on
+		RecordedManifest = NewObject<UGSGameplayCueManifest>(this);
+		RecordedManifest->Reset();
+	}
+
+	if (UWorld* World = TargetActor ? TargetActor->GetWorld() : nullptr)
+	{
+		RecordedManifest->CuesByMap.FindOrAdd(UGSGameplayCueManifest::GetMapKey(World)).AddTag(GameplayCueTag);
+	}
+
+	// Weapon cues carry the weapon in one of these depending on whether an effect, an ability or a Blueprint sent them
+	const UObject* Sources[] = { Parameters.SourceObject.Get(), Parameters.EffectCauser.Get(), Parameters.EffectContext.GetSourceObject(), Parameters.EffectContext.GetEffectCauser(), TargetActor };
+	for (const UObject* Source : Sources)
+	{
+		if (const AGSWeapon* Weapon = Cast<AGSWeapon>(Source))
+		{
+			RecordedManifest->CuesByWeapon.FindOrAdd(TSoftClassPtr<AGSWeapon>(Weapon->GetClass())).AddTag(GameplayCueTag);
+			break;
+		}
+	}
+
+	if (const UGameplayAbility* Ability = Parameters.EffectContext.GetAbility())
+	{
+		RecordedManifest->CuesByAbility.FindOrAdd(TSoftClassPtr<UGameplayAbility>(Ability->GetClass())).AddTag(GameplayCueTag);
+	}
+}
+
+void UGSGameplayCueManager::SaveRecordedManifest()
+{
+	if (!RecordedManifest)
+	{
+		UE_LOG(LogGASShooterALS, Warning, TEXT("%s Nothing recorded. Set GS.Cue.RecordManifest 1 and play first."), *FString(__FUNCTION__));
+		return;
+	}
+
+#if WITH_EDITOR
+	if (UGSGameplayCueManifest* CueManifest = GetManifest())
+	{
+		const int32 NumAdded = CueManifest->Append(*RecordedManifest);
+		if (NumAdded > 0)
+		{
+			if (CueManifest->HasAnyFlags(RF_ClassDefaultObject))
+			{
+				CueManifest->TryUpdateDefaultConfigFile();
+			}
+			else
+			{
+				CueManifest->MarkPackageDirty();
+			}
+		}
+
+		UE_LOG(LogGASShooterALS, Log, TEXT("%s Added %d cues to %s"), *FString(__FUNCTION__), NumAdded, *CueManifest->GetPathName());
+		RecordedManifest->Reset();
+		return;
+	}
+#endif
+
+	// No asset to write to, log it so it can be copied over by hand
+	for (const TPair<FName, FGameplayTagContainer>& Pair : RecordedManifest->CuesByMap)
+	{
+		UE_LOG(LogGASShooterALS, Log, TEXT("%s Map %s: %s"), *FString(__FUNCTION__), *Pair.Key.ToString(), *Pair.Value.ToStringSimple());
+	}
+
+	for (const TPair<TSoftClassPtr<AGSWeapon>, FGameplayTagContainer>& Pair : RecordedManifest->CuesByWeapon)
+	{
+		UE_LOG(LogGASShooterALS, Log, TEXT("%s Weapon %s: %s"), *FString(__FUNCTION__), *Pair.Key.ToString(), *Pair.Value.ToStringSimple());
+	}
+
+	for (const TPair<TSoftClassPtr<UGameplayAbility>, FGameplayTagContainer>& Pair : RecordedManifest->CuesByAbility)
+	{
+		UE_LOG(LogGASShooterALS, Log, TEXT("%s Ability %s: %s"), *FString(__FUNCTION__), *Pair.Key.ToString(), *Pair.Value.ToStringSimple());
+	}
+}
+
+void UGSGameplayCueManager::LogPreloadReport() const
+{
+	double TotalSeconds = 0.0;
+	double WorstSeconds = 0.0;
+	for (const TPair<FGameplayTag, double>& Pair : CueFirstUseSeconds)
+	{
+		TotalSeconds += Pair.Value;
+		WorstSeconds = FMath::Max(WorstSeconds, Pair.Value);
+		UE_LOG(LogGASShooterALS, Log, TEXT("GS.Cue.PreloadReport: %s loaded on first use, %.2f ms %s"), *Pair.Key.ToString(), Pair.Value * 1000.0,
+			AsyncFirstUseCues.Contains(Pair.Key) ? TEXT("late") : TEXT("hitch"));
+	}
+
+	UE_LOG(LogGASShooterALS, Log, TEXT("GS.Cue.PreloadReport: %d cues preloaded, %d loaded on first use taking %.2f ms in total and %.2f ms at worst"),
+		PreloadedCues.Num(), CueFirstUseSeconds.Num(), TotalSeconds * 1000.0, WorstSeconds * 1000.0);
+}
+
+void UGSGameplayCueManager::OnWorldInitialized(UWorld* World, const UWorld::InitializationValues IVS)
+{
+	if (!World || !World->IsGameWorld() || IsRunningDedicatedServer())
+	{
+		return;
+	}
+
+	// Release the last map's cues only after requesting this one's so the ones both use stay loaded
+	TArray<TSharedPtr<FStreamableHandle>> PreviousHandles = MoveTemp(CuePreloadHandles);
+	CuePreloadHandles.Reset();
+	PreloadedCues.Reset();
+	LoadedCues.Reset();
+	CueFirstUseSeconds.Reset();
+	AsyncFirstUseCues.Reset();
+	PendingFirstUseLoads.Reset();
+
+	if (UGSGameplayCueManifest* CueManifest = GetManifest())
+	{
+		FGameplayTagContainer Cues;
+		CueManifest->GetCuesForMap(World, Cues);
+		PreloadGameplayCues(Cues, UGSGameplayCueManifest::GetMapKey(World).ToString());
+	}
+
+	for (TSharedPtr<FStreamableHandle>& Handle : PreviousHandles)
+	{
+		Handle->ReleaseHandle();
+	}
+}
+
+void UGSGameplayCueManager::HandleLocalGameplayCue(AActor* TargetActor, FGameplayTag GameplayCueTag, EGameplayCueEvent::Type EventType, const FGameplayCueParameters& Parameters)
+{
+	UGameplayCueManager* CueManager = UAbilitySystemGlobals::Get().GetGameplayCueManager();
+	if (UGSGameplayCueManager* GSCueManager = Cast<UGSGameplayCueManager>(CueManager))
+	{
+		GSCueManager->QueueLocalGameplayCue(TargetActor, GameplayCueTag, EventType, Parameters);
+	}
+	else if (CueManager)
+	{
+		CueManager->HandleGameplayCue(TargetActor, GameplayCueTag, EventType, Parameters);
+	}
+}
+
+void UGSGameplayCueManager::QueueLocalGameplayCue(AActor* TargetActor, FGameplayTag GameplayCueTag, EGameplayCueEvent::Type EventType, const FGameplayCueParameters& Parameters)
+{
+	UWorld* World = TargetActor ? TargetActor->GetWorld() : nullptr;
+	if (!World || !World->IsGameWorld() || CVarBatchLocalCues.GetValueOnGameThread() == 0)
+	{
+		HandleGameplayCue(TargetActor, GameplayCueTag, EventType, Parameters);
+		return;
+	}
+
+	INC_DWORD_STAT(STAT_GSGameplayCues_LocalCuesQueued);
+
+	FGSQueuedLocalGameplayCue Cue;
+	Cue.TargetActor = TargetActor;
+	Cue.GameplayCueTag = GameplayCueTag;
+	Cue.EventType = EventType;
+	Cue.Parameters = Parameters;
+
+	FGSLocalGameplayCueQueue& Queue = LocalCueQueues.FindOrAdd(World);
+	if (MergeQueuedLocalGameplayCue(Queue, Cue))
+	{
+		INC_DWORD_STAT(STAT_GSGameplayCues_LocalCuesMerged);
+		return;
+	}
+
+	const int32 Index = Queue.Cues.Add(Cue);
+	Queue.LatestEventsByTargetAndTag.FindOrAdd(TPair<const AActor*, FGameplayTag>(TargetActor, GameplayCueTag)).Index[EventType] = Index;
+}
+
+bool UGSGameplayCueManager::MergeQueuedLocalGameplayCue(FGSLocalGameplayCueQueue& Queue, const FGSQueuedLocalGameplayCue& Cue) const
+{
+	FGSLocalGameplayCueQueue::FLatestEvents* Latest = Queue.LatestEventsByTargetAndTag.Find(TPair<const AActor*, FGameplayTag>(Cue.TargetActor.Get(), Cue.GameplayCueTag));
+	if (!Latest || Latest->Index[Cue.EventType] == INDEX_NONE)
+	{
+		return false;
+	}
+
+	FGSQueuedLocalGameplayCue& QueuedCue = Queue.Cues[Latest->Index[Cue.EventType]];
+
+	switch (Cue.EventType)
+	{
+	case EGameplayCueEvent::Executed:
+	{
+		// Two hits on the same spot in one frame look like one. Hits further apart still get their own cue.
+		const float MergeDistance = CVarLocalCueMergeDistance.GetValueOnGameThread();
+		if (FVector::DistSquared(QueuedCue.Parameters.Location, Cue.Parameters.Location) > FMath::Square(MergeDistance))
+		{
+			return false;
+		}
+
+		// Keep the bigger hit rather than the sum so a merged cue never plays stronger than any single hit would have
+		QueuedCue.Parameters.RawMagnitude = FMath::Max(QueuedCue.Parameters.RawMagnitude, Cue.Parameters.RawMagnitude);
+		QueuedCue.Parameters.NormalizedMagnitude = FMath::Max(QueuedCue.Parameters.NormalizedMagnitude, Cue.Parameters.NormalizedMagnitude);
+		return true;
+	}
+	case EGameplayCueEvent::OnActive:
+	case EGameplayCueEvent::WhileActive:
+		// Adding again is a no-op unless it was removed in between
+		return Latest->Index[EGameplayCueEvent::Removed] < Latest->Index[Cue.EventType];
+	case EGameplayCueEvent::Removed:
+		return FMath::Max(Latest->Index[EGameplayCueEvent::OnActive], Latest->Index[EGameplayCueEvent::WhileActive]) < Latest->Index[Cue.EventType];
+	default:
+		return false;
+	}
+}
+
+void UGSGameplayCueManager::FlushLocalGameplayCues(UWorld* World)
+{
+	// Take the queue first so cues that trigger other local cues queue them for the next frame
+	FGSLocalGameplayCueQueue Queue;
+	if (!LocalCueQueues.RemoveAndCopyValue(World, Queue))
+	{
+		return;
+	}
+
+	INC_DWORD_STAT_BY(STAT_GSGameplayCues_LocalCuesPerFrame, Queue.Cues.Num());
+
+	for (const FGSQueuedLocalGameplayCue& Cue : Queue.Cues)
+	{
+		// Targets destroyed this frame are skipped, same as the cue manager does for ones destroyed before their cue loads
+		if (AActor* TargetActor = Cue.TargetActor.Get())
+		{
+			HandleGameplayCue(TargetActor, Cue.GameplayCueTag, Cue.EventType, Cue.Parameters);
+		}
+	}
+}
+
+void UGSGameplayCueManager::OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	FlushLocalGameplayCues(World);
+}
+
+void UGSGameplayCueManager::OnWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources)
+{
+	LocalCueQueues.Remove(World);
+
+	// The world's recycled actors go with it
+	for (auto It = PooledCueActors.CreateIterator(); It; ++It)
+	{
+		const AGameplayCueNotify_Actor* Actor = It->Get();
+		if (!Actor || Actor->GetWorld() == World)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	PooledCueActorCountByClass.Reset();
+	for (const TWeakObjectPtr<AGameplayCueNotify_Actor>& Actor : PooledCueActors)
+	{
+		PooledCueActorCountByClass.FindOrAdd(Actor->GetClass())++;
+	}
+	SET_DWORD_STAT(STAT_GSGameplayCues_CueActorsPooled, PooledCueActors.Num());
+}
+
+AGameplayCueNotify_Actor* UGSGameplayCueManager::GetInstancedCueActor(AActor* TargetActor, UClass* GameplayCueNotifyActorClass, const FGameplayCueParameters& Parameters)
+{
+	AGameplayCueNotify_Actor* Actor = Super::GetInstancedCueActor(TargetActor, GameplayCueNotifyActorClass, Parameters);
+
+	if (Actor && PooledCueActors.Remove(Actor) > 0)
+	{
+		PooledCueActorCountByClass.FindOrAdd(Actor->GetClass())--;
+		INC_DWORD_STAT(STAT_GSGameplayCues_CueActorsReused);
+		DEC_DWORD_STAT(STAT_GSGameplayCues_CueActorsPooled);
+	}
+
+	return Actor;
+}
+
+void UGSGameplayCueManager::NotifyGameplayCueActorFinished(AGameplayCueNotify_Actor* Actor)
+{
+	if (!Actor || Actor->bInRecycleQueue)
+	{
+		Super::NotifyGameplayCueActorFinished(Actor);
+		return;
+	}
+
+	// The engine keeps every finished actor around for reuse. A big fight can leave hundreds of them hidden in the level.
+	const int32 MaxPooled = CVarMaxPooledCueActorsPerClass.GetValueOnGameThread();
+	if (MaxPooled >= 0 && PooledCueActorCountByClass.FindRef(Actor->GetClass()) >= MaxPooled)
+	{
+		INC_DWORD_STAT(STAT_GSGameplayCues_CueActorsReleased);
+		Actor->Destroy();
+		return;
+	}
+
+	Super::NotifyGameplayCueActorFinished(Actor);
+
+	// Only count it if recycling is on and the actor agreed to be recycled
+	if (Actor->bInRecycleQueue && !Actor->IsPendingKill())
+	{
+		PooledCueActors.Add(Actor);
+		PooledCueActorCountByClass.FindOrAdd(Actor->GetClass())++;
+		INC_DWORD_STAT(STAT_GSGameplayCues_CueActorsPooled);
+	}
+}
@@ -0,0 +1,80 @@
+// Copyright 2020 Dan Kestranek.
+
+
+#include "Characters/Abilities/GSGameplayCueManifest.h"
+#include "Abilities/GameplayAbility.h"
+#include "Characters/Abilities/GSGameplayAbility.h"
+#include "Engine/World.h"
+#include "Weapons/GSWeapon.h"
+
+template <typename KeyType>
+static int32 AppendCues(TMap<KeyType, FGameplayTagContainer>& Into, const TMap<KeyType, FGameplayTagContainer>& From)
+{
+	int32 NumAdded = 0;
+
+	for (const TPair<KeyType, FGameplayTagContainer>& Pair : From)
+	{
+		FGameplayTagContainer& Cues = Into.FindOrAdd(Pair.Key);
+		for (const FGameplayTag& Cue : Pair.Value)
+		{
+			if (!Cues.HasTagExact(Cue))
+			{
+				Cues.AddTagFast(Cue);
+				NumAdded++;
+			}
+		}
+	}
+
+	return NumAdded;
+}
+
+FName UGSGameplayCueManifest::GetMapKey(const UWorld* World)
+{
+	if (!World)
+	{
+		return NAME_None;
+	}
+
+	return FName(*UWorld::RemovePIEPrefix(World->GetOutermost()->GetName()));
+}
+
+void UGSGameplayCueManifest::GetCuesForMap(const UWorld* World, FGameplayTagContainer& OutCues) const
+{
+	if (const FGameplayTagContainer* Cues = CuesByMap.Find(GetMapKey(World)))
+	{
+		OutCues.AppendTags(*Cues);
+	}
+}
+
+void UGSGameplayCueManifest::GetCuesForWeapon(const AGSWeapon* Weapon, FGameplayTagContainer& OutCues) const
+{
+	if (!Weapon)
+	{
+		return;
+	}
+
+	if (const FGameplayTagContainer* Cues = CuesByWeapon.Find(TSoftClassPtr<AGSWeapon>(Weapon->GetClass())))
+	{
+		OutCues.AppendTags(*Cues);
+	}
+
+	for (const TSubclassOf<UGSGameplayAbility>& Ability : Weapon->GetAbilities())
+	{
+		if (const FGameplayTagContainer* Cues = CuesByAbility.Find(TSoftClassPtr<UGameplayAbility>(Ability.Get())))
+		{
+			OutCues.AppendTags(*Cues);
+		}
+	}
+}
+
+int32 UGSGameplayCueManifest::Append(const UGSGameplayCueManifest& Other)
+{
+	return AppendCues(CuesByMap, Other.CuesByMap) + AppendCues(CuesByWeapon, Other.CuesByWeapon) + AppendCues(CuesByAbility, Other.CuesByAbility);
+}
+
+void UGSGameplayCueManifest::Reset()
+{
+	CuesByMap.Reset();
+	CuesByWeapon.Reset();
+	CuesByAbility.Reset();
+}
@@ -5,6 +5,20 @@
 #include "AbilitySystemBlueprintLibrary.h"
 #include "AbilitySystemComponent.h"
 #include "AbilitySystemGlobals.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "GSInteractableSubsystem.h"
+
+// Interactions starting and ending is when Blueprint interactables usually open, get used up or become available again
+static void NotifyInteractableAvailabilityChanged(const IGSInteractable* Interactable)
+{
+	AActor* Actor = Cast<AActor>(Interactable->_getUObject());
+	UWorld* World = Actor ? Actor->GetWorld() : nullptr;
+	if (UGSInteractableSubsystem* Interactables = World ? World->GetSubsystem<UGSInteractableSubsystem>() : nullptr)
+	{
+		Interactables->NotifyAvailabilityChanged(Actor);
+	}
+}
 
 bool IGSInteractable::IsAvailableForInteraction_Implementation(UPrimitiveComponent* InteractionComponent) const
 {
@@ -49,6 +63,8 @@ void IGSInteractable::RegisterInteracter_Implementation(UPrimitiveComponent* Int
 		InteractingActors.Add(InteractingActor);
 		Interacters.Add(InteractionComponent, InteractingActors);
 	}
+
+	NotifyInteractableAvailabilityChanged(this);
 }
 
 void IGSInteractable::UnregisterInteracter_Implementation(UPrimitiveComponent* InteractionComponent, AActor* InteractingActor)
@@ -58,6 +74,8 @@ void IGSInteractable::UnregisterInteracter_Implementation(UPrimitiveComponent* I
 		TArray<AActor*>& InteractingActors = Interacters[InteractionComponent];
 		InteractingActors.Remove(InteractingActor);
 	}
+
+	NotifyInteractableAvailabilityChanged(this);
 }
 
 void IGSInteractable::InteractableCancelInteraction_Implementation(UPrimitiveComponent* InteractionComponent)
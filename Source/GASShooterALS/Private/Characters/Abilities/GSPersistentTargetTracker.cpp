@@ -0,0 +1,187 @@
+// Copyright 2020 Dan Kestranek.
+
+
+#include "Characters/Abilities/GSPersistentTargetTracker.h"
+#include "GameFramework/Actor.h"
+
+namespace GSPersistentTargetTracker
+{
+	static float GetTargetDistanceSquared(const FHitResult& HitResult, const FVector& Origin)
+	{
+		// Targets can move while tracked so prefer where the Actor is now
+		const FVector TargetLocation = HitResult.Actor.IsValid() ? HitResult.Actor->GetActorLocation() : HitResult.Location;
+		return FVector::DistSquared(Origin, TargetLocation);
+	}
+}
+
+FGSPersistentTargetTracker::FGSPersistentTargetTracker()
+	: Head(0), Count(0), Capacity(1), EvictionPolicy(EGSTargetEvictionPolicy::Oldest)
+{
+}
+
+void FGSPersistentTargetTracker::Init(int32 InCapacity, EGSTargetEvictionPolicy InEvictionPolicy)
+{
+	Reset();
+
+	Capacity = FMath::Max(1, InCapacity);
+	EvictionPolicy = InEvictionPolicy;
+
+	if (Slots.Num() < Capacity)
+	{
+		Slots.SetNum(Capacity);
+	}
+
+	SlotByActor.Reserve(Capacity);
+}
+
+void FGSPersistentTargetTracker::Reset()
+{
+	for (int32 Index = 0; Index < Count; Index++)
+	{
+		Slots[GetSlot(Index)] = FHitResult();
+	}
+
+	SlotByActor.Reset();
+	Head = 0;
+	Count = 0;
+}
+
+bool FGSPersistentTargetTracker::Add(const FHitResult& HitResult, const FVector& Origin)
+{
+	if (Slots.Num() < Capacity)
+	{
+		// Used without Init()
+		Slots.SetNum(Capacity);
+	}
+
+	const bool bHasActor = HitResult.Actor.IsValid();
+	if (bHasActor && SlotByActor.Contains(HitResult.Actor))
+	{
+		return false;
+	}
+
+	if (IsFull())
+	{
+		if (EvictionPolicy == EGSTargetEvictionPolicy::Farthest)
+		{
+			float FarthestDistanceSquared = 0.0f;
+			const int32 FarthestIndex = FindFarthest(Origin, FarthestDistanceSquared);
+
+			if (GSPersistentTargetTracker::GetTargetDistanceSquared(HitResult, Origin) >= FarthestDistanceSquared)
+			{
+				return false;
+			}
+
+			RemoveAt(FarthestIndex);
+		}
+		else
+		{
+			RemoveAt(0);
+		}
+	}
+
+	const int32 Slot = GetSlot(Count);
+	Slots[Slot] = HitResult;
+	Count++;
+
+	if (bHasActor)
+	{
+		SlotByActor.Add(HitResult.Actor, Slot);
+	}
+
+	return true;
+}
+
+bool FGSPersistentTargetTracker::Contains(const AActor* Actor) const
+{
+	return Actor && SlotByActor.Contains(MakeWeakObjectPtr(const_cast<AActor*>(Actor)));
+}
+
+void FGSPersistentTargetTracker::CopyTo(TArray<FHitResult>& OutHitResults) const
+{
+	OutHitResults.Reset(Count);
+
+	for (int32 Index = 0; Index < Count; Index++)
+	{
+		OutHitResults.Add(Slots[GetSlot(Index)]);
+	}
+}
+
+void FGSPersistentTargetTracker::GetActors(TArray<AActor*>& OutActors) const
+{
+	OutActors.Reset(Count);
+
+	for (int32 Index = 0; Index < Count; Index++)
+	{
+		if (AActor* Actor = Slots[GetSlot(Index)].Actor.Get())
+		{
+			OutActors.Add(Actor);
+		}
+	}
+}
+
+int32 FGSPersistentTargetTracker::FindFarthest(const FVector& Origin, float& OutDistanceSquared) const
+{
+	int32 FarthestIndex = INDEX_NONE;
+	OutDistanceSquared = -1.0f;
+
+	for (int32 Index = 0; Index < Count; Index++)
+	{
+		const float DistanceSquared = GSPersistentTargetTracker::GetTargetDistanceSquared(Slots[GetSlot(Index)], Origin);
+
+		if (DistanceSquared > OutDistanceSquared)
+		{
+			OutDistanceSquared = DistanceSquared;
+			FarthestIndex = Index;
+		}
+	}
+
+	return FarthestIndex;
+}
+
+void FGSPersistentTargetTracker::RemoveAt(int32 Index)
+{
+	check(Index >= 0 && Index < Count);
+
+	if (Index == 0)
+	{
+		// Oldest target, just move the head
+		ClearSlot(Head);
+		Head = (Head + 1) % Capacity;
+		Count--;
+		return;
+	}
+
+	ClearSlot(GetSlot(Index));
+
+	// Close the gap so the remaining targets keep their order
+	for (int32 NextIndex = Index + 1; NextIndex < Count; NextIndex++)
+	{
+		MoveSlot(GetSlot(NextIndex), GetSlot(NextIndex - 1));
+	}
+
+	Count--;
+}
+
+void FGSPersistentTargetTracker::ClearSlot(int32 Slot)
+{
+	FHitResult& HitResult = Slots[Slot];
+
+	if (!HitResult.Actor.IsExplicitlyNull())
+	{
+		SlotByActor.Remove(HitResult.Actor);
+	}
+
+	HitResult = FHitResult();
+}
+
+void FGSPersistentTargetTracker::MoveSlot(int32 FromSlot, int32 ToSlot)
+{
+	Slots[ToSlot] = MoveTemp(Slots[FromSlot]);
+	Slots[FromSlot] = FHitResult();
+
+	if (int32* ActorSlot = SlotByActor.Find(Slots[ToSlot].Actor))
+	{
+		*ActorSlot = ToSlot;
+	}
+}
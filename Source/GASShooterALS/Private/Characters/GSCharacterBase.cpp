@@ -21,6 +21,7 @@
 #include "GameFramework/CharacterMovementComponent.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "TimerManager.h"
+#include "Net/Core/PushModel/PushModel.h"
 #include "Net/UnrealNetwork.h"
 
 /// /////////////////////////////////////////////////////////////////////////
@@ -470,17 +471,23 @@ void AGSCharacterBase::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& Out
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
 	DOREPLIFETIME(AGSCharacterBase, TargetRagdollLocation);
-	DOREPLIFETIME_CONDITION(AGSCharacterBase, ReplicatedCurrentAcceleration, COND_SkipOwner);
-	DOREPLIFETIME_CONDITION(AGSCharacterBase, ReplicatedControlRotation, COND_SkipOwner);
+
+	// Push based. Mark these dirty wherever they change.
+	FDoRepLifetimeParams SkipOwnerPushParams;
+	SkipOwnerPushParams.bIsPushBased = true;
+	SkipOwnerPushParams.Condition = COND_SkipOwner;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(AGSCharacterBase, ReplicatedCurrentAcceleration, SkipOwnerPushParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AGSCharacterBase, ReplicatedControlRotation, SkipOwnerPushParams);
 
 	DOREPLIFETIME(AGSCharacterBase, DesiredGait);
 	DOREPLIFETIME_CONDITION(AGSCharacterBase, DesiredStance, COND_SkipOwner);
 	DOREPLIFETIME_CONDITION(AGSCharacterBase, DesiredRotationMode, COND_SkipOwner);
 
-	DOREPLIFETIME_CONDITION(AGSCharacterBase, RotationMode, COND_SkipOwner);
-	DOREPLIFETIME_CONDITION(AGSCharacterBase, OverlayState, COND_SkipOwner);
-	DOREPLIFETIME_CONDITION(AGSCharacterBase, ViewMode, COND_SkipOwner);
-	DOREPLIFETIME_CONDITION(AGSCharacterBase, VisibleMesh, COND_SkipOwner);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AGSCharacterBase, RotationMode, SkipOwnerPushParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AGSCharacterBase, OverlayState, SkipOwnerPushParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AGSCharacterBase, ViewMode, SkipOwnerPushParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AGSCharacterBase, VisibleMesh, SkipOwnerPushParams);
 }
 
 void AGSCharacterBase::OnBreakfall_Implementation()
@@ -727,6 +734,7 @@ void AGSCharacterBase::SetRotationMode(const EALSRotationMode NewRotationMode, b
 	{
 		const EALSRotationMode Prev = RotationMode;
 		RotationMode = NewRotationMode;
+		MARK_PROPERTY_DIRTY_FROM_NAME(AGSCharacterBase, RotationMode, this);
 		OnRotationModeChanged(Prev);
 
 		if (GetLocalRole() == ROLE_AutonomousProxy)
@@ -748,6 +756,7 @@ void AGSCharacterBase::SetViewMode(const EALSViewMode NewViewMode, bool bForce)
 	{
 		const EALSViewMode Prev = ViewMode;
 		ViewMode = NewViewMode;
+		MARK_PROPERTY_DIRTY_FROM_NAME(AGSCharacterBase, ViewMode, this);
 		OnViewModeChanged(Prev);
 
 		if (GetLocalRole() == ROLE_AutonomousProxy)
@@ -768,6 +777,7 @@ void AGSCharacterBase::SetOverlayState(const EALSOverlayState NewState, bool bFo
 	{
 		const EALSOverlayState Prev = OverlayState;
 		OverlayState = NewState;
+		MARK_PROPERTY_DIRTY_FROM_NAME(AGSCharacterBase, OverlayState, this);
 		OnOverlayStateChanged(Prev);
 
 		if (GetLocalRole() == ROLE_AutonomousProxy)
@@ -1028,6 +1038,7 @@ void AGSCharacterBase::SetVisibleMesh(USkeletalMesh* NewVisibleMesh)
 	{
 		const USkeletalMesh* Prev = VisibleMesh;
 		VisibleMesh = NewVisibleMesh;
+		MARK_PROPERTY_DIRTY_FROM_NAME(AGSCharacterBase, VisibleMesh, this);
 		OnVisibleMeshChanged(Prev);
 
 		if (GetLocalRole() != ROLE_Authority)
@@ -1419,8 +1430,20 @@ void AGSCharacterBase::SetEssentialValues(float DeltaTime)
 {
 	if (GetLocalRole() != ROLE_SimulatedProxy)
 	{
-		ReplicatedCurrentAcceleration = GetCharacterMovement()->GetCurrentAcceleration();
-		ReplicatedControlRotation = GetControlRotation();
+		const FVector NewAcceleration = GetCharacterMovement()->GetCurrentAcceleration();
+		if (ReplicatedCurrentAcceleration != NewAcceleration)
+		{
+			ReplicatedCurrentAcceleration = NewAcceleration;
+			MARK_PROPERTY_DIRTY_FROM_NAME(AGSCharacterBase, ReplicatedCurrentAcceleration, this);
+		}
+
+		const FRotator NewControlRotation = GetControlRotation();
+		if (ReplicatedControlRotation != NewControlRotation)
+		{
+			ReplicatedControlRotation = NewControlRotation;
+			MARK_PROPERTY_DIRTY_FROM_NAME(AGSCharacterBase, ReplicatedControlRotation, this);
+		}
+
 		EasedMaxAcceleration = GetCharacterMovement()->GetMaxAcceleration();
 	}
 
@@ -7,14 +7,21 @@
 #include "Camera/CameraComponent.h"
 #include "Characters/Abilities/GSAbilitySystemComponent.h"
 #include "Characters/Abilities/GSAbilitySystemGlobals.h"
+#include "Characters/Abilities/GSGameplayCueManager.h"
 #include "Characters/Abilities/AttributeSets/GSAmmoAttributeSet.h"
 #include "Characters/Abilities/AttributeSets/GSAttributeSetBase.h"
 #include "Components/WidgetComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "GASShooterALS/GASShooterALSGameModeBase.h"
+#include "GSActorPoolSubsystem.h"
 #include "GSBlueprintFunctionLibrary.h"
+#include "GSInteractableSubsystem.h"
+#include "GSLagCompensationSubsystem.h"
+#include "GSWeaponAssetSubsystem.h"
 #include "Kismet/GameplayStatics.h"
 #include "Kismet/KismetMathLibrary.h"
+#include "Net/Core/PushModel/PushModel.h"
 #include "Net/UnrealNetwork.h"
 #include "Player/GSPlayerController.h"
 #include "Player/GSPlayerState.h"
@@ -25,6 +32,113 @@
 #include "AI/ALSAIController.h"
 #include "Weapons/GSWeapon.h"
 
+void FGSHeroInventoryItem::PostReplicatedAdd(const FGSHeroInventory& InArraySerializer)
+{
+	InArraySerializer.MarkSlotsDirty();
+
+	if (InArraySerializer.Owner && Weapon)
+	{
+		InArraySerializer.Owner->OnInventoryWeaponAdded(Weapon);
+	}
+}
+
+void FGSHeroInventoryItem::PostReplicatedChange(const FGSHeroInventory& InArraySerializer)
+{
+	PostReplicatedAdd(InArraySerializer);
+}
+
+void FGSHeroInventoryItem::PreReplicatedRemove(const FGSHeroInventory& InArraySerializer)
+{
+	InArraySerializer.MarkSlotsDirty();
+
+	if (InArraySerializer.Owner && Weapon)
+	{
+		InArraySerializer.Owner->OnInventoryWeaponRemoved(Weapon);
+	}
+}
+
+void FGSHeroInventory::UpdateSlots() const
+{
+	if (!bSlotsDirty)
+	{
+		return;
+	}
+
+	Slots.Reset(Items.Num());
+	for (int32 Index = 0; Index < Items.Num(); Index++)
+	{
+		Slots.Add(Index);
+	}
+
+	Slots.Sort([this](int32 A, int32 B) { return Items[A].Order < Items[B].Order; });
+
+	SlotByClass.Reset();
+	for (int32 Slot = 0; Slot < Slots.Num(); Slot++)
+	{
+		if (AGSWeapon* Weapon = Items[Slots[Slot]].Weapon)
+		{
+			SlotByClass.Add(Weapon->GetClass(), Slot);
+		}
+	}
+
+	bSlotsDirty = false;
+}
+
+AGSWeapon* FGSHeroInventory::GetWeapon(int32 Slot) const
+{
+	UpdateSlots();
+	return Slots.IsValidIndex(Slot) ? Items[Slots[Slot]].Weapon : nullptr;
+}
+
+int32 FGSHeroInventory::FindWeapon(const AGSWeapon* InWeapon) const
+{
+	if (!InWeapon)
+	{
+		return INDEX_NONE;
+	}
+
+	UpdateSlots();
+	const int32* Slot = SlotByClass.Find(InWeapon->GetClass());
+	return Slot && Items[Slots[*Slot]].Weapon == InWeapon ? *Slot : INDEX_NONE;
+}
+
+bool FGSHeroInventory::ContainsWeaponClass(const AGSWeapon* InWeapon) const
+{
+	if (!InWeapon)
+	{
+		return false;
+	}
+
+	UpdateSlots();
+	return SlotByClass.Contains(InWeapon->GetClass());
+}
+
+void FGSHeroInventory::AddWeapon(AGSWeapon* InWeapon)
+{
+	UpdateSlots();
+
+	// New weapons always go in the last slot
+	const int32 Index = Items.Add(FGSHeroInventoryItem(InWeapon, NextOrder++));
+	MarkItemDirty(Items[Index]);
+
+	SlotByClass.Add(InWeapon->GetClass(), Slots.Add(Index));
+}
+
+bool FGSHeroInventory::RemoveWeapon(AGSWeapon* InWeapon)
+{
+	const int32 Slot = FindWeapon(InWeapon);
+	if (Slot == INDEX_NONE)
+	{
+		return false;
+	}
+
+	Items.RemoveAtSwap(Slots[Slot]);
+	MarkArrayDirty();
+	MarkSlotsDirty();
+
+	return true;
+}
+
 AGSHeroCharacter::AGSHeroCharacter(const class FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
 {
 	BaseTurnRate = 45.0f;
@@ -92,10 +206,15 @@ void AGSHeroCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& Out
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(AGSHeroCharacter, Inventory);
+	// Push based. Mark these dirty wherever they change.
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(AGSHeroCharacter, Inventory, Params);
 	// Only replicate CurrentWeapon to simulated clients and manually sync CurrentWeeapon with Owner when we're ready.
 	// This allows us to predict weapon changing.
-	DOREPLIFETIME_CONDITION(AGSHeroCharacter, CurrentWeapon, COND_SimulatedOnly);
+	Params.Condition = COND_SimulatedOnly;
+	DOREPLIFETIME_WITH_PARAMS_FAST(AGSHeroCharacter, CurrentWeapon, Params);
 }
 
 // Called to bind functionality to input
@@ -136,6 +255,8 @@ void AGSHeroCharacter::PossessedBy(AController* NewController)
 		WeaponChangingDelayReplicationTagChangedDelegateHandle = AbilitySystemComponent->RegisterGameplayTagEvent(WeaponChangingDelayReplicationTag)
 			.AddUObject(this, &AGSHeroCharacter::WeaponChangingDelayReplicationTagChanged);
 
+		BindInteractionAvailabilityTagEvents();
+
 		// Set the AttributeSetBase for convenience attribute functions
 		AttributeSetBase = PS->GetAttributeSetBase();
 
@@ -149,6 +270,15 @@ void AGSHeroCharacter::PossessedBy(AController* NewController)
 
 		AddCharacterAbilities();
 
+		// Holstered weapons only replicate to the owning connection, which we may not have had until now
+		for (const FGSHeroInventoryItem& Item : Inventory.Items)
+		{
+			if (Item.Weapon)
+			{
+				Item.Weapon->UpdateReplicationState();
+			}
+		}
+
 		AGSPlayerController* PC = Cast<AGSPlayerController>(GetController());
 		if (PC)
 		{
@@ -280,7 +410,63 @@ void AGSHeroCharacter::FinishDying()
 
 	OnCharacterDied.Broadcast(this);
 
-	Super::FinishDying();
+	// Pooled instead of destroyed. The game mode hands us out again on respawn.
+	UGSActorPoolSubsystem::Release(this);
+}
+
+void AGSHeroCharacter::OnReturnedToPool()
+{
+	// Same cleanup as EndPlay(), which doesn't run while we are pooled
+	Execute_InteractableCancelInteraction(this, GetMesh());
+
+	if (MovementState == EALSMovementState::Ragdoll)
+	{
+		ReplicatedRagdollEnd();
+	}
+
+	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+	{
+		AnimInstance->StopAllMontages(0.0f);
+	}
+
+	if (AbilitySystemComponent)
+	{
+		AbilitySystemComponent->RemoveLooseGameplayTag(CurrentWeaponTag);
+		CurrentWeaponTag = NoWeaponTag;
+		AbilitySystemComponent->AddLooseGameplayTag(CurrentWeaponTag);
+	}
+
+	if (UGSLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UGSLagCompensationSubsystem>())
+	{
+		LagCompensation->UnregisterHero(this);
+	}
+
+	ClearAbilitySystemReferences();
+
+	if (UGSInteractableSubsystem* Interactables = GetWorld()->GetSubsystem<UGSInteractableSubsystem>())
+	{
+		Interactables->NotifyAvailabilityChanged(this);
+	}
+
+	GetCharacterMovement()->StopMovementImmediately();
+	GetCharacterMovement()->DisableMovement();
+	GetCharacterMovement()->SetComponentTickEnabled(false);
+	GetMesh()->SetComponentTickEnabled(false);
+}
+
+void AGSHeroCharacter::OnAcquiredFromPool()
+{
+	GetMesh()->SetComponentTickEnabled(true);
+	GetCharacterMovement()->SetComponentTickEnabled(true);
+	GetCharacterMovement()->SetDefaultMovementMode();
+
+	if (UGSLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UGSLagCompensationSubsystem>())
+	{
+		LagCompensation->RegisterHero(this);
+	}
+
+	// The rest is set up again by PossessedBy()
+	GetWorldTimerManager().SetTimerForNextTick(this, &AGSHeroCharacter::SpawnDefaultInventory);
 }
 
 bool AGSHeroCharacter::IsInFirstPersonPerspective() const
@@ -297,9 +483,10 @@ bool AGSHeroCharacter::AddWeaponToInventory(AGSWeapon* NewWeapon, bool bEquipWea
 {
 	if (DoesWeaponExistInInventory(NewWeapon))
 	{
-		USoundCue* PickupSound = NewWeapon->GetPickupSound();
+		// Only ask for the sound where it's played, since getting it may load it
+		USoundCue* PickupSound = IsLocallyControlled() ? NewWeapon->GetPickupSound() : nullptr;
 
-		if (PickupSound && IsLocallyControlled())
+		if (PickupSound)
 		{
 			UGameplayStatics::SpawnSoundAttached(PickupSound, GetRootComponent());
 		}
@@ -309,39 +496,20 @@ bool AGSHeroCharacter::AddWeaponToInventory(AGSWeapon* NewWeapon, bool bEquipWea
 			return false;
 		}
 
-		// Create a dynamic instant Gameplay Effect to give the primary and secondary ammo
-		UGameplayEffect* GEAmmo = NewObject<UGameplayEffect>(GetTransientPackage(), FName(TEXT("Ammo")));
-		GEAmmo->DurationPolicy = EGameplayEffectDurationType::Instant;
+		// Give the primary and secondary ammo through the shared ammo refill effects
+		GiveReserveAmmo(NewWeapon->PrimaryAmmoType, NewWeapon->GetPrimaryClipAmmo());
+		GiveReserveAmmo(NewWeapon->SecondaryAmmoType, NewWeapon->GetSecondaryClipAmmo());
 
-		if (NewWeapon->PrimaryAmmoType != WeaponAmmoTypeNoneTag)
+		// Only weapons spawned at runtime can be handed out again. Map placed ones are part of the level.
+		if (NewWeapon->IsNetStartupActor())
 		{
-			int32 Idx = GEAmmo->Modifiers.Num();
-			GEAmmo->Modifiers.SetNum(Idx + 1);
-
-			FGameplayModifierInfo& InfoPrimaryAmmo = GEAmmo->Modifiers[Idx];
-			InfoPrimaryAmmo.ModifierMagnitude = FScalableFloat(NewWeapon->GetPrimaryClipAmmo());
-			InfoPrimaryAmmo.ModifierOp = EGameplayModOp::Additive;
-			InfoPrimaryAmmo.Attribute = UGSAmmoAttributeSet::GetReserveAmmoAttributeFromTag(NewWeapon->PrimaryAmmoType);
+			NewWeapon->Destroy();
 		}
-
-		if (NewWeapon->SecondaryAmmoType != WeaponAmmoTypeNoneTag)
-		{
-			int32 Idx = GEAmmo->Modifiers.Num();
-			GEAmmo->Modifiers.SetNum(Idx + 1);
-
-			FGameplayModifierInfo& InfoSecondaryAmmo = GEAmmo->Modifiers[Idx];
-			InfoSecondaryAmmo.ModifierMagnitude = FScalableFloat(NewWeapon->GetSecondaryClipAmmo());
-			InfoSecondaryAmmo.ModifierOp = EGameplayModOp::Additive;
-			InfoSecondaryAmmo.Attribute = UGSAmmoAttributeSet::GetReserveAmmoAttributeFromTag(NewWeapon->SecondaryAmmoType);
-		}
-
-		if (GEAmmo->Modifiers.Num() > 0)
+		else
 		{
-			AbilitySystemComponent->ApplyGameplayEffectToSelf(GEAmmo, 1.0f, AbilitySystemComponent->MakeEffectContext());
+			UGSActorPoolSubsystem::Release(NewWeapon);
 		}
 
-		NewWeapon->Destroy();
-
 		return false;
 	}
 
@@ -350,9 +518,16 @@ bool AGSHeroCharacter::AddWeaponToInventory(AGSWeapon* NewWeapon, bool bEquipWea
 		return false;
 	}
 
-	Inventory.Weapons.Add(NewWeapon);
+	Inventory.AddWeapon(NewWeapon);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AGSHeroCharacter, Inventory, this);
 	NewWeapon->SetOwningCharacter(this);
 	NewWeapon->AddAbilities();
+	UGSGameplayCueManager::PreloadGameplayCuesForWeapon(NewWeapon);
+
+	if (IsLocallyControlled())
+	{
+		UGSWeaponAssetSubsystem::PreloadWeaponAssets(NewWeapon, TEXT("inventory"));
+	}
 
 	if (bEquipWeapon)
 	{
@@ -365,14 +540,15 @@ bool AGSHeroCharacter::AddWeaponToInventory(AGSWeapon* NewWeapon, bool bEquipWea
 
 bool AGSHeroCharacter::RemoveWeaponFromInventory(AGSWeapon* WeaponToRemove)
 {
-	if (DoesWeaponExistInInventory(WeaponToRemove))
+	if (Inventory.FindWeapon(WeaponToRemove) != INDEX_NONE)
 	{
 		if (WeaponToRemove == CurrentWeapon)
 		{
 			UnEquipCurrentWeapon();
 		}
 
-		Inventory.Weapons.Remove(WeaponToRemove);
+		Inventory.RemoveWeapon(WeaponToRemove);
+		MARK_PROPERTY_DIRTY_FROM_NAME(AGSHeroCharacter, Inventory, this);
 		WeaponToRemove->RemoveAbilities();
 		WeaponToRemove->SetOwningCharacter(nullptr);
 		WeaponToRemove->ResetWeapon();
@@ -395,11 +571,16 @@ void AGSHeroCharacter::RemoveAllWeaponsFromInventory()
 	UnEquipCurrentWeapon();
 
 	float radius = 50.0f;
-	float NumWeapons = Inventory.Weapons.Num();
+	float NumWeapons = Inventory.Num();
 
-	for (int32 i = Inventory.Weapons.Num() - 1; i >= 0; i--)
+	for (int32 i = Inventory.Num() - 1; i >= 0; i--)
 	{
-		AGSWeapon* Weapon = Inventory.Weapons[i];
+		AGSWeapon* Weapon = Inventory.GetWeapon(i);
+		if (!Weapon)
+		{
+			continue;
+		}
+
 		RemoveWeaponFromInventory(Weapon);
 
 		// Set the weapon up as a pickup
@@ -436,43 +617,43 @@ bool AGSHeroCharacter::ServerEquipWeapon_Validate(AGSWeapon* NewWeapon)
 
 void AGSHeroCharacter::NextWeapon()
 {
-	if (Inventory.Weapons.Num() < 2)
+	if (Inventory.Num() < 2)
 	{
 		return;
 	}
 
-	int32 CurrentWeaponIndex = Inventory.Weapons.Find(CurrentWeapon);
+	int32 CurrentWeaponIndex = Inventory.FindWeapon(CurrentWeapon);
 	UnEquipCurrentWeapon();
 
 	if (CurrentWeaponIndex == INDEX_NONE)
 	{
-		EquipWeapon(Inventory.Weapons[0]);
+		EquipWeapon(Inventory.GetWeapon(0));
 	}
 	else
 	{
-		EquipWeapon(Inventory.Weapons[(CurrentWeaponIndex + 1) % Inventory.Weapons.Num()]);
+		EquipWeapon(Inventory.GetWeapon((CurrentWeaponIndex + 1) % Inventory.Num()));
 	}
 }
 
 void AGSHeroCharacter::PreviousWeapon()
 {
-	if (Inventory.Weapons.Num() < 2)
+	if (Inventory.Num() < 2)
 	{
 		return;
 	}
 
-	int32 CurrentWeaponIndex = Inventory.Weapons.Find(CurrentWeapon);
+	int32 CurrentWeaponIndex = Inventory.FindWeapon(CurrentWeapon);
 
 	UnEquipCurrentWeapon();
 
 	if (CurrentWeaponIndex == INDEX_NONE)
 	{
-		EquipWeapon(Inventory.Weapons[0]);
+		EquipWeapon(Inventory.GetWeapon(0));
 	}
 	else
 	{
-		int32 IndexOfPrevWeapon = FMath::Abs(CurrentWeaponIndex - 1 + Inventory.Weapons.Num()) % Inventory.Weapons.Num();
-		EquipWeapon(Inventory.Weapons[IndexOfPrevWeapon]);
+		int32 IndexOfPrevWeapon = FMath::Abs(CurrentWeaponIndex - 1 + Inventory.Num()) % Inventory.Num();
+		EquipWeapon(Inventory.GetWeapon(IndexOfPrevWeapon));
 	}
 }
 
@@ -551,7 +732,7 @@ int32 AGSHeroCharacter::GetSecondaryReserveAmmo() const
 
 int32 AGSHeroCharacter::GetNumWeapons() const
 {
-	return Inventory.Weapons.Num();
+	return Inventory.Num();
 }
 
 bool AGSHeroCharacter::IsAvailableForInteraction_Implementation(UPrimitiveComponent* InteractionComponent) const
@@ -642,6 +823,15 @@ void AGSHeroCharacter::BeginPlay()
 		ServerSyncCurrentWeapon();
 	}
 
+	// Server keeps a history of our hitboxes to validate client shots against
+	if (HasAuthority())
+	{
+		if (UGSLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UGSLagCompensationSubsystem>())
+		{
+			LagCompensation->RegisterHero(this);
+		}
+	}
+
 	//ALS
 	UpdateHeldObject();
 }
@@ -663,6 +853,14 @@ void AGSHeroCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
 		AbilitySystemComponent->AddLooseGameplayTag(CurrentWeaponTag);
 	}
 
+	if (UGSLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UGSLagCompensationSubsystem>())
+	{
+		LagCompensation->UnregisterHero(this);
+	}
+
+	// The ASC lives on the PlayerState and outlives us
+	UnbindInteractionAvailabilityTagEvents();
+
 	Super::EndPlay(EndPlayReason);
 }
 
@@ -670,6 +868,8 @@ void AGSHeroCharacter::PostInitializeComponents()
 {
 	Super::PostInitializeComponents();
 
+	Inventory.Owner = this;
+
 	GetWorldTimerManager().SetTimerForNextTick(this, &AGSHeroCharacter::SpawnDefaultInventory);
 }
 
@@ -769,6 +969,8 @@ void AGSHeroCharacter::OnRep_PlayerState()
 
 		AbilitySystemComponent->AbilityFailedCallbacks.AddUObject(this, &AGSHeroCharacter::OnAbilityActivationFailed);
 
+		BindInteractionAvailabilityTagEvents();
+
 		// Set the AttributeSetBase for convenience attribute functions
 		AttributeSetBase = PS->GetAttributeSetBase();
 		
@@ -814,6 +1016,11 @@ void AGSHeroCharacter::OnRep_PlayerState()
 		// Simulated on proxies don't have their PlayerStates yet when BeginPlay is called so we call it again here
 		InitializeFloatingStatusBar();
 	}
+	else
+	{
+		// Unpossessed and pooled by the server. The next possession may hand us the same PlayerState again.
+		ClearAbilitySystemReferences();
+	}
 }
 
 void AGSHeroCharacter::OnRep_Controller()
@@ -850,16 +1057,35 @@ void AGSHeroCharacter::SpawnDefaultInventory()
 			continue;
 		}
 
-		AGSWeapon* NewWeapon = GetWorld()->SpawnActorDeferred<AGSWeapon>(DefaultInventoryWeaponClasses[i],
-			FTransform::Identity, this, this, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
-		NewWeapon->bSpawnWithCollision = false;
-		NewWeapon->FinishSpawning(FTransform::Identity);
+		AGSWeapon* NewWeapon = UGSActorPoolSubsystem::AcquireWeapon(DefaultInventoryWeaponClasses[i], this);
+		if (!NewWeapon)
+		{
+			continue;
+		}
 
 		bool bEquipFirstWeapon = i == 0;
 		AddWeaponToInventory(NewWeapon, bEquipFirstWeapon);
 	}
 }
 
+void AGSHeroCharacter::GiveReserveAmmo(const FGameplayTag& AmmoType, int32 Amount)
+{
+	if (AmmoType == WeaponAmmoTypeNoneTag || !IsValid(AbilitySystemComponent))
+	{
+		return;
+	}
+
+	UGameplayEffect* GEAmmo = UGSAbilitySystemGlobals::GSGet().GetAmmoRefillEffect(AmmoType);
+	if (!GEAmmo)
+	{
+		return;
+	}
+
+	FGameplayEffectSpec Spec(GEAmmo, AbilitySystemComponent->MakeEffectContext(), 1.0f);
+	Spec.SetSetByCallerMagnitude(AmmoType, Amount);
+	AbilitySystemComponent->ApplyGameplayEffectSpecToSelf(Spec);
+}
+
 void AGSHeroCharacter::SetupStartupPerspective()
 {
 	APlayerController* PC = Cast<APlayerController>(GetController());
@@ -875,15 +1101,7 @@ bool AGSHeroCharacter::DoesWeaponExistInInventory(AGSWeapon* InWeapon)
 {
 	//UE_LOG(LogTemp, Log, TEXT("%s InWeapon class %s"), *FString(__FUNCTION__), *InWeapon->GetClass()->GetName());
 
-	for (AGSWeapon* Weapon : Inventory.Weapons)
-	{
-		if (Weapon && InWeapon && Weapon->GetClass() == InWeapon->GetClass())
-		{
-			return true;
-		}
-	}
-
-	return false;
+	return Inventory.ContainsWeaponClass(InWeapon);
 }
 
 void AGSHeroCharacter::SetCurrentWeapon(AGSWeapon* NewWeapon, AGSWeapon* LastWeapon)
@@ -912,6 +1130,7 @@ void AGSHeroCharacter::SetCurrentWeapon(AGSWeapon* NewWeapon, AGSWeapon* LastWea
 
 		// Weapons coming from OnRep_CurrentWeapon won't have the owner set
 		CurrentWeapon = NewWeapon;
+		MARK_PROPERTY_DIRTY_FROM_NAME(AGSHeroCharacter, CurrentWeapon, this);
 		CurrentWeapon->SetOwningCharacter(this);
 		CurrentWeapon->Equip();
 		CurrentWeaponTag = CurrentWeapon->WeaponTag;
@@ -924,7 +1143,7 @@ void AGSHeroCharacter::SetCurrentWeapon(AGSWeapon* NewWeapon, AGSWeapon* LastWea
 		AGSPlayerController* PC = GetController<AGSPlayerController>();
 		if (PC && PC->IsLocalController())
 		{
-			PC->SetEquippedWeaponPrimaryIconFromSprite(CurrentWeapon->PrimaryIcon);
+			PC->SetEquippedWeaponPrimaryIconFromSprite(CurrentWeapon->GetPrimaryIcon());
 			PC->SetEquippedWeaponStatusText(CurrentWeapon->StatusText);
 			PC->SetPrimaryClipAmmo(CurrentWeapon->GetPrimaryClipAmmo());
 			PC->SetPrimaryReserveAmmo(GetPrimaryReserveAmmo());
@@ -940,6 +1159,7 @@ void AGSHeroCharacter::SetCurrentWeapon(AGSWeapon* NewWeapon, AGSWeapon* LastWea
 			SecondaryReserveAmmoChangedDelegateHandle = AbilitySystemComponent->GetGameplayAttributeValueChangeDelegate(UGSAmmoAttributeSet::GetReserveAmmoAttributeFromTag(CurrentWeapon->SecondaryAmmoType)).AddUObject(this, &AGSHeroCharacter::CurrentWeaponSecondaryReserveAmmoChanged);
 		}
 
+		// Equipping a weapon that wasn't preloaded skips its montages rather than hitching. They load in the background.
 		UAnimMontage* Equip1PMontage = CurrentWeapon->GetEquip1PMontage();
 		if (Equip1PMontage && GetMesh())
 		{
@@ -951,6 +1171,12 @@ void AGSHeroCharacter::SetCurrentWeapon(AGSWeapon* NewWeapon, AGSWeapon* LastWea
 		{
 			GetMesh()->GetAnimInstance()->Montage_Play(Equip3PMontage);
 		}
+
+		// The last weapon goes back to only replicating to our owner, and goes dormant
+		if (LastWeapon)
+		{
+			LastWeapon->UpdateReplicationState();
+		}
 	}
 	else
 	{
@@ -987,8 +1213,14 @@ void AGSHeroCharacter::UnEquipCurrentWeapon()
 		AbilitySystemComponent->AddLooseGameplayTag(CurrentWeaponTag);
 	}
 
+	AGSWeapon* LastWeapon = CurrentWeapon;
 	UnEquipWeapon(CurrentWeapon);
 	CurrentWeapon = nullptr;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AGSHeroCharacter, CurrentWeapon, this);
+	if (LastWeapon)
+	{
+		LastWeapon->UpdateReplicationState();
+	}
 
 	AGSPlayerController* PC = GetController<AGSPlayerController>();
 	if (PC && PC->IsLocalController())
@@ -1051,15 +1283,80 @@ void AGSHeroCharacter::WeaponChangingDelayReplicationTagChanged(const FGameplayT
 	}
 }
 
+void AGSHeroCharacter::InteractionAvailabilityTagChanged(const FGameplayTag CallbackTag, int32 NewCount)
+{
+	if (UGSInteractableSubsystem* Interactables = GetWorld()->GetSubsystem<UGSInteractableSubsystem>())
+	{
+		Interactables->NotifyAvailabilityChanged(this);
+	}
+}
+
+void AGSHeroCharacter::BindInteractionAvailabilityTagEvents()
+{
+	if (!IsValid(AbilitySystemComponent))
+	{
+		return;
+	}
+
+	if (!KnockedDownTagChangedDelegateHandle.IsValid())
+	{
+		KnockedDownTagChangedDelegateHandle = AbilitySystemComponent->RegisterGameplayTagEvent(KnockedDownTag)
+			.AddUObject(this, &AGSHeroCharacter::InteractionAvailabilityTagChanged);
+	}
+
+	if (!InteractingTagChangedDelegateHandle.IsValid())
+	{
+		InteractingTagChangedDelegateHandle = AbilitySystemComponent->RegisterGameplayTagEvent(InteractingTag)
+			.AddUObject(this, &AGSHeroCharacter::InteractionAvailabilityTagChanged);
+	}
+}
+
+void AGSHeroCharacter::UnbindInteractionAvailabilityTagEvents()
+{
+	if (!IsValid(AbilitySystemComponent))
+	{
+		return;
+	}
+
+	AbilitySystemComponent->RegisterGameplayTagEvent(KnockedDownTag).Remove(KnockedDownTagChangedDelegateHandle);
+	AbilitySystemComponent->RegisterGameplayTagEvent(InteractingTag).Remove(InteractingTagChangedDelegateHandle);
+	KnockedDownTagChangedDelegateHandle.Reset();
+	InteractingTagChangedDelegateHandle.Reset();
+}
+
+void AGSHeroCharacter::ClearAbilitySystemReferences()
+{
+	if (IsValid(AbilitySystemComponent))
+	{
+		AbilitySystemComponent->AbilityFailedCallbacks.RemoveAll(this);
+		UnbindInteractionAvailabilityTagEvents();
+	}
+
+	AbilitySystemComponent = nullptr;
+	AttributeSetBase = nullptr;
+	AmmoAttributeSet = nullptr;
+
+	// Bound again to whichever input component the next possession creates
+	bASCInputBound = false;
+}
+
 void AGSHeroCharacter::OnRep_CurrentWeapon(AGSWeapon* LastWeapon)
 {
 	bChangedWeaponLocally = false;
 	SetCurrentWeapon(CurrentWeapon, LastWeapon);
 }
 
-void AGSHeroCharacter::OnRep_Inventory()
+void AGSHeroCharacter::OnInventoryWeaponAdded(AGSWeapon* Weapon)
 {
-	if (GetLocalRole() == ROLE_AutonomousProxy && Inventory.Weapons.Num() > 0 && !CurrentWeapon)
+	UGSGameplayCueManager::PreloadGameplayCuesForWeapon(Weapon);
+
+	// Other heroes' weapons load when they're equipped
+	if (IsLocallyControlled())
+	{
+		UGSWeaponAssetSubsystem::PreloadWeaponAssets(Weapon, TEXT("inventory"));
+	}
+
+	if (GetLocalRole() == ROLE_AutonomousProxy && !CurrentWeapon)
 	{
 		// Since we don't replicate the CurrentWeapon to the owning client, this is a way to ask the Server to sync
 		// the CurrentWeapon after it's been spawned via replication from the Server.
@@ -1068,6 +1365,15 @@ void AGSHeroCharacter::OnRep_Inventory()
 	}
 }
 
+void AGSHeroCharacter::OnInventoryWeaponRemoved(AGSWeapon* Weapon)
+{
+	// CurrentWeapon doesn't replicate to the owner, so let go of a weapon the server took away from us
+	if (GetLocalRole() == ROLE_AutonomousProxy && Weapon == CurrentWeapon)
+	{
+		UnEquipCurrentWeapon();
+	}
+}
+
 void AGSHeroCharacter::OnAbilityActivationFailed(const UGameplayAbility* FailedAbility, const FGameplayTagContainer& FailTags)
 {
 	if (FailedAbility && FailedAbility->AbilityTags.HasTagExact(FGameplayTag::RequestGameplayTag(FName("Ability.Weapon.IsChanging"))))
@@ -1097,6 +1403,7 @@ void AGSHeroCharacter::ClientSyncCurrentWeapon_Implementation(AGSWeapon* InWeapo
 {
 	AGSWeapon* LastWeapon = CurrentWeapon;
 	CurrentWeapon = InWeapon;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AGSHeroCharacter, CurrentWeapon, this);
 	OnRep_CurrentWeapon(LastWeapon);
 }
 
@@ -0,0 +1,383 @@
+// Copyright 2020 Dan Kestranek.
+
+
+#include "GSActorPoolSubsystem.h"
+#include "Characters/Heroes/GSHeroCharacter.h"
+#include "Engine/World.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/SpectatorPawn.h"
+#include "GASShooterALS/GASShooterALS.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/UObjectArray.h"
+#include "Weapons/GSWeapon.h"
+
+DECLARE_STATS_GROUP(TEXT("GSActorPool"), STATGROUP_GSActorPool, STATCAT_Advanced);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled Actors"), STAT_GSActorPool_Pooled, STATGROUP_GSActorPool);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Total Spawned"), STAT_GSActorPool_Spawned, STATGROUP_GSActorPool);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Total Reused"), STAT_GSActorPool_Reused, STATGROUP_GSActorPool);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Total Destroyed"), STAT_GSActorPool_Destroyed, STATGROUP_GSActorPool);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Garbage Collections"), STAT_GSActorPool_GarbageCollections, STATGROUP_GSActorPool);
+
+static TAutoConsoleVariable<int32> CVarActorPoolEnabled(
+	TEXT("GS.Pool.Enabled"),
+	1,
+	TEXT("Whether heroes, spectator pawns and weapons are pooled across death and respawn. When off, they are spawned and destroyed like before.")
+);
+
+static FAutoConsoleCommandWithWorldAndArgs CmdActorPoolReport(
+	TEXT("GS.Pool.Report"),
+	TEXT("Logs how many heroes, spectator pawns and weapons were spawned, reused and destroyed, with the number of garbage collections and live UObjects. Pass 'reset' to start counting again."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		UGSActorPoolSubsystem* ActorPool = World ? World->GetSubsystem<UGSActorPoolSubsystem>() : nullptr;
+		if (!ActorPool)
+		{
+			UE_LOG(LogGASShooterALS, Warning, TEXT("GS.Pool.Report: no actor pool in this world"));
+			return;
+		}
+
+		ActorPool->LogReport();
+
+		if (Args.Num() > 0 && Args[0] == TEXT("reset"))
+		{
+			ActorPool->ResetCounters();
+		}
+	})
+);
+
+static UGSActorPoolSubsystem* GetActorPool(UWorld* World)
+{
+	if (!World || World->GetNetMode() == NM_Client)
+	{
+		return nullptr;
+	}
+
+	return World->GetSubsystem<UGSActorPoolSubsystem>();
+}
+
+UGSActorPoolSubsystem::UGSActorPoolSubsystem()
+{
+	MaxPooledActorsPerClass = 16;
+	NumGarbageCollections = 0;
+}
+
+bool UGSActorPoolSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+void UGSActorPoolSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	MaxPooledActorsPerClass = FMath::Max(0, MaxPooledActorsPerClass);
+
+	PostGarbageCollectHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddUObject(this, &UGSActorPoolSubsystem::OnPostGarbageCollect);
+}
+
+void UGSActorPoolSubsystem::Deinitialize()
+{
+	FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGarbageCollectHandle);
+
+	// Pooled actors go away with the world
+	FreeActors.Reset();
+
+	Super::Deinitialize();
+}
+
+AGSHeroCharacter* UGSActorPoolSubsystem::AcquireHero(UWorld* World, TSubclassOf<AGSHeroCharacter> HeroClass, const FTransform& SpawnTransform)
+{
+	if (!World || !HeroClass)
+	{
+		return nullptr;
+	}
+
+	UGSActorPoolSubsystem* ActorPool = GetActorPool(World);
+	if (ActorPool)
+	{
+		if (AGSHeroCharacter* Hero = Cast<AGSHeroCharacter>(ActorPool->AcquireActor(HeroClass, SpawnTransform)))
+		{
+			Hero->OnAcquiredFromPool();
+			return Hero;
+		}
+	}
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	AGSHeroCharacter* Hero = World->SpawnActor<AGSHeroCharacter>(HeroClass, SpawnTransform, SpawnParameters);
+	if (Hero && ActorPool)
+	{
+		ActorPool->CountSpawned(EPooledKind::Hero);
+	}
+
+	return Hero;
+}
+
+ASpectatorPawn* UGSActorPoolSubsystem::AcquireSpectator(UWorld* World, TSubclassOf<ASpectatorPawn> SpectatorClass, const FTransform& SpawnTransform)
+{
+	if (!World || !SpectatorClass)
+	{
+		return nullptr;
+	}
+
+	UGSActorPoolSubsystem* ActorPool = GetActorPool(World);
+	if (ActorPool)
+	{
+		if (ASpectatorPawn* SpectatorPawn = Cast<ASpectatorPawn>(ActorPool->AcquireActor(SpectatorClass, SpawnTransform)))
+		{
+			return SpectatorPawn;
+		}
+	}
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	ASpectatorPawn* SpectatorPawn = World->SpawnActor<ASpectatorPawn>(SpectatorClass, SpawnTransform, SpawnParameters);
+	if (SpectatorPawn && ActorPool)
+	{
+		ActorPool->CountSpawned(EPooledKind::Spectator);
+	}
+
+	return SpectatorPawn;
+}
+
+AGSWeapon* UGSActorPoolSubsystem::AcquireWeapon(TSubclassOf<AGSWeapon> WeaponClass, AGSHeroCharacter* InOwner)
+{
+	UWorld* World = InOwner ? InOwner->GetWorld() : nullptr;
+	if (!World || !WeaponClass)
+	{
+		return nullptr;
+	}
+
+	UGSActorPoolSubsystem* ActorPool = GetActorPool(World);
+	if (ActorPool)
+	{
+		if (AGSWeapon* Weapon = Cast<AGSWeapon>(ActorPool->AcquireActor(WeaponClass, FTransform::Identity)))
+		{
+			Weapon->OnAcquiredFromPool(InOwner);
+			return Weapon;
+		}
+	}
+
+	AGSWeapon* Weapon = World->SpawnActorDeferred<AGSWeapon>(WeaponClass, FTransform::Identity, InOwner, InOwner, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+	if (Weapon)
+	{
+		Weapon->bSpawnWithCollision = false;
+		Weapon->FinishSpawning(FTransform::Identity);
+
+		if (ActorPool)
+		{
+			ActorPool->CountSpawned(EPooledKind::Weapon);
+		}
+	}
+
+	return Weapon;
+}
+
+void UGSActorPoolSubsystem::Release(AActor* Actor)
+{
+	if (!IsValid(Actor))
+	{
+		return;
+	}
+
+	if (UGSActorPoolSubsystem* ActorPool = GetActorPool(Actor->GetWorld()))
+	{
+		ActorPool->ReleaseActor(Actor);
+	}
+	else
+	{
+		Actor->Destroy();
+	}
+}
+
+void UGSActorPoolSubsystem::LogReport() const
+{
+	UE_LOG(LogGASShooterALS, Log, TEXT("GS.Pool.Report: pooling %s, %d garbage collections, %d live UObjects"),
+		CVarActorPoolEnabled.GetValueOnGameThread() != 0 ? TEXT("on") : TEXT("off"), NumGarbageCollections, GUObjectArray.GetObjectArrayNumMinusAvailable());
+
+	for (uint8 Kind = 0; Kind < (uint8)EPooledKind::Count; Kind++)
+	{
+		const FPoolCounters& KindCounters = Counters[Kind];
+		UE_LOG(LogGASShooterALS, Log, TEXT("  %-10s spawned %5d  reused %5d  released %5d  destroyed %5d"), GetKindName((EPooledKind)Kind),
+			KindCounters.Spawned, KindCounters.Reused, KindCounters.Released, KindCounters.Destroyed);
+	}
+
+	for (const TPair<const UClass*, TArray<TWeakObjectPtr<AActor>>>& Pair : FreeActors)
+	{
+		UE_LOG(LogGASShooterALS, Log, TEXT("  %s: %d pooled"), *GetNameSafe(Pair.Key), Pair.Value.Num());
+	}
+}
+
+void UGSActorPoolSubsystem::ResetCounters()
+{
+	for (FPoolCounters& KindCounters : Counters)
+	{
+		KindCounters = FPoolCounters();
+	}
+
+	NumGarbageCollections = 0;
+
+	UpdateStats();
+}
+
+UGSActorPoolSubsystem::EPooledKind UGSActorPoolSubsystem::GetKind(const AActor* Actor)
+{
+	if (Actor->IsA<AGSHeroCharacter>())
+	{
+		return EPooledKind::Hero;
+	}
+	else if (Actor->IsA<ASpectatorPawn>())
+	{
+		return EPooledKind::Spectator;
+	}
+	else if (Actor->IsA<AGSWeapon>())
+	{
+		return EPooledKind::Weapon;
+	}
+
+	return EPooledKind::Other;
+}
+
+const TCHAR* UGSActorPoolSubsystem::GetKindName(EPooledKind Kind)
+{
+	switch (Kind)
+	{
+	case EPooledKind::Hero:
+		return TEXT("Heroes");
+	case EPooledKind::Spectator:
+		return TEXT("Spectators");
+	case EPooledKind::Weapon:
+		return TEXT("Weapons");
+	default:
+		return TEXT("Other");
+	}
+}
+
+AActor* UGSActorPoolSubsystem::AcquireActor(UClass* Class, const FTransform& SpawnTransform)
+{
+	TArray<TWeakObjectPtr<AActor>>* Pool = FreeActors.Find(Class);
+	if (!Pool || CVarActorPoolEnabled.GetValueOnGameThread() == 0)
+	{
+		return nullptr;
+	}
+
+	while (Pool->Num() > 0)
+	{
+		// Anything destroyed while pooled, like by a level streaming out, is skipped
+		AActor* Actor = Pool->Pop(false).Get();
+		if (IsValid(Actor))
+		{
+			UnparkActor(Actor, SpawnTransform);
+			Counters[(uint8)GetKind(Actor)].Reused++;
+			UpdateStats();
+			return Actor;
+		}
+	}
+
+	return nullptr;
+}
+
+void UGSActorPoolSubsystem::ReleaseActor(AActor* Actor)
+{
+	const EPooledKind Kind = GetKind(Actor);
+	FPoolCounters& KindCounters = Counters[(uint8)Kind];
+
+	if (APawn* Pawn = Cast<APawn>(Actor))
+	{
+		if (AController* Controller = Pawn->GetController())
+		{
+			UE_LOG(LogGASShooterALS, Warning, TEXT("%s %s is still possessed by %s. Unpossessing it."), *FString(__FUNCTION__), *GetNameSafe(Pawn), *GetNameSafe(Controller));
+			Controller->UnPossess();
+		}
+	}
+
+	TArray<TWeakObjectPtr<AActor>>& Pool = FreeActors.FindOrAdd(Actor->GetClass());
+	if (Kind == EPooledKind::Other || !Actor->HasAuthority() || Pool.Num() >= MaxPooledActorsPerClass || CVarActorPoolEnabled.GetValueOnGameThread() == 0)
+	{
+		Actor->Destroy();
+		KindCounters.Destroyed++;
+		UpdateStats();
+		return;
+	}
+
+	if (AGSHeroCharacter* Hero = Cast<AGSHeroCharacter>(Actor))
+	{
+		Hero->OnReturnedToPool();
+	}
+	else if (AGSWeapon* Weapon = Cast<AGSWeapon>(Actor))
+	{
+		Weapon->OnReturnedToPool();
+	}
+
+	ParkActor(Actor);
+	Pool.Add(Actor);
+	KindCounters.Released++;
+	UpdateStats();
+}
+
+void UGSActorPoolSubsystem::CountSpawned(EPooledKind Kind)
+{
+	Counters[(uint8)Kind].Spawned++;
+	UpdateStats();
+}
+
+void UGSActorPoolSubsystem::ParkActor(AActor* Actor)
+{
+	Actor->SetActorHiddenInGame(true);
+	Actor->SetActorEnableCollision(false);
+	Actor->SetActorTickEnabled(false);
+
+	// Replicate the hidden state once more, then nothing changes until the actor is acquired again
+	Actor->SetNetDormancy(DORM_DormantAll);
+	Actor->FlushNetDormancy();
+}
+
+void UGSActorPoolSubsystem::UnparkActor(AActor* Actor, const FTransform& SpawnTransform)
+{
+	Actor->SetNetDormancy(DORM_Awake);
+	Actor->SetActorEnableCollision(true);
+
+	// Same as spawning with AdjustIfPossibleButAlwaysSpawn
+	if (!Actor->TeleportTo(SpawnTransform.GetLocation(), SpawnTransform.Rotator()))
+	{
+		Actor->SetActorLocationAndRotation(SpawnTransform.GetLocation(), SpawnTransform.GetRotation(), false, nullptr, ETeleportType::TeleportPhysics);
+	}
+
+	Actor->SetActorHiddenInGame(false);
+	Actor->SetActorTickEnabled(true);
+	Actor->ForceNetUpdate();
+}
+
+void UGSActorPoolSubsystem::UpdateStats() const
+{
+	int32 NumPooled = 0;
+	for (const TPair<const UClass*, TArray<TWeakObjectPtr<AActor>>>& Pair : FreeActors)
+	{
+		NumPooled += Pair.Value.Num();
+	}
+
+	int32 NumSpawned = 0;
+	int32 NumReused = 0;
+	int32 NumDestroyed = 0;
+	for (const FPoolCounters& KindCounters : Counters)
+	{
+		NumSpawned += KindCounters.Spawned;
+		NumReused += KindCounters.Reused;
+		NumDestroyed += KindCounters.Destroyed;
+	}
+
+	SET_DWORD_STAT(STAT_GSActorPool_Pooled, NumPooled);
+	SET_DWORD_STAT(STAT_GSActorPool_Spawned, NumSpawned);
+	SET_DWORD_STAT(STAT_GSActorPool_Reused, NumReused);
+	SET_DWORD_STAT(STAT_GSActorPool_Destroyed, NumDestroyed);
+	SET_DWORD_STAT(STAT_GSActorPool_GarbageCollections, NumGarbageCollections);
+}
+
+void UGSActorPoolSubsystem::OnPostGarbageCollect()
+{
+	NumGarbageCollections++;
+	SET_DWORD_STAT(STAT_GSActorPool_GarbageCollections, NumGarbageCollections);
+}
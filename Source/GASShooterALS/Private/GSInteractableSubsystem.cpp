@@ -0,0 +1,516 @@
+// Copyright 2020 Dan Kestranek.
+
+
+#include "GSInteractableSubsystem.h"
+#include "Characters/Abilities/GSInteractable.h"
+#include "Engine/CollisionProfile.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "GASShooterALS/GASShooterALS.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Update Grid"), STAT_GSInteractables_UpdateGrid, STATGROUP_GSInteractables);
+DECLARE_CYCLE_STAT(TEXT("Query"), STAT_GSInteractables_Query, STATGROUP_GSInteractables);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Queries"), STAT_GSInteractables_Queries, STATGROUP_GSInteractables);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Skipped Scans"), STAT_GSInteractables_SkippedScans, STATGROUP_GSInteractables);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Registered Interactables"), STAT_GSInteractables_Registered, STATGROUP_GSInteractables);
+
+static FAutoConsoleCommandWithWorldAndArgs CmdInteractablesBenchmark(
+	TEXT("GS.Interactables.Benchmark"),
+	TEXT("Compares interactable grid queries against the traces they replace. Usage: GS.Interactables.Benchmark [Players] [Interactables]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		UGSInteractableSubsystem* Interactables = World ? World->GetSubsystem<UGSInteractableSubsystem>() : nullptr;
+		if (!Interactables)
+		{
+			UE_LOG(LogGASShooterALS, Warning, TEXT("GS.Interactables.Benchmark: no interactable subsystem in this world"));
+			return;
+		}
+
+		const int32 NumPlayers = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 64;
+		const int32 NumInteractables = Args.Num() > 1 ? FMath::Max(0, FCString::Atoi(*Args[1])) : 500;
+		Interactables->RunBenchmark(NumPlayers, NumInteractables);
+	})
+);
+
+FGSInteractableGrid::FGSInteractableGrid(float InCellSize)
+	: CellSize(FMath::Max(1.0f, InCellSize)), MaxRadius(0.0f), RevisionCounter(0)
+{
+}
+
+int32 FGSInteractableGrid::Add(const FVector& Location, float Radius, const AActor* Actor)
+{
+	const int32 Handle = FreeEntries.Num() > 0 ? FreeEntries.Pop(false) : Entries.AddUninitialized();
+
+	FEntry& Entry = Entries[Handle];
+	Entry.Location = Location;
+	Entry.Radius = Radius;
+	Entry.Actor = Actor;
+	Entry.Cell = GetCell(Location);
+	Entry.Revision = ++RevisionCounter;
+	Entry.bInUse = true;
+
+	Cells.FindOrAdd(Entry.Cell).Add(Handle);
+	MaxRadius = FMath::Max(MaxRadius, Radius);
+
+	return Handle;
+}
+
+void FGSInteractableGrid::Remove(int32 Handle)
+{
+	if (!Entries.IsValidIndex(Handle) || !Entries[Handle].bInUse)
+	{
+		return;
+	}
+
+	FEntry& Entry = Entries[Handle];
+
+	if (TArray<int32>* Cell = Cells.Find(Entry.Cell))
+	{
+		Cell->RemoveSingleSwap(Handle, false);
+
+		if (Cell->Num() == 0)
+		{
+			Cells.Remove(Entry.Cell);
+		}
+	}
+
+	Entry.Actor = nullptr;
+	Entry.bInUse = false;
+	FreeEntries.Add(Handle);
+}
+
+void FGSInteractableGrid::Update(int32 Handle, const FVector& Location)
+{
+	if (!Entries.IsValidIndex(Handle) || !Entries[Handle].bInUse)
+	{
+		return;
+	}
+
+	FEntry& Entry = Entries[Handle];
+	if (Entry.Location.Equals(Location, KINDA_SMALL_NUMBER))
+	{
+		return;
+	}
+
+	Entry.Location = Location;
+	Entry.Revision = ++RevisionCounter;
+
+	const FIntVector NewCell = GetCell(Location);
+	if (NewCell == Entry.Cell)
+	{
+		return;
+	}
+
+	if (TArray<int32>* OldCell = Cells.Find(Entry.Cell))
+	{
+		OldCell->RemoveSingleSwap(Handle, false);
+
+		if (OldCell->Num() == 0)
+		{
+			Cells.Remove(Entry.Cell);
+		}
+	}
+
+	Entry.Cell = NewCell;
+	Cells.FindOrAdd(NewCell).Add(Handle);
+}
+
+void FGSInteractableGrid::Reset()
+{
+	Entries.Reset();
+	FreeEntries.Reset();
+	Cells.Reset();
+	MaxRadius = 0.0f;
+}
+
+template <typename VisitorType>
+bool FGSInteractableGrid::VisitCandidates(const FVector& Origin, const FVector& Direction, float Range, float ConeHalfAngleRadians, const AActor* IgnoreActor, VisitorType Visitor) const
+{
+	if (Num() == 0)
+	{
+		return false;
+	}
+
+	const FVector QueryExtent(Range + MaxRadius);
+	const FIntVector MinCell = GetCell(Origin - QueryExtent);
+	const FIntVector MaxCell = GetCell(Origin + QueryExtent);
+
+	const int64 NumQueryCells = int64(MaxCell.X - MinCell.X + 1) * int64(MaxCell.Y - MinCell.Y + 1) * int64(MaxCell.Z - MinCell.Z + 1);
+	if (NumQueryCells > Cells.Num())
+	{
+		// Long range query, walking the occupied cells is cheaper than walking the query box
+		for (const TPair<FIntVector, TArray<int32>>& Cell : Cells)
+		{
+			const FIntVector& Key = Cell.Key;
+			if (Key.X < MinCell.X || Key.Y < MinCell.Y || Key.Z < MinCell.Z || Key.X > MaxCell.X || Key.Y > MaxCell.Y || Key.Z > MaxCell.Z)
+			{
+				continue;
+			}
+
+			for (int32 Handle : Cell.Value)
+			{
+				const FEntry& Entry = Entries[Handle];
+				if (IsCandidate(Entry, Origin, Direction, Range, ConeHalfAngleRadians, IgnoreActor) && Visitor(Entry))
+				{
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			for (int32 Z = MinCell.Z; Z <= MaxCell.Z; Z++)
+			{
+				const TArray<int32>* Cell = Cells.Find(FIntVector(X, Y, Z));
+				if (!Cell)
+				{
+					continue;
+				}
+
+				for (int32 Handle : *Cell)
+				{
+					const FEntry& Entry = Entries[Handle];
+					if (IsCandidate(Entry, Origin, Direction, Range, ConeHalfAngleRadians, IgnoreActor) && Visitor(Entry))
+					{
+						return true;
+					}
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+bool FGSInteractableGrid::HasCandidate(const FVector& Origin, const FVector& Direction, float Range, float ConeHalfAngleRadians, const AActor* IgnoreActor) const
+{
+	return VisitCandidates(Origin, Direction, Range, ConeHalfAngleRadians, IgnoreActor, [](const FEntry& Entry)
+	{
+		return true;
+	});
+}
+
+int32 FGSInteractableGrid::CountCandidates(const FVector& Origin, const FVector& Direction, float Range, float ConeHalfAngleRadians, const AActor* IgnoreActor, uint32& OutNewestRevision) const
+{
+	int32 NumCandidates = 0;
+	OutNewestRevision = 0;
+
+	VisitCandidates(Origin, Direction, Range, ConeHalfAngleRadians, IgnoreActor, [&NumCandidates, &OutNewestRevision](const FEntry& Entry)
+	{
+		NumCandidates++;
+		OutNewestRevision = FMath::Max(OutNewestRevision, Entry.Revision);
+		return false;
+	});
+
+	return NumCandidates;
+}
+
+bool FGSInteractableGrid::IsCandidate(const FEntry& Entry, const FVector& Origin, const FVector& Direction, float Range, float ConeHalfAngleRadians, const AActor* IgnoreActor) const
+{
+	if (!Entry.bInUse || (IgnoreActor && Entry.Actor == IgnoreActor))
+	{
+		return false;
+	}
+
+	const FVector ToEntry = Entry.Location - Origin;
+	const float Distance = ToEntry.Size();
+
+	if (Distance > Range + Entry.Radius)
+	{
+		return false;
+	}
+
+	if (Distance <= Entry.Radius)
+	{
+		// Origin is inside the bounds
+		return true;
+	}
+
+	// Angle to the center minus the angle the bounding sphere covers
+	const float AngleToCenter = FMath::Acos(FMath::Clamp(FVector::DotProduct(ToEntry / Distance, Direction), -1.0f, 1.0f));
+	const float AngularRadius = FMath::Asin(FMath::Clamp(Entry.Radius / Distance, 0.0f, 1.0f));
+
+	return AngleToCenter - AngularRadius <= ConeHalfAngleRadians;
+}
+
+UGSInteractableSubsystem::UGSInteractableSubsystem()
+{
+	CellSize = 500.0f;
+}
+
+bool UGSInteractableSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+void UGSInteractableSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Grid = FGSInteractableGrid(CellSize);
+
+	UWorld* World = GetWorld();
+	ActorSpawnedHandle = World->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &UGSInteractableSubsystem::OnActorSpawned));
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UGSInteractableSubsystem::OnLevelAddedToWorld);
+}
+
+void UGSInteractableSubsystem::Deinitialize()
+{
+	if (UWorld* World = GetWorld())
+	{
+		World->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	}
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+
+	Grid.Reset();
+	Interactables.Empty();
+	InteractableIndexByActor.Empty();
+	SET_DWORD_STAT(STAT_GSInteractables_Registered, 0);
+
+	Super::Deinitialize();
+}
+
+void UGSInteractableSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// Actors saved in the levels are loaded, not spawned
+	for (ULevel* Level : InWorld.GetLevels())
+	{
+		RegisterLevelInteractables(Level);
+	}
+}
+
+void UGSInteractableSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_GSInteractables_UpdateGrid);
+
+	for (int32 Index = Interactables.Num() - 1; Index >= 0; Index--)
+	{
+		const FInteractable& Interactable = Interactables[Index];
+
+		AActor* Actor = Interactable.Actor.Get();
+		if (!Actor)
+		{
+			RemoveInteractableAt(Index);
+			continue;
+		}
+
+		if (Interactable.bMovable)
+		{
+			Grid.Update(Interactable.GridHandle, Actor->GetActorLocation());
+		}
+	}
+}
+
+ETickableTickType UGSInteractableSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+bool UGSInteractableSubsystem::IsTickable() const
+{
+	return Interactables.Num() > 0;
+}
+
+TStatId UGSInteractableSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGSInteractableSubsystem, STATGROUP_Tickables);
+}
+
+UWorld* UGSInteractableSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+void UGSInteractableSubsystem::RegisterInteractable(AActor* Actor)
+{
+	if (!Actor || Actor->IsPendingKill() || InteractableIndexByActor.Contains(Actor))
+	{
+		return;
+	}
+
+	// Bounding sphere around the Actor's location so it stays valid when the Actor moves
+	FVector BoundsOrigin, BoundsExtent;
+	Actor->GetActorBounds(false, BoundsOrigin, BoundsExtent);
+
+	const FVector ActorLocation = Actor->GetActorLocation();
+	const float Radius = BoundsExtent.Size() + FVector::Dist(BoundsOrigin, ActorLocation);
+
+	const USceneComponent* RootComponent = Actor->GetRootComponent();
+
+	FInteractable Interactable;
+	Interactable.Actor = Actor;
+	Interactable.ActorKey = Actor;
+	Interactable.GridHandle = Grid.Add(ActorLocation, Radius, Actor);
+	Interactable.bMovable = RootComponent && RootComponent->Mobility == EComponentMobility::Movable;
+
+	InteractableIndexByActor.Add(Actor, Interactables.Add(Interactable));
+	SET_DWORD_STAT(STAT_GSInteractables_Registered, Interactables.Num());
+}
+
+void UGSInteractableSubsystem::UnregisterInteractable(AActor* Actor)
+{
+	if (const int32* Index = InteractableIndexByActor.Find(Actor))
+	{
+		RemoveInteractableAt(*Index);
+	}
+}
+
+bool UGSInteractableSubsystem::HasInteractableCandidate(const FVector& Origin, const FVector& Direction, float Range, float ConeHalfAngleRadians, const AActor* IgnoreActor) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_GSInteractables_Query);
+	INC_DWORD_STAT(STAT_GSInteractables_Queries);
+
+	const bool bHasCandidate = Grid.HasCandidate(Origin, Direction, Range, ConeHalfAngleRadians, IgnoreActor);
+
+	if (!bHasCandidate)
+	{
+		INC_DWORD_STAT(STAT_GSInteractables_SkippedScans);
+	}
+
+	return bHasCandidate;
+}
+
+int32 UGSInteractableSubsystem::CountInteractableCandidates(const FVector& Origin, const FVector& Direction, float Range, float ConeHalfAngleRadians, const AActor* IgnoreActor, uint32& OutNewestRevision) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_GSInteractables_Query);
+	INC_DWORD_STAT(STAT_GSInteractables_Queries);
+
+	const int32 NumCandidates = Grid.CountCandidates(Origin, Direction, Range, ConeHalfAngleRadians, IgnoreActor, OutNewestRevision);
+
+	if (NumCandidates == 0)
+	{
+		INC_DWORD_STAT(STAT_GSInteractables_SkippedScans);
+	}
+
+	return NumCandidates;
+}
+
+void UGSInteractableSubsystem::NotifyAvailabilityChanged(AActor* Interactable)
+{
+	OnAvailabilityChanged.Broadcast(Interactable);
+}
+
+void UGSInteractableSubsystem::RunBenchmark(int32 NumPlayers, int32 NumInteractables) const
+{
+	// Roughly a large map with the default WaitForInteractableTarget range and a hemisphere cone
+	const float MapHalfExtent = 10000.0f;
+	const float MapHeight = 1000.0f;
+	const float Range = 200.0f;
+	const float ConeHalfAngle = HALF_PI;
+	const int32 ScansPerPlayer = 100;
+
+	FRandomStream RandomStream(NumPlayers * 7919 + NumInteractables);
+
+	FGSInteractableGrid BenchmarkGrid(CellSize);
+	for (int32 InteractableIndex = 0; InteractableIndex < NumInteractables; InteractableIndex++)
+	{
+		const FVector Location(RandomStream.FRandRange(-MapHalfExtent, MapHalfExtent), RandomStream.FRandRange(-MapHalfExtent, MapHalfExtent), RandomStream.FRandRange(0.0f, MapHeight));
+		BenchmarkGrid.Add(Location, RandomStream.FRandRange(25.0f, 100.0f), nullptr);
+	}
+
+	// Build the scans up front so only the queries are timed
+	const int32 NumScans = NumPlayers * ScansPerPlayer;
+	TArray<FVector> Origins;
+	TArray<FVector> Directions;
+	Origins.SetNumUninitialized(NumScans);
+	Directions.SetNumUninitialized(NumScans);
+	for (int32 ScanIndex = 0; ScanIndex < NumScans; ScanIndex++)
+	{
+		Origins[ScanIndex] = FVector(RandomStream.FRandRange(-MapHalfExtent, MapHalfExtent), RandomStream.FRandRange(-MapHalfExtent, MapHalfExtent), RandomStream.FRandRange(0.0f, MapHeight));
+		Directions[ScanIndex] = RandomStream.GetUnitVector();
+	}
+
+	int32 NumCandidateScans = 0;
+	const uint64 QueryStartCycles = FPlatformTime::Cycles64();
+	for (int32 ScanIndex = 0; ScanIndex < NumScans; ScanIndex++)
+	{
+		if (BenchmarkGrid.HasCandidate(Origins[ScanIndex], Directions[ScanIndex], Range, ConeHalfAngle, nullptr))
+		{
+			NumCandidateScans++;
+		}
+	}
+	const uint64 QueryEndCycles = FPlatformTime::Cycles64();
+
+	// What every scan costs without the grid: the camera trace and the interaction trace
+	double TraceMicrosecondsPerScan = 0.0;
+	if (UWorld* World = GetWorld())
+	{
+		FCollisionQueryParams Params(SCENE_QUERY_STAT(GSInteractablesBenchmark), false);
+		TArray<FHitResult> HitResults;
+
+		const uint64 TraceStartCycles = FPlatformTime::Cycles64();
+		for (int32 ScanIndex = 0; ScanIndex < NumPlayers; ScanIndex++)
+		{
+			const FVector End = Origins[ScanIndex] + Directions[ScanIndex] * Range;
+			World->LineTraceMultiByProfile(HitResults, Origins[ScanIndex], End, UCollisionProfile::BlockAll_ProfileName, Params);
+			World->LineTraceMultiByProfile(HitResults, Origins[ScanIndex], End, UCollisionProfile::BlockAll_ProfileName, Params);
+		}
+		const uint64 TraceEndCycles = FPlatformTime::Cycles64();
+
+		TraceMicrosecondsPerScan = FPlatformTime::ToMilliseconds64(TraceEndCycles - TraceStartCycles) * 1000.0 / NumPlayers;
+	}
+
+	const double QueryMicrosecondsPerScan = FPlatformTime::ToMilliseconds64(QueryEndCycles - QueryStartCycles) * 1000.0 / NumScans;
+	const float SkippedPercent = 100.0f * (NumScans - NumCandidateScans) / NumScans;
+
+	UE_LOG(LogGASShooterALS, Log, TEXT("GS.Interactables.Benchmark: %d players, %d interactables. Grid query %.3f us per scan, %.1f%% of scans skip tracing. Two traces cost %.3f us per scan in this world."),
+		NumPlayers, NumInteractables, QueryMicrosecondsPerScan, SkippedPercent, TraceMicrosecondsPerScan);
+}
+
+void UGSInteractableSubsystem::OnActorSpawned(AActor* Actor)
+{
+	if (Actor && Actor->Implements<UGSInteractable>())
+	{
+		RegisterInteractable(Actor);
+	}
+}
+
+void UGSInteractableSubsystem::OnLevelAddedToWorld(ULevel* Level, UWorld* World)
+{
+	if (World == GetWorld() && World->HasBegunPlay())
+	{
+		RegisterLevelInteractables(Level);
+	}
+}
+
+void UGSInteractableSubsystem::RegisterLevelInteractables(ULevel* Level)
+{
+	if (!Level)
+	{
+		return;
+	}
+
+	for (AActor* Actor : Level->Actors)
+	{
+		if (Actor && Actor->Implements<UGSInteractable>())
+		{
+			RegisterInteractable(Actor);
+		}
+	}
+}
+
+void UGSInteractableSubsystem::RemoveInteractableAt(int32 Index)
+{
+	const FInteractable& Interactable = Interactables[Index];
+	Grid.Remove(Interactable.GridHandle);
+	InteractableIndexByActor.Remove(Interactable.ActorKey);
+
+	Interactables.RemoveAtSwap(Index, 1, false);
+
+	if (Interactables.IsValidIndex(Index))
+	{
+		// The last Interactable moved into Index
+		InteractableIndexByActor.Add(Interactables[Index].ActorKey, Index);
+	}
+
+	SET_DWORD_STAT(STAT_GSInteractables_Registered, Interactables.Num());
+}
@@ -0,0 +1,387 @@
+// Copyright 2020 Dan Kestranek.
+
+
+#include "GSLagCompensationSubsystem.h"
+#include "Characters/Heroes/GSHeroCharacter.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/World.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/PlayerState.h"
+#include "GASShooterALS/GASShooterALS.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_STATS_GROUP(TEXT("GSLagCompensation"), STATGROUP_GSLagCompensation, STATCAT_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Record Frame"), STAT_GSLagCompensation_RecordFrame, STATGROUP_GSLagCompensation);
+DECLARE_CYCLE_STAT(TEXT("Validate Hit"), STAT_GSLagCompensation_ValidateHit, STATGROUP_GSLagCompensation);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Validated Hits"), STAT_GSLagCompensation_ValidatedHits, STATGROUP_GSLagCompensation);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Rejected Hits"), STAT_GSLagCompensation_RejectedHits, STATGROUP_GSLagCompensation);
+
+static TAutoConsoleVariable<float> CVarLagCompensationTolerance(
+	TEXT("GS.LagCompensation.Tolerance"),
+	15.0f,
+	TEXT("Distance (cm) a rewound hit may be outside of the capsule or hitbox and still be accepted")
+);
+
+static TAutoConsoleVariable<float> CVarLagCompensationInterpDelay(
+	TEXT("GS.LagCompensation.InterpDelay"),
+	0.05f,
+	TEXT("Seconds added on top of the shooter's ping to account for simulated proxy smoothing on the client")
+);
+
+static FAutoConsoleCommandWithWorldAndArgs CmdLagCompensationBenchmark(
+	TEXT("GS.LagCompensation.Benchmark"),
+	TEXT("Runs synthetic hit validations against the recorded history and logs the rewind cost per shot. Usage: GS.LagCompensation.Benchmark [Shots]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		UGSLagCompensationSubsystem* LagCompensation = World ? World->GetSubsystem<UGSLagCompensationSubsystem>() : nullptr;
+		if (!LagCompensation)
+		{
+			UE_LOG(LogGASShooterALS, Warning, TEXT("GS.LagCompensation.Benchmark: no lag compensation subsystem in this world"));
+			return;
+		}
+
+		const int32 NumShots = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 10000;
+		const double MicrosecondsPerShot = LagCompensation->RunBenchmark(NumShots);
+		UE_LOG(LogGASShooterALS, Log, TEXT("GS.LagCompensation.Benchmark: %d shots, %.3f us per validated shot"), NumShots, MicrosecondsPerShot);
+	})
+);
+
+UGSLagCompensationSubsystem::UGSLagCompensationSubsystem()
+{
+	MaxTrackedHeroes = 64;
+	MaxHistoryFrames = 64;
+	MaxRewindTime = 0.5f;
+	FrameHead = INDEX_NONE;
+}
+
+bool UGSLagCompensationSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+void UGSLagCompensationSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	if (Hitboxes.Num() == 0)
+	{
+		Hitboxes.Add(FGSLagCompensationHitbox(FName("head"), 15.0f));
+		Hitboxes.Add(FGSLagCompensationHitbox(FName("spine_03"), 25.0f));
+		Hitboxes.Add(FGSLagCompensationHitbox(FName("pelvis"), 25.0f));
+	}
+
+	MaxTrackedHeroes = FMath::Max(1, MaxTrackedHeroes);
+	MaxHistoryFrames = FMath::Max(2, MaxHistoryFrames);
+
+	Slots.SetNum(MaxTrackedHeroes);
+	FreeSlots.Reserve(MaxTrackedHeroes);
+	for (int32 SlotIndex = MaxTrackedHeroes - 1; SlotIndex >= 0; SlotIndex--)
+	{
+		FreeSlots.Add(SlotIndex);
+	}
+	SlotIndexByHero.Reserve(MaxTrackedHeroes);
+
+	BoneIndices.Init(INDEX_NONE, MaxTrackedHeroes * Hitboxes.Num());
+	FrameTimestamps.Init(0.0f, MaxHistoryFrames);
+	Frames.SetNumZeroed(MaxTrackedHeroes * MaxHistoryFrames);
+	HitboxLocations.SetNumZeroed(MaxTrackedHeroes * MaxHistoryFrames * Hitboxes.Num());
+	RewoundHitboxLocations.SetNumZeroed(Hitboxes.Num());
+	FrameHead = INDEX_NONE;
+}
+
+void UGSLagCompensationSubsystem::Deinitialize()
+{
+	Slots.Empty();
+	FreeSlots.Empty();
+	SlotIndexByHero.Empty();
+	BoneIndices.Empty();
+	FrameTimestamps.Empty();
+	Frames.Empty();
+	HitboxLocations.Empty();
+	RewoundHitboxLocations.Empty();
+
+	Super::Deinitialize();
+}
+
+void UGSLagCompensationSubsystem::Tick(float DeltaTime)
+{
+	RecordFrame(GetWorld()->GetTimeSeconds());
+}
+
+ETickableTickType UGSLagCompensationSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+bool UGSLagCompensationSubsystem::IsTickable() const
+{
+	// Heroes only register on the server so there is nothing to record on clients
+	return SlotIndexByHero.Num() > 0;
+}
+
+TStatId UGSLagCompensationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGSLagCompensationSubsystem, STATGROUP_Tickables);
+}
+
+UWorld* UGSLagCompensationSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+void UGSLagCompensationSubsystem::RegisterHero(AGSHeroCharacter* Hero)
+{
+	if (!Hero || SlotIndexByHero.Contains(Hero))
+	{
+		return;
+	}
+
+	if (FreeSlots.Num() == 0)
+	{
+		UE_LOG(LogGASShooterALS, Warning, TEXT("%s All %d lag compensation slots are in use, %s will not be rewound"), *FString(__FUNCTION__), MaxTrackedHeroes, *GetNameSafe(Hero));
+		return;
+	}
+
+	const int32 SlotIndex = FreeSlots.Pop(false);
+	FHeroSlot& Slot = Slots[SlotIndex];
+	Slot.Hero = Hero;
+	Slot.BoneIndexOffset = SlotIndex * Hitboxes.Num();
+	Slot.NumValidFrames = 0;
+	Slot.CachedSkeletalMesh = nullptr;
+	RefreshBoneIndices(Slot, SlotIndex);
+
+	SlotIndexByHero.Add(Hero, SlotIndex);
+}
+
+void UGSLagCompensationSubsystem::UnregisterHero(AGSHeroCharacter* Hero)
+{
+	int32 SlotIndex = INDEX_NONE;
+	if (SlotIndexByHero.RemoveAndCopyValue(Hero, SlotIndex))
+	{
+		Slots[SlotIndex] = FHeroSlot();
+		FreeSlots.Add(SlotIndex);
+	}
+}
+
+float UGSLagCompensationSubsystem::GetRewindTimeForShooter(const AController* Shooter, float ShotAge) const
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	const APlayerState* PS = Shooter ? Shooter->PlayerState : nullptr;
+	if (!PS || Shooter->IsLocalController())
+	{
+		// Listen server host and AI see the present
+		return Now;
+	}
+
+	// Ping is round trip. The client saw a world that was half a trip old and the shot took the other half to get here.
+	const float Latency = PS->GetPingInMilliseconds() * 0.001f + CVarLagCompensationInterpDelay.GetValueOnGameThread();
+	return Now - FMath::Clamp(Latency + ShotAge, 0.0f, MaxRewindTime);
+}
+
+bool UGSLagCompensationSubsystem::ValidateHit(const FHitResult& HitResult, float RewindTime) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_GSLagCompensation_ValidateHit);
+
+	const int32* SlotIndexPtr = SlotIndexByHero.Find(HitResult.Actor.Get());
+	if (!SlotIndexPtr)
+	{
+		return true;
+	}
+
+	FGSLagCompensationFrame Frame;
+	if (!RewindSlot(*SlotIndexPtr, RewindTime, Frame, RewoundHitboxLocations))
+	{
+		// No history yet, nothing to validate against
+		return true;
+	}
+
+	const float Tolerance = CVarLagCompensationTolerance.GetValueOnGameThread();
+
+	// Closest point on the capsule's inner segment, in capsule space
+	const FVector LocalImpact = Frame.CapsuleRotation.UnrotateVector(HitResult.ImpactPoint - Frame.CapsuleLocation);
+	const float SegmentHalfLength = FMath::Max(0.0f, Frame.CapsuleHalfHeight - Frame.CapsuleRadius);
+	const FVector ClosestOnSegment(0.0f, 0.0f, FMath::Clamp(LocalImpact.Z, -SegmentHalfLength, SegmentHalfLength));
+	const float MaxCapsuleDistance = Frame.CapsuleRadius + Tolerance;
+
+	bool bValid = FVector::DistSquared(LocalImpact, ClosestOnSegment) <= FMath::Square(MaxCapsuleDistance);
+
+	if (bValid && HitResult.BoneName != NAME_None)
+	{
+		for (int32 HitboxIndex = 0; HitboxIndex < Hitboxes.Num(); HitboxIndex++)
+		{
+			if (Hitboxes[HitboxIndex].BoneName == HitResult.BoneName)
+			{
+				const float MaxHitboxDistance = Hitboxes[HitboxIndex].Radius + Tolerance;
+				bValid = FVector::DistSquared(HitResult.ImpactPoint, RewoundHitboxLocations[HitboxIndex]) <= FMath::Square(MaxHitboxDistance);
+				break;
+			}
+		}
+	}
+
+	if (bValid)
+	{
+		INC_DWORD_STAT(STAT_GSLagCompensation_ValidatedHits);
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_GSLagCompensation_RejectedHits);
+	}
+
+	return bValid;
+}
+
+double UGSLagCompensationSubsystem::RunBenchmark(int32 NumShots) const
+{
+	TArray<int32, TInlineAllocator<64>> ActiveSlots;
+	for (const TPair<const AActor*, int32>& Pair : SlotIndexByHero)
+	{
+		if (Slots[Pair.Value].NumValidFrames > 0)
+		{
+			ActiveSlots.Add(Pair.Value);
+		}
+	}
+
+	if (ActiveSlots.Num() == 0 || FrameHead == INDEX_NONE)
+	{
+		return 0.0;
+	}
+
+	// Build the shots up front so only the validation is timed
+	FRandomStream RandomStream(NumShots);
+	TArray<FHitResult> Shots;
+	TArray<float> ShotTimes;
+	Shots.SetNum(NumShots);
+	ShotTimes.SetNumUninitialized(NumShots);
+
+	const float Newest = FrameTimestamps[FrameHead];
+	for (int32 ShotIndex = 0; ShotIndex < NumShots; ShotIndex++)
+	{
+		const int32 SlotIndex = ActiveSlots[ShotIndex % ActiveSlots.Num()];
+		const FGSLagCompensationFrame& Frame = Frames[GetFrameIndex(SlotIndex, FrameHead)];
+
+		FHitResult& Shot = Shots[ShotIndex];
+		Shot.Actor = Slots[SlotIndex].Hero;
+		Shot.ImpactPoint = Frame.CapsuleLocation + RandomStream.VRand() * Frame.CapsuleRadius;
+		Shot.BoneName = Hitboxes.Num() > 0 ? Hitboxes[ShotIndex % Hitboxes.Num()].BoneName : NAME_None;
+		ShotTimes[ShotIndex] = Newest - RandomStream.FRand() * MaxRewindTime;
+	}
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	for (int32 ShotIndex = 0; ShotIndex < NumShots; ShotIndex++)
+	{
+		ValidateHit(Shots[ShotIndex], ShotTimes[ShotIndex]);
+	}
+	const uint64 EndCycles = FPlatformTime::Cycles64();
+
+	return FPlatformTime::ToMilliseconds64(EndCycles - StartCycles) * 1000.0 / NumShots;
+}
+
+void UGSLagCompensationSubsystem::RecordFrame(float Timestamp)
+{
+	SCOPE_CYCLE_COUNTER(STAT_GSLagCompensation_RecordFrame);
+
+	FrameHead = (FrameHead + 1) % MaxHistoryFrames;
+	FrameTimestamps[FrameHead] = Timestamp;
+
+	for (const TPair<const AActor*, int32>& Pair : SlotIndexByHero)
+	{
+		const int32 SlotIndex = Pair.Value;
+		FHeroSlot& Slot = Slots[SlotIndex];
+
+		AGSHeroCharacter* Hero = Slot.Hero.Get();
+		if (!Hero)
+		{
+			// The head frame of this slot still holds whatever was recorded a full ring ago. Drop the history so it's never read.
+			Slot.NumValidFrames = 0;
+			continue;
+		}
+
+		const UCapsuleComponent* Capsule = Hero->GetCapsuleComponent();
+		FGSLagCompensationFrame& Frame = Frames[GetFrameIndex(SlotIndex, FrameHead)];
+		Frame.CapsuleLocation = Capsule->GetComponentLocation();
+		Frame.CapsuleRotation = Capsule->GetComponentQuat();
+		Frame.CapsuleRadius = Capsule->GetScaledCapsuleRadius();
+		Frame.CapsuleHalfHeight = Capsule->GetScaledCapsuleHalfHeight();
+
+		RefreshBoneIndices(Slot, SlotIndex);
+
+		const USkeletalMeshComponent* Mesh = Hero->GetMesh();
+		for (int32 HitboxIndex = 0; HitboxIndex < Hitboxes.Num(); HitboxIndex++)
+		{
+			const int32 BoneIndex = BoneIndices[Slot.BoneIndexOffset + HitboxIndex];
+
+			// Bones missing from the skeleton fall back to the capsule center
+			HitboxLocations[GetHitboxIndex(SlotIndex, FrameHead, HitboxIndex)] = BoneIndex != INDEX_NONE ?
+				Mesh->GetBoneTransform(BoneIndex).GetLocation() : Frame.CapsuleLocation;
+		}
+
+		Slot.NumValidFrames = FMath::Min(Slot.NumValidFrames + 1, MaxHistoryFrames);
+	}
+}
+
+void UGSLagCompensationSubsystem::RefreshBoneIndices(FHeroSlot& Slot, int32 SlotIndex)
+{
+	const AGSHeroCharacter* Hero = Slot.Hero.Get();
+	const USkeletalMeshComponent* Mesh = Hero ? Hero->GetMesh() : nullptr;
+	USkeletalMesh* SkeletalMesh = Mesh ? Mesh->SkeletalMesh : nullptr;
+
+	// Resolving bone names is a map lookup, only do it when the mesh changes
+	if (Slot.CachedSkeletalMesh.Get() == SkeletalMesh)
+	{
+		return;
+	}
+
+	Slot.CachedSkeletalMesh = SkeletalMesh;
+
+	for (int32 HitboxIndex = 0; HitboxIndex < Hitboxes.Num(); HitboxIndex++)
+	{
+		BoneIndices[Slot.BoneIndexOffset + HitboxIndex] = SkeletalMesh ? Mesh->GetBoneIndex(Hitboxes[HitboxIndex].BoneName) : INDEX_NONE;
+	}
+}
+
+bool UGSLagCompensationSubsystem::RewindSlot(int32 SlotIndex, float Time, FGSLagCompensationFrame& OutFrame, TArrayView<FVector> OutHitboxLocations) const
+{
+	const FHeroSlot& Slot = Slots[SlotIndex];
+	if (Slot.NumValidFrames == 0 || FrameHead == INDEX_NONE)
+	{
+		return false;
+	}
+
+	// Walk backwards from the newest frame until we find the frame at or before Time
+	int32 NewerRingIndex = FrameHead;
+	int32 OlderRingIndex = FrameHead;
+	for (int32 Age = 0; Age < Slot.NumValidFrames; Age++)
+	{
+		OlderRingIndex = (FrameHead - Age + MaxHistoryFrames) % MaxHistoryFrames;
+		if (FrameTimestamps[OlderRingIndex] <= Time)
+		{
+			break;
+		}
+
+		NewerRingIndex = OlderRingIndex;
+	}
+
+	const float OlderTime = FrameTimestamps[OlderRingIndex];
+	const float NewerTime = FrameTimestamps[NewerRingIndex];
+	const float Alpha = (NewerTime > OlderTime) ? FMath::Clamp((Time - OlderTime) / (NewerTime - OlderTime), 0.0f, 1.0f) : 0.0f;
+
+	const FGSLagCompensationFrame& OlderFrame = Frames[GetFrameIndex(SlotIndex, OlderRingIndex)];
+	const FGSLagCompensationFrame& NewerFrame = Frames[GetFrameIndex(SlotIndex, NewerRingIndex)];
+
+	OutFrame.CapsuleLocation = FMath::Lerp(OlderFrame.CapsuleLocation, NewerFrame.CapsuleLocation, Alpha);
+	OutFrame.CapsuleRotation = FQuat::FastLerp(OlderFrame.CapsuleRotation, NewerFrame.CapsuleRotation, Alpha).GetNormalized();
+	OutFrame.CapsuleRadius = FMath::Lerp(OlderFrame.CapsuleRadius, NewerFrame.CapsuleRadius, Alpha);
+	OutFrame.CapsuleHalfHeight = FMath::Lerp(OlderFrame.CapsuleHalfHeight, NewerFrame.CapsuleHalfHeight, Alpha);
+
+	for (int32 HitboxIndex = 0; HitboxIndex < OutHitboxLocations.Num(); HitboxIndex++)
+	{
+		OutHitboxLocations[HitboxIndex] = FMath::Lerp(HitboxLocations[GetHitboxIndex(SlotIndex, OlderRingIndex, HitboxIndex)],
+			HitboxLocations[GetHitboxIndex(SlotIndex, NewerRingIndex, HitboxIndex)], Alpha);
+	}
+
+	return true;
+}
@@ -0,0 +1,394 @@
+// Copyright 2020 Dan Kestranek.
+
+
+#include "GSNetUpdateFrequencySubsystem.h"
+#include "AbilitySystemComponent.h"
+#include "AbilitySystemGlobals.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "GASShooterALS/GASShooterALS.h"
+#include "GSReplicationGraph.h"
+#include "HAL/IConsoleManager.h"
+#include "Player/GSPlayerState.h"
+#include "Weapons/GSProjectile.h"
+#include "Weapons/GSWeapon.h"
+
+DECLARE_STATS_GROUP(TEXT("GSNetUpdateFrequency"), STATGROUP_GSNetUpdateFrequency, STATCAT_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Update Frequencies"), STAT_GSNetUpdateFrequency_Update, STATGROUP_GSNetUpdateFrequency);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Adaptive Actors"), STAT_GSNetUpdateFrequency_Actors, STATGROUP_GSNetUpdateFrequency);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Ceiling Net Updates/s"), STAT_GSNetUpdateFrequency_CeilingUpdates, STATGROUP_GSNetUpdateFrequency);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Adaptive Net Updates/s"), STAT_GSNetUpdateFrequency_AdaptiveUpdates, STATGROUP_GSNetUpdateFrequency);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Net Updates Saved/s"), STAT_GSNetUpdateFrequency_SavedUpdates, STATGROUP_GSNetUpdateFrequency);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Forced Net Updates"), STAT_GSNetUpdateFrequency_ForcedUpdates, STATGROUP_GSNetUpdateFrequency);
+
+static TAutoConsoleVariable<int32> CVarAdaptiveNetUpdateFrequency(
+	TEXT("GS.Net.AdaptiveFrequency"),
+	1,
+	TEXT("Whether registered actors have their NetUpdateFrequency adjusted at runtime. When off, every actor replicates at its ceiling.")
+);
+
+static FAutoConsoleCommandWithWorldAndArgs CmdNetAdaptiveFrequencyReport(
+	TEXT("GS.Net.AdaptiveFrequencyReport"),
+	TEXT("Logs the current NetUpdateFrequency, limits and change rate of every actor managed by the adaptive net update frequency subsystem"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		UGSNetUpdateFrequencySubsystem* NetUpdateFrequency = World ? World->GetSubsystem<UGSNetUpdateFrequencySubsystem>() : nullptr;
+		if (!NetUpdateFrequency)
+		{
+			UE_LOG(LogGASShooterALS, Warning, TEXT("GS.Net.AdaptiveFrequencyReport: no adaptive net update frequency subsystem in this world"));
+			return;
+		}
+
+		NetUpdateFrequency->LogReport();
+	})
+);
+
+static const APlayerController* GetOwningPlayerController(const AActor* Actor)
+{
+	for (const AActor* It = Actor; It; It = It->GetOwner())
+	{
+		if (const APlayerController* PC = Cast<APlayerController>(It))
+		{
+			return PC;
+		}
+	}
+
+	return nullptr;
+}
+
+UGSNetUpdateFrequencySubsystem::UGSNetUpdateFrequencySubsystem()
+{
+	UpdateInterval = 0.25f;
+	ChangeRateForCeiling = 10.0f;
+	NearViewerDistance = 2000.0f;
+	FarViewerDistance = 10000.0f;
+	FarViewerScale = 0.25f;
+	CombatDuration = 3.0f;
+	TimeSinceUpdate = 0.0f;
+}
+
+bool UGSNetUpdateFrequencySubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+void UGSNetUpdateFrequencySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	if (Limits.Num() == 0)
+	{
+		// Ceilings match the NetUpdateFrequency these classes used to hard code
+		Limits.Add(FGSNetUpdateFrequencyLimits(AGSPlayerState::StaticClass(), 10.0f, 100.0f));
+		Limits.Add(FGSNetUpdateFrequencyLimits(AGSWeapon::StaticClass(), 2.0f, 100.0f));
+
+		// Clients extrapolate a straight flying projectile from its velocity, 20 Hz keeps the corrections small at
+		// rocket speed. Anyone nearby or a change of course puts it back at the ceiling.
+		Limits.Add(FGSNetUpdateFrequencyLimits(AGSProjectile::StaticClass(), 20.0f, 100.0f));
+	}
+
+	UpdateInterval = FMath::Max(0.0f, UpdateInterval);
+	FarViewerDistance = FMath::Max(NearViewerDistance + 1.0f, FarViewerDistance);
+	WeaponIsFiringTag = FGameplayTag::RequestGameplayTag("Weapon.IsFiring");
+}
+
+void UGSNetUpdateFrequencySubsystem::Deinitialize()
+{
+	Actors.Empty();
+	ActorIndexByActor.Empty();
+	LastDamageTimes.Empty();
+
+	SET_DWORD_STAT(STAT_GSNetUpdateFrequency_Actors, 0);
+	SET_DWORD_STAT(STAT_GSNetUpdateFrequency_CeilingUpdates, 0);
+	SET_DWORD_STAT(STAT_GSNetUpdateFrequency_AdaptiveUpdates, 0);
+	SET_DWORD_STAT(STAT_GSNetUpdateFrequency_SavedUpdates, 0);
+
+	Super::Deinitialize();
+}
+
+void UGSNetUpdateFrequencySubsystem::Tick(float DeltaTime)
+{
+	TimeSinceUpdate += DeltaTime;
+	if (TimeSinceUpdate >= UpdateInterval)
+	{
+		UpdateFrequencies(TimeSinceUpdate);
+		TimeSinceUpdate = 0.0f;
+	}
+}
+
+ETickableTickType UGSNetUpdateFrequencySubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+bool UGSNetUpdateFrequencySubsystem::IsTickable() const
+{
+	// Actors only register on the server
+	return Actors.Num() > 0;
+}
+
+TStatId UGSNetUpdateFrequencySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGSNetUpdateFrequencySubsystem, STATGROUP_Tickables);
+}
+
+UWorld* UGSNetUpdateFrequencySubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+void UGSNetUpdateFrequencySubsystem::RegisterActor(AActor* Actor)
+{
+	if (!Actor || ActorIndexByActor.Contains(Actor))
+	{
+		return;
+	}
+
+	const FGSNetUpdateFrequencyLimits* ActorLimits = FindLimits(Actor->GetClass());
+	if (!ActorLimits)
+	{
+		return;
+	}
+
+	FAdaptiveActor& Entry = Actors.AddDefaulted_GetRef();
+	Entry.Actor = Actor;
+	Entry.ActorKey = Actor;
+	Entry.MaxFrequency = ActorLimits->MaxNetUpdateFrequency > 0.0f ? ActorLimits->MaxNetUpdateFrequency : Actor->NetUpdateFrequency;
+	Entry.MinFrequency = FMath::Clamp(ActorLimits->MinNetUpdateFrequency, 0.1f, Entry.MaxFrequency);
+	Entry.CurrentFrequency = Actor->NetUpdateFrequency;
+
+	ActorIndexByActor.Add(Actor, Actors.Num() - 1);
+
+	// Start at the ceiling. The first update lowers it if nothing is going on.
+	ApplyFrequency(Entry, Entry.MaxFrequency);
+}
+
+void UGSNetUpdateFrequencySubsystem::UnregisterActor(AActor* Actor)
+{
+	if (const int32* Index = ActorIndexByActor.Find(Actor))
+	{
+		RemoveActorAt(*Index);
+	}
+}
+
+void UGSNetUpdateFrequencySubsystem::NotifyReplicatedStateChanged(AActor* Actor)
+{
+	if (!Actor || !Actor->HasAuthority())
+	{
+		return;
+	}
+
+	UWorld* World = Actor->GetWorld();
+	UGSNetUpdateFrequencySubsystem* Subsystem = World ? World->GetSubsystem<UGSNetUpdateFrequencySubsystem>() : nullptr;
+	const int32* Index = Subsystem ? Subsystem->ActorIndexByActor.Find(Actor) : nullptr;
+	if (!Index)
+	{
+		return;
+	}
+
+	FAdaptiveActor& Entry = Subsystem->Actors[*Index];
+	if (Entry.ChangesSinceUpdate++ == 0 && Entry.CurrentFrequency < Entry.MaxFrequency)
+	{
+		// Don't make the first change after an idle period wait for the next update at the floor
+		Actor->ForceNetUpdate();
+		INC_DWORD_STAT(STAT_GSNetUpdateFrequency_ForcedUpdates);
+	}
+}
+
+void UGSNetUpdateFrequencySubsystem::NotifyDamaged(UAbilitySystemComponent* AbilitySystemComponent)
+{
+	AActor* Owner = AbilitySystemComponent ? AbilitySystemComponent->GetOwner() : nullptr;
+	if (!Owner || !Owner->HasAuthority())
+	{
+		return;
+	}
+
+	UWorld* World = Owner->GetWorld();
+	if (UGSNetUpdateFrequencySubsystem* Subsystem = World ? World->GetSubsystem<UGSNetUpdateFrequencySubsystem>() : nullptr)
+	{
+		Subsystem->LastDamageTimes.Add(AbilitySystemComponent, World->GetTimeSeconds());
+	}
+}
+
+void UGSNetUpdateFrequencySubsystem::LogReport() const
+{
+	UE_LOG(LogGASShooterALS, Log, TEXT("%s %d adaptive actors, enabled %d"), *FString(__FUNCTION__), Actors.Num(), CVarAdaptiveNetUpdateFrequency.GetValueOnGameThread());
+
+	for (const FAdaptiveActor& Entry : Actors)
+	{
+		UE_LOG(LogGASShooterALS, Log, TEXT("  %s: %.1f Hz (%.1f - %.1f), %.1f changes/s"), *GetNameSafe(Entry.Actor.Get()),
+			Entry.CurrentFrequency, Entry.MinFrequency, Entry.MaxFrequency, Entry.ChangesPerSecond);
+	}
+}
+
+const FGSNetUpdateFrequencyLimits* UGSNetUpdateFrequencySubsystem::FindLimits(const UClass* Class) const
+{
+	// The most derived class with limits wins
+	const FGSNetUpdateFrequencyLimits* Best = nullptr;
+	for (const FGSNetUpdateFrequencyLimits& Entry : Limits)
+	{
+		if (Entry.ActorClass && Class->IsChildOf(Entry.ActorClass) && (!Best || Entry.ActorClass->IsChildOf(Best->ActorClass)))
+		{
+			Best = &Entry;
+		}
+	}
+
+	return Best;
+}
+
+void UGSNetUpdateFrequencySubsystem::UpdateFrequencies(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_GSNetUpdateFrequency_Update);
+
+	UWorld* World = GetWorld();
+	const float Now = World->GetTimeSeconds();
+	const bool bEnabled = CVarAdaptiveNetUpdateFrequency.GetValueOnGameThread() != 0;
+
+	struct FViewer
+	{
+		const APlayerController* PC;
+		FVector Location;
+	};
+
+	TArray<FViewer, TInlineAllocator<64>> Viewers;
+	if (bEnabled)
+	{
+		for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+		{
+			const APlayerController* PC = It->Get();
+			if (PC)
+			{
+				FVector ViewLocation;
+				FRotator ViewRotation;
+				PC->GetPlayerViewPoint(ViewLocation, ViewRotation);
+				Viewers.Add({ PC, ViewLocation });
+			}
+		}
+	}
+
+	for (auto It = LastDamageTimes.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid() || Now - It.Value() > CombatDuration)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	const float NearDistanceSq = FMath::Square(NearViewerDistance);
+	float CeilingUpdates = 0.0f;
+	float AdaptiveUpdates = 0.0f;
+
+	for (int32 Index = Actors.Num() - 1; Index >= 0; Index--)
+	{
+		FAdaptiveActor& Entry = Actors[Index];
+		AActor* Actor = Entry.Actor.Get();
+		if (!Actor)
+		{
+			RemoveActorAt(Index);
+			continue;
+		}
+
+		// Smooth over roughly a second so a single burst doesn't pin the actor at its ceiling
+		const float ChangeRate = Entry.ChangesSinceUpdate / FMath::Max(DeltaTime, KINDA_SMALL_NUMBER);
+		Entry.ChangesPerSecond = FMath::Lerp(Entry.ChangesPerSecond, ChangeRate, FMath::Min(1.0f, DeltaTime));
+		Entry.ChangesSinceUpdate = 0;
+
+		float Alpha = 1.0f;
+		if (bEnabled && !IsInCombat(Actor, Now))
+		{
+			const float ChangeAlpha = FMath::Clamp(FMath::Max(Entry.ChangesPerSecond, ChangeRate) / ChangeRateForCeiling, 0.0f, 1.0f);
+
+			// PlayerStates have no location of their own
+			const APlayerState* PS = Cast<APlayerState>(Actor);
+			const AActor* LocationActor = PS ? PS->GetPawn() : Actor;
+
+			// The owner gets its own updates regardless. What matters is how close everybody else is.
+			float NearestDistanceSq = BIG_NUMBER;
+			if (LocationActor)
+			{
+				const APlayerController* OwningPC = GetOwningPlayerController(Actor);
+				const FVector Location = LocationActor->GetActorLocation();
+				for (const FViewer& Viewer : Viewers)
+				{
+					if (Viewer.PC != OwningPC)
+					{
+						NearestDistanceSq = FMath::Min(NearestDistanceSq, FVector::DistSquared(Location, Viewer.Location));
+					}
+				}
+			}
+
+			float ViewerScale = 1.0f;
+			if (NearestDistanceSq > NearDistanceSq)
+			{
+				const float DistanceAlpha = FMath::Clamp((FMath::Sqrt(NearestDistanceSq) - NearViewerDistance) / (FarViewerDistance - NearViewerDistance), 0.0f, 1.0f);
+				ViewerScale = FMath::Lerp(1.0f, FarViewerScale, DistanceAlpha);
+			}
+
+			Alpha = ChangeAlpha * ViewerScale;
+		}
+
+		ApplyFrequency(Entry, FMath::RoundToFloat(FMath::Lerp(Entry.MinFrequency, Entry.MaxFrequency, Alpha)));
+
+		CeilingUpdates += Entry.MaxFrequency;
+		AdaptiveUpdates += Entry.CurrentFrequency;
+	}
+
+	SET_DWORD_STAT(STAT_GSNetUpdateFrequency_Actors, Actors.Num());
+	SET_DWORD_STAT(STAT_GSNetUpdateFrequency_CeilingUpdates, FMath::RoundToInt(CeilingUpdates));
+	SET_DWORD_STAT(STAT_GSNetUpdateFrequency_AdaptiveUpdates, FMath::RoundToInt(AdaptiveUpdates));
+	SET_DWORD_STAT(STAT_GSNetUpdateFrequency_SavedUpdates, FMath::RoundToInt(CeilingUpdates - AdaptiveUpdates));
+}
+
+void UGSNetUpdateFrequencySubsystem::ApplyFrequency(FAdaptiveActor& Entry, float NewFrequency)
+{
+	NewFrequency = FMath::Clamp(NewFrequency, Entry.MinFrequency, Entry.MaxFrequency);
+
+	AActor* Actor = Entry.Actor.Get();
+	if (!Actor || (NewFrequency == Entry.CurrentFrequency && Actor->NetUpdateFrequency == NewFrequency))
+	{
+		return;
+	}
+
+	Entry.CurrentFrequency = NewFrequency;
+	Actor->NetUpdateFrequency = NewFrequency;
+
+	// The replication graph works from its own per actor copy of the frequency
+	UGSReplicationGraph::NotifyActorNetUpdateFrequencyChanged(Actor);
+}
+
+bool UGSNetUpdateFrequencySubsystem::IsInCombat(const AActor* Actor, float Now) const
+{
+	const UAbilitySystemComponent* ASC = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(Actor);
+	if (!ASC)
+	{
+		// Weapons and projectiles fight on behalf of whoever carries or fired them
+		ASC = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(Actor->GetInstigator());
+	}
+
+	if (!ASC)
+	{
+		return false;
+	}
+
+	if (ASC->HasMatchingGameplayTag(WeaponIsFiringTag))
+	{
+		return true;
+	}
+
+	const float* LastDamageTime = LastDamageTimes.Find(ASC);
+	return LastDamageTime && Now - *LastDamageTime <= CombatDuration;
+}
+
+void UGSNetUpdateFrequencySubsystem::RemoveActorAt(int32 Index)
+{
+	ActorIndexByActor.Remove(Actors[Index].ActorKey);
+
+	Actors.RemoveAtSwap(Index, 1, false);
+	if (Actors.IsValidIndex(Index))
+	{
+		ActorIndexByActor.Add(Actors[Index].ActorKey, Index);
+	}
+}
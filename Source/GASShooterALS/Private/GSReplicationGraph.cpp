@@ -0,0 +1,387 @@
+// Copyright 2020 Dan Kestranek.
+
+
+#include "GSReplicationGraph.h"
+#include "Characters/GSCharacterBase.h"
+#include "Characters/Heroes/GSHeroCharacter.h"
+#include "Engine/LevelScriptActor.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerState.h"
+#include "GASShooterALS/GASShooterALS.h"
+#include "HAL/IConsoleManager.h"
+#include "Items/Pickups/GSPickup.h"
+#include "ReplicationGraphTypes.h"
+#include "UObject/UObjectIterator.h"
+#include "Weapons/GSProjectile.h"
+#include "Weapons/GSWeapon.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Equipped Weapons"), STAT_GSReplicationGraph_EquippedWeapons, STATGROUP_GSReplicationGraph);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Owner Only Weapons"), STAT_GSReplicationGraph_OwnerOnlyWeapons, STATGROUP_GSReplicationGraph);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Dropped Weapons"), STAT_GSReplicationGraph_DroppedWeapons, STATGROUP_GSReplicationGraph);
+
+static TAutoConsoleVariable<float> CVarRepGraphCellSize(
+	TEXT("GS.RepGraph.CellSize"),
+	10000.0f,
+	TEXT("Size (cm) of a cell of the replication graph's spatial grid. Read when the graph is created.")
+);
+
+static TAutoConsoleVariable<float> CVarRepGraphSpatialBias(
+	TEXT("GS.RepGraph.SpatialBias"),
+	-150000.0f,
+	TEXT("X and Y (cm) where the replication graph's spatial grid starts. Maps should fit between this and the grid growing from it. Read when the graph is created.")
+);
+
+static TAutoConsoleVariable<float> CVarRepGraphCharacterCullDistance(
+	TEXT("GS.RepGraph.CharacterCullDistance"),
+	150000.0f,
+	TEXT("Distance (cm) up to which characters replicate to a viewer. Overrides the actors' NetCullDistanceSquared. Read when the graph is created.")
+);
+
+static FAutoConsoleCommandWithWorldAndArgs CmdRepGraphPrintWeaponRoutes(
+	TEXT("GS.RepGraph.PrintWeaponRoutes"),
+	TEXT("Logs where the server's replication graph routes every weapon"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+		UGSReplicationGraph* Graph = NetDriver ? Cast<UGSReplicationGraph>(NetDriver->GetReplicationDriver()) : nullptr;
+		if (!Graph)
+		{
+			UE_LOG(LogGASShooterALS, Warning, TEXT("GS.RepGraph.PrintWeaponRoutes: this world's net driver isn't using UGSReplicationGraph"));
+			return;
+		}
+
+		Graph->LogWeaponRoutes();
+	})
+);
+
+void UGSReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	auto SetRule = [this](UClass* Class, EGSClassRepNodeMapping Mapping)
+	{
+		ClassRepNodePolicies.Set(Class, Mapping);
+	};
+
+	SetRule(AReplicationGraphDebugActor::StaticClass(), EGSClassRepNodeMapping::NotRouted);
+	SetRule(ALevelScriptActor::StaticClass(), EGSClassRepNodeMapping::NotRouted);
+
+	// Gathered by the PlayerState frequency limiter node
+	SetRule(APlayerState::StaticClass(), EGSClassRepNodeMapping::NotRouted);
+
+	// Routed by hand depending on who holds them, see RouteWeapon()
+	SetRule(AGSWeapon::StaticClass(), EGSClassRepNodeMapping::NotRouted);
+
+	// Characters are bAlwaysRelevant for when the graph isn't used. The graph culls them by distance instead, see
+	// InitClassReplicationInfo().
+	SetRule(AGSCharacterBase::StaticClass(), EGSClassRepNodeMapping::Spatialize_Dynamic);
+	SetRule(AGSProjectile::StaticClass(), EGSClassRepNodeMapping::Spatialize_Dynamic);
+	SetRule(AGSPickup::StaticClass(), EGSClassRepNodeMapping::Spatialize_Dormancy);
+
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		UClass* Class = *It;
+		const AActor* ActorCDO = Cast<AActor>(Class->GetDefaultObject(false));
+		if (!ActorCDO || !ActorCDO->GetIsReplicated())
+		{
+			continue;
+		}
+
+		// Blueprint compilation leftovers
+		if (Class->GetName().StartsWith(TEXT("SKEL_")) || Class->GetName().StartsWith(TEXT("REINST_")))
+		{
+			continue;
+		}
+
+		// Weapons get spatialized when they're dropped
+		const bool bSpatialize = IsSpatialized(GetMappingPolicy(Class)) || Class->IsChildOf(AGSWeapon::StaticClass());
+
+		FClassReplicationInfo ClassInfo;
+		InitClassReplicationInfo(ClassInfo, Class, bSpatialize);
+		GlobalActorReplicationInfoMap.SetClassInfo(Class, ClassInfo);
+	}
+}
+
+void UGSReplicationGraph::InitGlobalGraphNodes()
+{
+	// Preallocate some replication lists
+	PreAllocateRepList(3, 12);
+	PreAllocateRepList(6, 12);
+	PreAllocateRepList(128, 64);
+	PreAllocateRepList(512, 16);
+
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = CVarRepGraphCellSize.GetValueOnGameThread();
+	GridNode->SpatialBias = FVector2D(CVarRepGraphSpatialBias.GetValueOnGameThread(), CVarRepGraphSpatialBias.GetValueOnGameThread());
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+
+	UReplicationGraphNode_PlayerStateFrequencyLimiter* PlayerStateNode = CreateNewNode<UReplicationGraphNode_PlayerStateFrequencyLimiter>();
+	AddGlobalGraphNode(PlayerStateNode);
+}
+
+void UGSReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
+{
+	Super::InitConnectionGraphNodes(RepGraphConnection);
+
+	// Replicates the connection's PlayerController, its view targets and the inventory weapons it owns
+	UReplicationGraphNode_AlwaysRelevant_ForConnection* AlwaysRelevantConnectionNode = CreateNewNode<UReplicationGraphNode_AlwaysRelevant_ForConnection>();
+	AddConnectionGraphNode(AlwaysRelevantConnectionNode, RepGraphConnection);
+}
+
+void UGSReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	if (AGSWeapon* Weapon = Cast<AGSWeapon>(ActorInfo.Actor))
+	{
+		WeaponRoutes.Add(Weapon);
+		RouteWeapon(Weapon);
+		return;
+	}
+
+	switch (GetMappingPolicy(ActorInfo.Class))
+	{
+	case EGSClassRepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+		break;
+	case EGSClassRepNodeMapping::Spatialize_Static:
+		GridNode->AddActor_Static(ActorInfo, GlobalInfo);
+		break;
+	case EGSClassRepNodeMapping::Spatialize_Dynamic:
+		GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+		break;
+	case EGSClassRepNodeMapping::Spatialize_Dormancy:
+		GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+		break;
+	default:
+		break;
+	}
+}
+
+void UGSReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	if (AGSWeapon* Weapon = Cast<AGSWeapon>(ActorInfo.Actor))
+	{
+		FGSWeaponRoute Route;
+		if (WeaponRoutes.RemoveAndCopyValue(Weapon, Route))
+		{
+			ApplyWeaponRoute(Weapon, Route, false);
+		}
+		return;
+	}
+
+	switch (GetMappingPolicy(ActorInfo.Class))
+	{
+	case EGSClassRepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+		break;
+	case EGSClassRepNodeMapping::Spatialize_Static:
+		GridNode->RemoveActor_Static(ActorInfo);
+		break;
+	case EGSClassRepNodeMapping::Spatialize_Dynamic:
+		GridNode->RemoveActor_Dynamic(ActorInfo);
+		break;
+	case EGSClassRepNodeMapping::Spatialize_Dormancy:
+		GridNode->RemoveActor_Dormancy(ActorInfo);
+		break;
+	default:
+		break;
+	}
+}
+
+void UGSReplicationGraph::NotifyWeaponRoutingChanged(AGSWeapon* Weapon)
+{
+	UNetDriver* NetDriver = Weapon && Weapon->HasAuthority() ? Weapon->GetNetDriver() : nullptr;
+	UGSReplicationGraph* Graph = NetDriver ? Cast<UGSReplicationGraph>(NetDriver->GetReplicationDriver()) : nullptr;
+
+	// Weapons the graph doesn't know about yet are routed when they're added
+	if (Graph && Graph->WeaponRoutes.Contains(Weapon))
+	{
+		Graph->RouteWeapon(Weapon);
+	}
+}
+
+void UGSReplicationGraph::NotifyActorNetUpdateFrequencyChanged(AActor* Actor)
+{
+	UNetDriver* NetDriver = Actor && Actor->HasAuthority() ? Actor->GetNetDriver() : nullptr;
+	UGSReplicationGraph* Graph = NetDriver ? Cast<UGSReplicationGraph>(NetDriver->GetReplicationDriver()) : nullptr;
+
+	if (FGlobalActorReplicationInfo* GlobalInfo = Graph ? Graph->GlobalActorReplicationInfoMap.Find(Actor) : nullptr)
+	{
+		GlobalInfo->Settings.ReplicationPeriodFrame = Graph->GetReplicationPeriodFrameForFrequency(Actor->NetUpdateFrequency);
+	}
+}
+
+void UGSReplicationGraph::LogWeaponRoutes() const
+{
+	for (const TPair<TWeakObjectPtr<AGSWeapon>, FGSWeaponRoute>& Pair : WeaponRoutes)
+	{
+		const AGSWeapon* Weapon = Pair.Key.Get();
+		const FGSWeaponRoute& Route = Pair.Value;
+
+		FString RouteString = TEXT("not replicated");
+		if (Route.DependsOn.IsValid())
+		{
+			RouteString = FString::Printf(TEXT("equipped by %s"), *Route.DependsOn->GetName());
+		}
+		else if (Route.OwnerNode.IsValid())
+		{
+			RouteString = FString::Printf(TEXT("owner only for %s"), Weapon && Weapon->OwningCharacter ? *Weapon->OwningCharacter->GetName() : TEXT("?"));
+		}
+		else if (Route.bSpatialized)
+		{
+			RouteString = TEXT("spatialized");
+		}
+
+		UE_LOG(LogGASShooterALS, Log, TEXT("GS.RepGraph.PrintWeaponRoutes: %s %s"), Weapon ? *Weapon->GetName() : TEXT("(destroyed)"), *RouteString);
+	}
+}
+
+EGSClassRepNodeMapping UGSReplicationGraph::GetMappingPolicy(UClass* Class)
+{
+	if (const EGSClassRepNodeMapping* Mapping = ClassRepNodePolicies.Get(Class))
+	{
+		return *Mapping;
+	}
+
+	// No rule for this class or its parents, go by how the engine would treat it
+	EGSClassRepNodeMapping Mapping = EGSClassRepNodeMapping::NotRouted;
+
+	const AActor* ActorCDO = Cast<AActor>(Class->GetDefaultObject());
+	if (!ActorCDO || !ActorCDO->GetIsReplicated() || ActorCDO->bOnlyRelevantToOwner)
+	{
+		Mapping = EGSClassRepNodeMapping::NotRouted;
+	}
+	else if (ActorCDO->bAlwaysRelevant)
+	{
+		Mapping = EGSClassRepNodeMapping::RelevantAllConnections;
+	}
+	else if (ActorCDO->IsReplicatingMovement() || ActorCDO->bNetUseOwnerRelevancy)
+	{
+		Mapping = EGSClassRepNodeMapping::Spatialize_Dynamic;
+	}
+	else
+	{
+		Mapping = EGSClassRepNodeMapping::Spatialize_Static;
+	}
+
+	ClassRepNodePolicies.Set(Class, Mapping);
+	return Mapping;
+}
+
+void UGSReplicationGraph::InitClassReplicationInfo(FClassReplicationInfo& Info, UClass* Class, bool bSpatialize) const
+{
+	const AActor* ActorCDO = Class->GetDefaultObject<AActor>();
+	if (bSpatialize && Class->IsChildOf(AGSCharacterBase::StaticClass()))
+	{
+		// Characters used to be always relevant and hitscan weapons have no practical range, so the default
+		// NetCullDistanceSquared (150 m) would hide heroes players can still see and shoot. The default distance matches
+		// the area GS.RepGraph.SpatialBias lays the grid out for.
+		Info.SetCullDistanceSquared(FMath::Square(CVarRepGraphCharacterCullDistance.GetValueOnGameThread()));
+	}
+	else if (bSpatialize)
+	{
+		Info.SetCullDistanceSquared(ActorCDO->NetCullDistanceSquared);
+	}
+
+	Info.ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(ActorCDO->NetUpdateFrequency);
+}
+
+UReplicationGraphNode_AlwaysRelevant_ForConnection* UGSReplicationGraph::GetAlwaysRelevantNodeForConnection(UNetConnection* Connection)
+{
+	UNetReplicationGraphConnection* ConnectionManager = Connection ? FindOrAddConnectionManager(Connection) : nullptr;
+	if (!ConnectionManager)
+	{
+		return nullptr;
+	}
+
+	for (UReplicationGraphNode* Node : ConnectionManager->GetConnectionGraphNodes())
+	{
+		if (UReplicationGraphNode_AlwaysRelevant_ForConnection* AlwaysRelevantConnectionNode = Cast<UReplicationGraphNode_AlwaysRelevant_ForConnection>(Node))
+		{
+			return AlwaysRelevantConnectionNode;
+		}
+	}
+
+	return nullptr;
+}
+
+void UGSReplicationGraph::RouteWeapon(AGSWeapon* Weapon)
+{
+	FGSWeaponRoute NewRoute;
+
+	AGSHeroCharacter* Hero = Weapon->OwningCharacter;
+	if (!Hero)
+	{
+		NewRoute.bSpatialized = true;
+	}
+	else if (Hero->GetCurrentWeapon() == Weapon)
+	{
+		NewRoute.DependsOn = Hero;
+	}
+	else
+	{
+		// AI and the listen server's own hero have no connection. Nobody else needs their holstered weapons.
+		NewRoute.OwnerNode = GetAlwaysRelevantNodeForConnection(Hero->GetNetConnection());
+	}
+
+	FGSWeaponRoute& Route = WeaponRoutes.FindOrAdd(Weapon);
+	if (Route == NewRoute)
+	{
+		return;
+	}
+
+	ApplyWeaponRoute(Weapon, Route, false);
+	ApplyWeaponRoute(Weapon, NewRoute, true);
+	Route = NewRoute;
+}
+
+void UGSReplicationGraph::ApplyWeaponRoute(AGSWeapon* Weapon, const FGSWeaponRoute& Route, bool bAdd)
+{
+	const FNewReplicatedActorInfo ActorInfo(Weapon);
+
+	if (AGSHeroCharacter* Hero = Route.DependsOn.Get())
+	{
+		if (bAdd)
+		{
+			GlobalActorReplicationInfoMap.AddDependentActor(Hero, Weapon);
+			INC_DWORD_STAT(STAT_GSReplicationGraph_EquippedWeapons);
+		}
+		else
+		{
+			GlobalActorReplicationInfoMap.RemoveDependentActor(Hero, Weapon);
+			DEC_DWORD_STAT(STAT_GSReplicationGraph_EquippedWeapons);
+		}
+	}
+
+	if (UReplicationGraphNode_AlwaysRelevant_ForConnection* OwnerNode = Route.OwnerNode.Get())
+	{
+		if (bAdd)
+		{
+			OwnerNode->NotifyAddNetworkActor(ActorInfo);
+			INC_DWORD_STAT(STAT_GSReplicationGraph_OwnerOnlyWeapons);
+		}
+		else
+		{
+			OwnerNode->NotifyRemoveNetworkActor(ActorInfo, false);
+			DEC_DWORD_STAT(STAT_GSReplicationGraph_OwnerOnlyWeapons);
+		}
+	}
+
+	if (Route.bSpatialized)
+	{
+		if (bAdd)
+		{
+			GridNode->AddActor_Dormancy(ActorInfo, GlobalActorReplicationInfoMap.Get(Weapon));
+			INC_DWORD_STAT(STAT_GSReplicationGraph_DroppedWeapons);
+		}
+		else
+		{
+			GridNode->RemoveActor_Dormancy(ActorInfo);
+			DEC_DWORD_STAT(STAT_GSReplicationGraph_DroppedWeapons);
+		}
+	}
+}
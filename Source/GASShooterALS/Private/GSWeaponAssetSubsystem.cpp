@@ -0,0 +1,334 @@
+// Copyright 2020 Dan Kestranek.
+
+
+#include "GSWeaponAssetSubsystem.h"
+#include "Engine/AssetManager.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "GASShooterALS/GASShooterALS.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "UObject/UObjectIterator.h"
+#include "Weapons/GSWeapon.h"
+
+DECLARE_STATS_GROUP(TEXT("GSWeaponAssets"), STATGROUP_GSWeaponAssets, STATCAT_Advanced);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Weapon Preloads"), STAT_GSWeaponAssets_Preloads, STATGROUP_GSWeaponAssets);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Loads On First Use"), STAT_GSWeaponAssets_LoadsOnFirstUse, STATGROUP_GSWeaponAssets);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Skipped On First Use"), STAT_GSWeaponAssets_SkippedOnFirstUse, STATGROUP_GSWeaponAssets);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pickups Watched"), STAT_GSWeaponAssets_PickupsWatched, STATGROUP_GSWeaponAssets);
+
+static TAutoConsoleVariable<int32> CVarPreloadWeaponAssets(
+	TEXT("GS.WeaponAssets.Preload"),
+	1,
+	TEXT("Async load a weapon's icons, montages and sounds when a local player nears its pickup or someone equips it. 0 loads them on first use.")
+);
+
+static FAutoConsoleCommandWithWorldAndArgs CmdWeaponAssetsReport(
+	TEXT("GS.WeaponAssets.Report"),
+	TEXT("Logs which cosmetic assets of every loaded weapon class are in memory, their size and why they were loaded"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		UGSWeaponAssetSubsystem* WeaponAssets = World ? World->GetSubsystem<UGSWeaponAssetSubsystem>() : nullptr;
+		if (!WeaponAssets)
+		{
+			UE_LOG(LogGASShooterALS, Warning, TEXT("GS.WeaponAssets.Report: no weapon asset subsystem in this world"));
+			return;
+		}
+
+		WeaponAssets->LogReport();
+	})
+);
+
+UGSWeaponAssetSubsystem::UGSWeaponAssetSubsystem()
+{
+	PreloadDistance = 3000.0f;
+	UpdateInterval = 0.5f;
+	TimeSinceUpdate = 0.0f;
+}
+
+bool UGSWeaponAssetSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// Created on dedicated servers too so the report can show that nothing was loaded there
+	UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+void UGSWeaponAssetSubsystem::Deinitialize()
+{
+	for (TPair<const UClass*, FWeaponPreload>& Pair : Preloads)
+	{
+		if (Pair.Value.Handle.IsValid())
+		{
+			Pair.Value.Handle->ReleaseHandle();
+		}
+	}
+
+	Preloads.Empty();
+	Pickups.Empty();
+	SET_DWORD_STAT(STAT_GSWeaponAssets_PickupsWatched, 0);
+
+	Super::Deinitialize();
+}
+
+void UGSWeaponAssetSubsystem::Tick(float DeltaTime)
+{
+	TimeSinceUpdate += DeltaTime;
+	if (TimeSinceUpdate >= UpdateInterval)
+	{
+		UpdatePickups();
+		TimeSinceUpdate = 0.0f;
+	}
+}
+
+ETickableTickType UGSWeaponAssetSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+bool UGSWeaponAssetSubsystem::IsTickable() const
+{
+	// Pickups only register where something is drawn
+	return Pickups.Num() > 0 && CVarPreloadWeaponAssets.GetValueOnGameThread() != 0;
+}
+
+TStatId UGSWeaponAssetSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGSWeaponAssetSubsystem, STATGROUP_Tickables);
+}
+
+UWorld* UGSWeaponAssetSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+void UGSWeaponAssetSubsystem::PreloadWeaponAssets(const AGSWeapon* Weapon, const TCHAR* Reason)
+{
+	if (!Weapon || IsRunningDedicatedServer() || CVarPreloadWeaponAssets.GetValueOnGameThread() == 0)
+	{
+		return;
+	}
+
+	UWorld* World = Weapon->GetWorld();
+	if (UGSWeaponAssetSubsystem* WeaponAssets = World ? World->GetSubsystem<UGSWeaponAssetSubsystem>() : nullptr)
+	{
+		WeaponAssets->RequestPreload(Weapon, Reason);
+	}
+}
+
+UObject* UGSWeaponAssetSubsystem::LoadCosmeticAsset(const AGSWeapon* Weapon, const FSoftObjectPath& Path)
+{
+	if (Path.IsNull() || IsRunningDedicatedServer())
+	{
+		return nullptr;
+	}
+
+	if (UObject* Asset = Path.ResolveObject())
+	{
+		return Asset;
+	}
+
+	// This is the hitch preloading is meant to prevent. Time it so a missing preload shows up.
+	const double StartTime = FPlatformTime::Seconds();
+	UObject* Asset = Path.TryLoad();
+	INC_DWORD_STAT(STAT_GSWeaponAssets_LoadsOnFirstUse);
+	UE_LOG(LogGASShooterALS, Log, TEXT("%s %s wasn't preloaded. Loading it took %.2f ms."), *FString(__FUNCTION__), *Path.ToString(),
+		(FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+	// Keep it and the rest of the weapon's assets loaded from now on, even with preloading turned off
+	UWorld* World = Weapon ? Weapon->GetWorld() : nullptr;
+	if (UGSWeaponAssetSubsystem* WeaponAssets = World ? World->GetSubsystem<UGSWeaponAssetSubsystem>() : nullptr)
+	{
+		WeaponAssets->RequestPreload(Weapon, TEXT("first use"));
+	}
+
+	return Asset;
+}
+
+UObject* UGSWeaponAssetSubsystem::FindResidentCosmeticAsset(const AGSWeapon* Weapon, const FSoftObjectPath& Path)
+{
+	if (Path.IsNull() || IsRunningDedicatedServer())
+	{
+		return nullptr;
+	}
+
+	if (UObject* Asset = Path.ResolveObject())
+	{
+		return Asset;
+	}
+
+	INC_DWORD_STAT(STAT_GSWeaponAssets_SkippedOnFirstUse);
+	UE_LOG(LogGASShooterALS, Log, TEXT("%s %s wasn't preloaded. Skipping it this time."), *FString(__FUNCTION__), *Path.ToString());
+
+	UWorld* World = Weapon ? Weapon->GetWorld() : nullptr;
+	if (UGSWeaponAssetSubsystem* WeaponAssets = World ? World->GetSubsystem<UGSWeaponAssetSubsystem>() : nullptr)
+	{
+		WeaponAssets->RequestPreload(Weapon, TEXT("first use"));
+	}
+
+	return nullptr;
+}
+
+void UGSWeaponAssetSubsystem::RegisterWeapon(AGSWeapon* Weapon)
+{
+	if (Weapon && !IsRunningDedicatedServer() && !Preloads.Contains(Weapon->GetClass()))
+	{
+		Pickups.AddUnique(Weapon);
+		SET_DWORD_STAT(STAT_GSWeaponAssets_PickupsWatched, Pickups.Num());
+	}
+}
+
+void UGSWeaponAssetSubsystem::UnregisterWeapon(AGSWeapon* Weapon)
+{
+	if (Pickups.RemoveSwap(Weapon) > 0)
+	{
+		SET_DWORD_STAT(STAT_GSWeaponAssets_PickupsWatched, Pickups.Num());
+	}
+}
+
+void UGSWeaponAssetSubsystem::RequestPreload(const AGSWeapon* Weapon, const TCHAR* Reason)
+{
+	const UClass* WeaponClass = Weapon->GetClass();
+	if (Preloads.Contains(WeaponClass))
+	{
+		return;
+	}
+
+	TArray<FSoftObjectPath> Paths;
+	Weapon->GetCosmeticAssetPaths(Paths);
+
+	FWeaponPreload& Preload = Preloads.Add(WeaponClass);
+	Preload.Reason = Reason;
+	Preload.StartTime = FPlatformTime::Seconds();
+
+	if (Paths.Num() == 0)
+	{
+		Preload.LoadSeconds = 0.0;
+		return;
+	}
+
+	INC_DWORD_STAT(STAT_GSWeaponAssets_Preloads);
+
+	// Loaded assets are requested too so the handle keeps them from being garbage collected
+	TSharedPtr<FStreamableHandle> Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(Paths,
+		FStreamableDelegate::CreateUObject(this, &UGSWeaponAssetSubsystem::OnPreloadComplete, WeaponClass));
+
+	// The map may have grown if the request completed right away
+	if (FWeaponPreload* AddedPreload = Preloads.Find(WeaponClass))
+	{
+		AddedPreload->Handle = Handle;
+	}
+}
+
+void UGSWeaponAssetSubsystem::OnPreloadComplete(const UClass* WeaponClass)
+{
+	if (FWeaponPreload* Preload = Preloads.Find(WeaponClass))
+	{
+		Preload->LoadSeconds = FPlatformTime::Seconds() - Preload->StartTime;
+		UE_LOG(LogGASShooterALS, Log, TEXT("%s Preloaded %s for %s in %.2f ms"), *FString(__FUNCTION__), *GetNameSafe(WeaponClass), *Preload->Reason,
+			Preload->LoadSeconds * 1000.0);
+	}
+}
+
+void UGSWeaponAssetSubsystem::UpdatePickups()
+{
+	TArray<FVector, TInlineAllocator<4>> ViewLocations;
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PC = It->Get();
+		if (PC && PC->IsLocalController())
+		{
+			FVector Location;
+			FRotator Rotation;
+			PC->GetPlayerViewPoint(Location, Rotation);
+			ViewLocations.Add(Location);
+		}
+	}
+
+	const float PreloadDistanceSquared = FMath::Square(PreloadDistance);
+
+	for (int32 Index = Pickups.Num() - 1; Index >= 0; Index--)
+	{
+		AGSWeapon* Weapon = Pickups[Index].Get();
+		if (!Weapon || Preloads.Contains(Weapon->GetClass()))
+		{
+			Pickups.RemoveAtSwap(Index);
+			continue;
+		}
+
+		// Held and pooled weapons aren't lying around to be picked up
+		if (Weapon->GetOwner() || Weapon->IsHidden())
+		{
+			continue;
+		}
+
+		for (const FVector& ViewLocation : ViewLocations)
+		{
+			if (FVector::DistSquared(ViewLocation, Weapon->GetActorLocation()) <= PreloadDistanceSquared)
+			{
+				RequestPreload(Weapon, TEXT("pickup nearby"));
+				Pickups.RemoveAtSwap(Index);
+				break;
+			}
+		}
+	}
+
+	SET_DWORD_STAT(STAT_GSWeaponAssets_PickupsWatched, Pickups.Num());
+}
+
+void UGSWeaponAssetSubsystem::LogReport() const
+{
+	const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+	UE_LOG(LogGASShooterALS, Log, TEXT("%s Dedicated server %d, preloading %d, process using %.1f MB"), *FString(__FUNCTION__), IsRunningDedicatedServer(),
+		CVarPreloadWeaponAssets.GetValueOnGameThread(), MemoryStats.UsedPhysical / (1024.0 * 1024.0));
+
+	int32 TotalLoaded = 0;
+	int64 TotalBytes = 0;
+
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		const UClass* Class = *It;
+		if (!Class->IsChildOf(AGSWeapon::StaticClass()) || Class->HasAnyClassFlags(CLASS_Abstract | CLASS_NewerVersionExists)
+			|| Class->GetName().StartsWith(TEXT("SKEL_")) || Class->GetName().StartsWith(TEXT("REINST_")))
+		{
+			continue;
+		}
+
+		TArray<FSoftObjectPath> Paths;
+		Class->GetDefaultObject<AGSWeapon>()->GetCosmeticAssetPaths(Paths);
+		if (Paths.Num() == 0)
+		{
+			continue;
+		}
+
+		// Only the assets themselves. Textures and sound waves shared with other assets aren't counted.
+		int32 NumLoaded = 0;
+		int64 Bytes = 0;
+		for (const FSoftObjectPath& Path : Paths)
+		{
+			if (UObject* Asset = Path.ResolveObject())
+			{
+				NumLoaded++;
+				Bytes += Asset->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+			}
+		}
+
+		TotalLoaded += NumLoaded;
+		TotalBytes += Bytes;
+
+		FString PreloadText = TEXT("not preloaded");
+		if (const FWeaponPreload* Preload = Preloads.Find(Class))
+		{
+			PreloadText = Preload->LoadSeconds >= 0.0 ? FString::Printf(TEXT("preloaded for %s in %.2f ms"), *Preload->Reason, Preload->LoadSeconds * 1000.0)
+				: FString::Printf(TEXT("preloading for %s"), *Preload->Reason);
+		}
+
+		UE_LOG(LogGASShooterALS, Log, TEXT("  %s: %d/%d cosmetic assets loaded, %.1f KB, %s"), *Class->GetName(), NumLoaded, Paths.Num(), Bytes / 1024.0, *PreloadText);
+	}
+
+	UE_LOG(LogGASShooterALS, Log, TEXT("%s %d weapon cosmetic assets loaded, %.1f KB in total"), *FString(__FUNCTION__), TotalLoaded, TotalBytes / 1024.0);
+
+	if (IsRunningDedicatedServer() && TotalLoaded > 0)
+	{
+		UE_LOG(LogGASShooterALS, Warning, TEXT("%s Dedicated servers shouldn't load weapon cosmetic assets. Something still holds a hard reference to them."), *FString(__FUNCTION__));
+	}
+}
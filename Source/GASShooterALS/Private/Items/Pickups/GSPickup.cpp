@@ -13,11 +13,18 @@
 #include "Sound/SoundCue.h"
 #include "TimerManager.h"
 
+static TAutoConsoleVariable<int32> CVarPickupDormancy(
+	TEXT("GS.Pickup.Dormancy"),
+	1,
+	TEXT("Whether pickups stay net dormant between being picked up and respawning. Read when a pickup begins play.")
+);
+
 // Sets default values
 AGSPickup::AGSPickup()
 {
 	PrimaryActorTick.bCanEverTick = false;
 	bReplicates = true;
+	NetDormancy = DORM_Initial;
 	bIsActive = true;
 	bCanRespawn = true;
 	RespawnTime = 5.0f;
@@ -34,6 +41,24 @@ AGSPickup::AGSPickup()
 	RestrictedPickupTags.AddTag(FGameplayTag::RequestGameplayTag("State.KnockedDown"));
 }
 
+void AGSPickup::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (HasAuthority())
+	{
+		if (CVarPickupDormancy.GetValueOnGameThread() == 0)
+		{
+			SetNetDormancy(DORM_Awake);
+		}
+		else if (!IsNetStartupActor())
+		{
+			// DORM_Initial only skips replication for pickups placed in the map. Spawned ones replicate once and then go dormant.
+			SetNetDormancy(DORM_DormantAll);
+		}
+	}
+}
+
 void AGSPickup::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
@@ -77,6 +102,7 @@ void AGSPickup::PickupOnTouch(AGSCharacterBase* Pawn)
 		GivePickupTo(Pawn);
 		PickedUpBy = Pawn;
 		bIsActive = false;
+		FlushNetDormancy();
 		OnPickedUp();
 
 		if (bCanRespawn && RespawnTime > 0.0f)
@@ -144,6 +170,7 @@ void AGSPickup::RespawnPickup()
 {
 	bIsActive = true;
 	PickedUpBy = NULL;
+	FlushNetDormancy();
 	OnRespawned();
 
 	TSet<AActor*> OverlappingPawns;
@@ -71,7 +71,7 @@ void AGSPlayerController::CreateHUD()
 		AGSWeapon* CurrentWeapon = Hero->GetCurrentWeapon();
 		if (CurrentWeapon)
 		{
-			UIHUDWidget->SetEquippedWeaponSprite(CurrentWeapon->PrimaryIcon);
+			UIHUDWidget->SetEquippedWeaponSprite(CurrentWeapon->GetPrimaryIcon());
 			UIHUDWidget->SetEquippedWeaponStatusText(CurrentWeapon->GetDefaultStatusText());
 			UIHUDWidget->SetPrimaryClipAmmo(Hero->GetPrimaryClipAmmo());
 			UIHUDWidget->SetReticle(CurrentWeapon->GetPrimaryHUDReticleClass());
@@ -7,6 +7,7 @@
 #include "Characters/Abilities/GSAbilitySystemComponent.h"
 #include "Characters/Abilities/GSAbilitySystemGlobals.h"
 #include "Characters/Heroes/GSHeroCharacter.h"
+#include "GSNetUpdateFrequencySubsystem.h"
 #include "Player/GSPlayerController.h"
 #include "UI/GSFloatingStatusBarWidget.h"
 #include "UI/GSHUDWidget.h"
@@ -31,7 +32,7 @@ AGSPlayerState::AGSPlayerState()
 
 	// Set PlayerState's NetUpdateFrequency to the same as the Character.
 	// Default is very low for PlayerStates and introduces perceived lag in the ability system.
-	// 100 is probably way too high for a shipping game, you can adjust to fit your needs.
+	// This is the ceiling. UGSNetUpdateFrequencySubsystem lowers it while nothing is going on.
 	NetUpdateFrequency = 100.0f;
 
 	DeadTag = FGameplayTag::RequestGameplayTag("State.Dead");
@@ -255,11 +256,37 @@ void AGSPlayerState::BeginPlay()
 
 		// Tag change callbacks
 		AbilitySystemComponent->RegisterGameplayTagEvent(KnockedDownTag, EGameplayTagEventType::NewOrRemoved).AddUObject(this, &AGSPlayerState::KnockDownTagChanged);
+
+		// Server only
+		AbilitySystemComponent->OnGameplayEffectAppliedDelegateToSelf.AddUObject(this, &AGSPlayerState::GameplayEffectAppliedToSelf);
+	}
+
+	if (HasAuthority())
+	{
+		if (UGSNetUpdateFrequencySubsystem* NetUpdateFrequency = GetWorld()->GetSubsystem<UGSNetUpdateFrequencySubsystem>())
+		{
+			NetUpdateFrequency->RegisterActor(this);
+		}
+	}
+}
+
+void AGSPlayerState::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UGSNetUpdateFrequencySubsystem* NetUpdateFrequency = GetWorld()->GetSubsystem<UGSNetUpdateFrequencySubsystem>())
+	{
+		NetUpdateFrequency->UnregisterActor(this);
 	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void AGSPlayerState::HealthChanged(const FOnAttributeChangeData& Data)
 {
+	if (Data.NewValue < Data.OldValue)
+	{
+		UGSNetUpdateFrequencySubsystem::NotifyDamaged(AbilitySystemComponent);
+	}
+
 	// Check for and handle knockdown and death
 	AGSHeroCharacter* Hero = Cast<AGSHeroCharacter>(GetPawn());
 	if (!IsValid(Hero))
@@ -280,6 +307,12 @@ void AGSPlayerState::HealthChanged(const FOnAttributeChangeData& Data)
 	}
 }
 
+void AGSPlayerState::GameplayEffectAppliedToSelf(UAbilitySystemComponent* Source, const FGameplayEffectSpec& SpecApplied, FActiveGameplayEffectHandle ActiveHandle)
+{
+	// Attributes, tags and active effects all replicate through us
+	UGSNetUpdateFrequencySubsystem::NotifyReplicatedStateChanged(this);
+}
+
 void AGSPlayerState::KnockDownTagChanged(const FGameplayTag CallbackTag, int32 NewCount)
 {
 	AGSHeroCharacter* Hero = Cast<AGSHeroCharacter>(GetPawn());
@@ -0,0 +1,129 @@
+// Copyright 2020 Dan Kestranek.
+
+
+#include "Characters/Abilities/GSAbilitySystemComponent.h"
+#include "Characters/Abilities/GSGameplayAbility.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGSAbilitySpecIndexTest, "GASShooterALS.Abilities.SpecIndex",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+/**
+* Gives and removes abilities inside and outside of an ability list lock and checks the ASC's input ID and class
+* indexes against a scan of ActivatableAbilities after each step.
+*/
+bool FGSAbilitySpecIndexTest::RunTest(const FString& Parameters)
+{
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	AActor* Owner = World->SpawnActor<AActor>();
+	UGSAbilitySystemComponent* ASC = NewObject<UGSAbilitySystemComponent>(Owner);
+	ASC->RegisterComponent();
+	ASC->InitAbilityActorInfo(Owner, Owner);
+
+	const TArray<FGameplayAbilitySpec>& Items = ASC->GetActivatableAbilities();
+
+	// What the indexes replaced
+	auto ScanForClass = [&Items](UClass* AbilityClass, UObject* SourceObject)
+	{
+		for (const FGameplayAbilitySpec& Spec : Items)
+		{
+			if (Spec.Ability && Spec.Ability->GetClass() == AbilityClass && (!SourceObject || Spec.SourceObject == SourceObject))
+			{
+				return Spec.Handle;
+			}
+		}
+
+		return FGameplayAbilitySpecHandle();
+	};
+
+	auto MatchesScan = [ASC, &Items, &ScanForClass]()
+	{
+		for (const FGameplayAbilitySpec& Spec : Items)
+		{
+			if (!Spec.Ability)
+			{
+				continue;
+			}
+
+			UClass* AbilityClass = Spec.Ability->GetClass();
+			if (ASC->FindAbilitySpecHandleForClass(AbilityClass, nullptr) != ScanForClass(AbilityClass, nullptr)
+				|| ASC->FindAbilitySpecHandleForClass(AbilityClass, Spec.SourceObject) != ScanForClass(AbilityClass, Spec.SourceObject))
+			{
+				return false;
+			}
+
+			int32 NumScanned = 0;
+			for (const FGameplayAbilitySpec& OtherSpec : Items)
+			{
+				NumScanned += OtherSpec.InputID == Spec.InputID ? 1 : 0;
+			}
+
+			UGSAbilitySystemComponent::FAbilitySpecHandleList Handles;
+			ASC->FindAbilitySpecHandlesForInputID(Spec.InputID, Handles);
+			if (Handles.Num() != NumScanned || !Handles.Contains(Spec.Handle))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	};
+
+	// Input IDs nothing binds to
+	const int32 InputA = 9000;
+	const int32 InputB = 9001;
+	UObject* SourceObject = Owner;
+	UClass* AbilityClass = UGSGameplayAbility::StaticClass();
+
+	const FGameplayAbilitySpecHandle First = ASC->GiveAbility(FGameplayAbilitySpec(AbilityClass, 1, InputA, SourceObject));
+	const FGameplayAbilitySpecHandle Second = ASC->GiveAbility(FGameplayAbilitySpec(AbilityClass, 1, InputA, nullptr));
+	TestTrue(TEXT("find by class and source"), ASC->FindAbilitySpecHandleForClass(AbilityClass, SourceObject) == First);
+	TestTrue(TEXT("find by class without source"), ASC->FindAbilitySpecHandleForClass(AbilityClass, nullptr) == ScanForClass(AbilityClass, nullptr));
+	TestTrue(TEXT("indexes match scan after give"), MatchesScan());
+
+	FGameplayAbilitySpecHandle GivenWhileLocked;
+	{
+		FScopedAbilityListLock ActiveScopeLock(*ASC);
+
+		GivenWhileLocked = ASC->GiveAbility(FGameplayAbilitySpec(AbilityClass, 1, InputB, SourceObject));
+		ASC->ClearAbility(First);
+
+		UGSAbilitySystemComponent::FAbilitySpecHandleList Handles;
+		ASC->FindAbilitySpecHandlesForInputID(InputB, Handles);
+		TestEqual(TEXT("ability given while locked isn't indexed until unlock"), Handles.Num(), 0);
+		TestTrue(TEXT("ability removed while locked stays until unlock"), ASC->FindAbilitySpecHandleForClass(AbilityClass, SourceObject) == First);
+		TestTrue(TEXT("indexes match scan while locked"), MatchesScan());
+	}
+
+	UGSAbilitySystemComponent::FAbilitySpecHandleList HandlesAfterUnlock;
+	ASC->FindAbilitySpecHandlesForInputID(InputA, HandlesAfterUnlock);
+	TestTrue(TEXT("ability removed while locked is gone after unlock"), HandlesAfterUnlock.Num() == 1 && HandlesAfterUnlock[0] == Second);
+	TestTrue(TEXT("ability given while locked is found after unlock"), ASC->FindAbilitySpecHandleForClass(AbilityClass, SourceObject) == GivenWhileLocked);
+
+	// Removing First moved the other items down. Looking Second up by class goes through its rebuilt index.
+	TestTrue(TEXT("index follows reordered items"), ASC->FindAbilitySpecHandleForClass(AbilityClass, nullptr) == Second);
+	TestTrue(TEXT("indexes match scan after unlock"), MatchesScan());
+
+	ASC->ClearAbility(Second);
+	ASC->ClearAbility(GivenWhileLocked);
+
+	UGSAbilitySystemComponent::FAbilitySpecHandleList Handles;
+	ASC->FindAbilitySpecHandlesForInputID(InputA, Handles);
+	TestTrue(TEXT("indexes empty after cleanup"), Handles.Num() == 0 && ASC->FindAbilitySpecHandleForClass(AbilityClass, SourceObject) == ScanForClass(AbilityClass, SourceObject));
+	TestTrue(TEXT("indexes match scan after cleanup"), MatchesScan());
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,78 @@
+// Copyright 2020 Dan Kestranek.
+
+
+#include "Characters/Abilities/GSPersistentTargetTracker.h"
+#include "Engine/Engine.h"
+#include "Engine/TargetPoint.h"
+#include "Engine/World.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGSPersistentTargetTrackerTest, "GASShooterALS.Trace.PersistentTargetTracker",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FGSPersistentTargetTrackerTest::RunTest(const FString& Parameters)
+{
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	// Targets 100, 200, 300 and 400 units away from the origin
+	TArray<AActor*> Targets;
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	for (int32 TargetIndex = 0; TargetIndex < 4; TargetIndex++)
+	{
+		Targets.Add(World->SpawnActor<ATargetPoint>(FVector((TargetIndex + 1) * 100.0f, 0.0f, 0.0f), FRotator::ZeroRotator, SpawnParams));
+	}
+
+	auto MakeHit = [](AActor* Actor)
+	{
+		FHitResult HitResult;
+		HitResult.Actor = Actor;
+		HitResult.Location = Actor->GetActorLocation();
+		return HitResult;
+	};
+
+	const FVector Origin = FVector::ZeroVector;
+	FGSPersistentTargetTracker Tracker;
+
+	// Oldest: acquisition order is kept and the first target is evicted
+	Tracker.Init(3, EGSTargetEvictionPolicy::Oldest);
+	TestTrue(TEXT("Oldest add 2"), Tracker.Add(MakeHit(Targets[2]), Origin));
+	TestTrue(TEXT("Oldest add 0"), Tracker.Add(MakeHit(Targets[0]), Origin));
+	TestFalse(TEXT("Oldest rejects duplicate"), Tracker.Add(MakeHit(Targets[2]), Origin));
+	TestTrue(TEXT("Oldest add 1"), Tracker.Add(MakeHit(Targets[1]), Origin));
+	TestTrue(TEXT("Oldest is full"), Tracker.IsFull());
+	TestTrue(TEXT("Oldest add 3 when full"), Tracker.Add(MakeHit(Targets[3]), Origin));
+	TestTrue(TEXT("Oldest evicts first acquired"), !Tracker.Contains(Targets[2]) && Tracker.Num() == 3);
+	TestTrue(TEXT("Oldest keeps acquisition order"), Tracker[0].Actor == Targets[0] && Tracker[1].Actor == Targets[1] && Tracker[2].Actor == Targets[3]);
+	TestTrue(TEXT("Oldest re-adds evicted target"), Tracker.Add(MakeHit(Targets[2]), Origin));
+
+	// RemoveAll compacts in order and keeps the index valid across the ring's wrap
+	TestEqual(TEXT("RemoveAll count"), Tracker.RemoveAll([&Targets](const FHitResult& HitResult) { return HitResult.Actor == Targets[3]; }), 1);
+	TestTrue(TEXT("RemoveAll keeps order"), Tracker.Num() == 2 && Tracker[0].Actor == Targets[1] && Tracker[1].Actor == Targets[2]);
+	TestTrue(TEXT("RemoveAll keeps dedupe index"), !Tracker.Add(MakeHit(Targets[1]), Origin) && Tracker.Add(MakeHit(Targets[3]), Origin));
+
+	// Farthest: the farthest target is evicted and farther candidates are ignored when full
+	Tracker.Init(2, EGSTargetEvictionPolicy::Farthest);
+	TestTrue(TEXT("Farthest add 1"), Tracker.Add(MakeHit(Targets[1]), Origin));
+	TestTrue(TEXT("Farthest add 3"), Tracker.Add(MakeHit(Targets[3]), Origin));
+	TestFalse(TEXT("Farthest rejects duplicate"), Tracker.Add(MakeHit(Targets[3]), Origin));
+	TestTrue(TEXT("Farthest add closer target when full"), Tracker.Add(MakeHit(Targets[0]), Origin));
+	TestTrue(TEXT("Farthest evicts farthest and keeps order"), !Tracker.Contains(Targets[3]) && Tracker[0].Actor == Targets[1] && Tracker[1].Actor == Targets[0]);
+	TestTrue(TEXT("Farthest ignores farther target when full"), !Tracker.Add(MakeHit(Targets[2]), Origin) && !Tracker.Contains(Targets[2]));
+
+	// Destroyed Actors can still be removed from the index
+	Targets[0]->Destroy();
+	TestEqual(TEXT("RemoveAll destroyed Actor"), Tracker.RemoveAll([](const FHitResult& HitResult) { return !HitResult.Actor.IsValid(); }), 1);
+	TestTrue(TEXT("Slot freed after destroyed Actor"), Tracker.Num() == 1 && Tracker.Add(MakeHit(Targets[2]), Origin));
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
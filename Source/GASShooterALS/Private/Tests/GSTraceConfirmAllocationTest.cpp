@@ -0,0 +1,109 @@
+// Copyright 2020 Dan Kestranek.
+
+
+#include "Characters/Abilities/GSGATA_LineTrace.h"
+#include "Abilities/GameplayAbility.h"
+#include "Components/BoxComponent.h"
+#include "Engine/CollisionProfile.h"
+#include "Engine/Engine.h"
+#include "Engine/TargetPoint.h"
+#include "Engine/World.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGSTraceConfirmAllocationTest, "GASShooterALS.Trace.ConfirmAllocations",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+/**
+* Confirms a shotgun style trace repeatedly against a blocking box, the same way an ability does, and checks that once
+* the first confirmation has sized the TargetActor's scratch buffers they never grow again and every confirmation still
+* hands out one hit per pellet. The target data structs MakeTargetData() creates for the handle have to be allocated for
+* every shot, so the process' memory use over the warm confirmations is reported rather than checked.
+*/
+bool FGSTraceConfirmAllocationTest::RunTest(const FString& Parameters)
+{
+	const int32 NumConfirmations = 32;
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	AActor* Shooter = World->SpawnActor<ATargetPoint>(FVector::ZeroVector, FRotator::ZeroRotator, SpawnParams);
+
+	// Wall 1000 units in front of the shooter that every pellet hits
+	AActor* Wall = World->SpawnActor<AActor>(AActor::StaticClass(), FVector(1000.0f, 0.0f, 0.0f), FRotator::ZeroRotator, SpawnParams);
+	UBoxComponent* WallBox = NewObject<UBoxComponent>(Wall);
+	WallBox->SetBoxExtent(FVector(50.0f, 1000.0f, 1000.0f));
+	WallBox->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+	Wall->SetRootComponent(WallBox);
+	WallBox->RegisterComponent();
+	Wall->SetActorLocation(FVector(1000.0f, 0.0f, 0.0f));
+
+	AGSGATA_LineTrace* TargetActor = World->SpawnActor<AGSGATA_LineTrace>(FVector::ZeroVector, FRotator::ZeroRotator, SpawnParams);
+
+	// Any ability instance lets the TargetActor aim. Aiming falls back to StartLocation without a PlayerController.
+	TargetActor->OwningAbility = NewObject<UGameplayAbility>(GetTransientPackage());
+	TargetActor->SourceActor = Shooter;
+	TargetActor->StartLocation.LocationType = EGameplayAbilityTargetingLocationType::LiteralTransform;
+	TargetActor->StartLocation.LiteralTransform = FTransform::Identity;
+	TargetActor->TraceProfile = FCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+	TargetActor->MaxRange = 3000.0f;
+	TargetActor->BaseSpread = 10.0f;
+	TargetActor->MaxHitResultsPerTrace = 1;
+	TargetActor->NumberOfTraces = 8;
+	TargetActor->SetShouldProduceTargetDataOnServer(true);
+
+	int32 NumTargetDataReady = 0;
+	int32 NumHitsInLastTargetData = 0;
+	bool bLastTargetDataHitWall = false;
+	TargetActor->TargetDataReadyDelegate.AddLambda([&](const FGameplayAbilityTargetDataHandle& Data)
+	{
+		NumTargetDataReady++;
+		NumHitsInLastTargetData = Data.Num();
+		const FHitResult* FirstHit = Data.Num() > 0 ? Data.Get(0)->GetHitResult() : nullptr;
+		bLastTargetDataHitWall = FirstHit && FirstHit->Actor == Wall;
+	});
+
+	for (const bool bBatchMultiTraces : { false, true })
+	{
+		TargetActor->bBatchMultiTraces = bBatchMultiTraces;
+		const TCHAR* PathName = bBatchMultiTraces ? TEXT("batched") : TEXT("per pellet");
+
+		// The first confirmation sizes the buffers
+		TargetActor->ConfirmTargetingAndContinue();
+		TestEqual(FString::Printf(TEXT("%s confirmation makes one hit per pellet"), PathName), NumHitsInLastTargetData, TargetActor->NumberOfTraces);
+		TestTrue(FString::Printf(TEXT("%s confirmation hits the wall"), PathName), bLastTargetDataHitWall);
+
+		const SIZE_T WarmScratchSize = TargetActor->GetTraceScratchAllocatedSize();
+		const uint64 UsedPhysicalBefore = FPlatformMemory::GetStats().UsedPhysical;
+		NumTargetDataReady = 0;
+
+		int32 NumShortConfirmations = 0;
+		for (int32 ConfirmationIndex = 0; ConfirmationIndex < NumConfirmations; ConfirmationIndex++)
+		{
+			TargetActor->ConfirmTargetingAndContinue();
+			NumShortConfirmations += NumHitsInLastTargetData == TargetActor->NumberOfTraces ? 0 : 1;
+		}
+
+		const int64 UsedPhysicalGrowth = (int64)FPlatformMemory::GetStats().UsedPhysical - (int64)UsedPhysicalBefore;
+
+		TestEqual(FString::Printf(TEXT("%s target data broadcasts"), PathName), NumTargetDataReady, NumConfirmations);
+		TestEqual(FString::Printf(TEXT("%s confirmations missing hits"), PathName), NumShortConfirmations, 0);
+		TestEqual(FString::Printf(TEXT("%s scratch bytes after %d warm confirmations"), PathName, NumConfirmations),
+			(int64)TargetActor->GetTraceScratchAllocatedSize(), (int64)WarmScratchSize);
+		AddInfo(FString::Printf(TEXT("%s: %d warm confirmations, process used physical memory changed by %lld bytes"),
+			PathName, NumConfirmations, UsedPhysicalGrowth));
+	}
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -3,12 +3,14 @@
 
 #include "Weapons/GSProjectile.h"
 #include "GameFramework/ProjectileMovementComponent.h"
+#include "GSNetUpdateFrequencySubsystem.h"
 
 // Sets default values
 AGSProjectile::AGSProjectile()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = false;
+ 	// Only ticks on the server while homing, see BeginPlay()
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
 
 	ProjectileMovement = CreateDefaultSubobject<UProjectileMovementComponent>(FName("ProjectileMovement"));
 	ProjectileMovement->ProjectileGravityScale = 0;
@@ -16,6 +18,56 @@ AGSProjectile::AGSProjectile()
 
 	bReplicates = true;
 
-	//TODO change this to a better value
-	NetUpdateFrequency = 100.0f;
+	NetUpdateFrequency = 100.0f; // Ceiling. UGSNetUpdateFrequencySubsystem lowers it at runtime.
+}
+
+void AGSProjectile::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	// Homing steers every frame, keep the projectile at its ceiling while it does
+	if (ProjectileMovement->bIsHomingProjectile && ProjectileMovement->HomingTargetComponent.IsValid())
+	{
+		UGSNetUpdateFrequencySubsystem::NotifyReplicatedStateChanged(this);
+	}
+}
+
+void AGSProjectile::BeginPlay()
+{
+	// Blueprints set up homing in their BeginPlay
+	Super::BeginPlay();
+
+	if (HasAuthority())
+	{
+		if (UGSNetUpdateFrequencySubsystem* NetUpdateFrequency = GetWorld()->GetSubsystem<UGSNetUpdateFrequencySubsystem>())
+		{
+			NetUpdateFrequency->RegisterActor(this);
+		}
+
+		// A projectile flying straight is extrapolated on clients from its replicated velocity. Only changes of course
+		// count as replicated state changes.
+		ProjectileMovement->OnProjectileBounce.AddDynamic(this, &AGSProjectile::OnProjectileBounce);
+		ProjectileMovement->OnProjectileStop.AddDynamic(this, &AGSProjectile::OnProjectileStop);
+		SetActorTickEnabled(ProjectileMovement->bIsHomingProjectile);
+	}
+}
+
+void AGSProjectile::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UGSNetUpdateFrequencySubsystem* NetUpdateFrequency = GetWorld()->GetSubsystem<UGSNetUpdateFrequencySubsystem>())
+	{
+		NetUpdateFrequency->UnregisterActor(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AGSProjectile::OnProjectileBounce(const FHitResult& ImpactResult, const FVector& ImpactVelocity)
+{
+	UGSNetUpdateFrequencySubsystem::NotifyReplicatedStateChanged(this);
+}
+
+void AGSProjectile::OnProjectileStop(const FHitResult& ImpactResult)
+{
+	UGSNetUpdateFrequencySubsystem::NotifyReplicatedStateChanged(this);
 }
@@ -2,6 +2,7 @@
 
 
 #include "Weapons/GSWeapon.h"
+#include "Animation/AnimMontage.h"
 #include "Characters/Abilities/GSAbilitySystemComponent.h"
 #include "Characters/Abilities/GSAbilitySystemGlobals.h"
 #include "Characters/Abilities/GSGameplayAbility.h"
@@ -11,8 +12,21 @@
 #include "Components/CapsuleComponent.h"
 #include "Components/SkeletalMeshComponent.h"
 #include "GSBlueprintFunctionLibrary.h"
+#include "GSNetUpdateFrequencySubsystem.h"
+#include "GSReplicationGraph.h"
+#include "GSWeaponAssetSubsystem.h"
+#include "Net/Core/PushModel/PushModel.h"
 #include "Net/UnrealNetwork.h"
+#include "PaperSprite.h"
 #include "Player/GSPlayerController.h"
+#include "Sound/SoundCue.h"
+#include "TimerManager.h"
+
+static TAutoConsoleVariable<int32> CVarWeaponDormancy(
+	TEXT("GS.Weapon.Dormancy"),
+	1,
+	TEXT("Whether holstered and dropped weapons go net dormant until something about them changes. Compare Server Replicate Actors in stat net with this on and off.")
+);
 
 // Sets default values
 AGSWeapon::AGSWeapon()
@@ -22,7 +36,7 @@ AGSWeapon::AGSWeapon()
 
 	bReplicates = true;
 	bNetUseOwnerRelevancy = true;
-	NetUpdateFrequency = 100.0f; // Set this to a value that's appropriate for your game
+	NetUpdateFrequency = 100.0f; // Ceiling. UGSNetUpdateFrequencySubsystem lowers it at runtime.
 	bSpawnWithCollision = true;
 	PrimaryClipAmmo = 0;
 	MaxPrimaryClipAmmo = 0;
@@ -63,6 +77,8 @@ AGSWeapon::AGSWeapon()
 	WeaponIsFiringTag = FGameplayTag::RequestGameplayTag("Weapon.IsFiring");
 
 	FireMode = FGameplayTag::RequestGameplayTag("Weapon.FireMode.None");
+	BundledTargetDataFireModes.AddTag(FGameplayTag::RequestGameplayTag("Weapon.Rifle.FireMode.FullAuto"));
+	BundledTargetDataFireModes.AddTag(FGameplayTag::RequestGameplayTag("Weapon.Shotgun.FireMode.FullAuto"));
 	StatusText = DefaultStatusText;
 
 	RestrictedPickupTags.AddTag(FGameplayTag::RequestGameplayTag("State.Dead"));
@@ -88,11 +104,16 @@ void AGSWeapon::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetim
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME_CONDITION(AGSWeapon, OwningCharacter, COND_OwnerOnly);
-	DOREPLIFETIME_CONDITION(AGSWeapon, PrimaryClipAmmo, COND_OwnerOnly);
-	DOREPLIFETIME_CONDITION(AGSWeapon, MaxPrimaryClipAmmo, COND_OwnerOnly);
-	DOREPLIFETIME_CONDITION(AGSWeapon, SecondaryClipAmmo, COND_OwnerOnly);
-	DOREPLIFETIME_CONDITION(AGSWeapon, MaxSecondaryClipAmmo, COND_OwnerOnly);
+	// Push based, so only mark dirty through the setters below
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	Params.Condition = COND_OwnerOnly;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(AGSWeapon, OwningCharacter, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AGSWeapon, PrimaryClipAmmo, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AGSWeapon, MaxPrimaryClipAmmo, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AGSWeapon, SecondaryClipAmmo, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AGSWeapon, MaxSecondaryClipAmmo, Params);
 }
 
 void AGSWeapon::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
@@ -106,6 +127,8 @@ void AGSWeapon::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracke
 void AGSWeapon::SetOwningCharacter(AGSHeroCharacter* InOwningCharacter)
 {
 	OwningCharacter = InOwningCharacter;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AGSWeapon, OwningCharacter, this);
+	UGSNetUpdateFrequencySubsystem::NotifyReplicatedStateChanged(this);
 	if (OwningCharacter)
 	{
 		// Called when added to inventory
@@ -127,6 +150,45 @@ void AGSWeapon::SetOwningCharacter(AGSHeroCharacter* InOwningCharacter)
 		SetOwner(nullptr);
 		DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
 	}
+
+	UpdateReplicationState();
+}
+
+void AGSWeapon::UpdateReplicationState()
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	// Nothing replicated about a holstered weapon changes until it's equipped or dropped. Its ammo setters flush it if they're used anyway.
+	// Dropped weapons stay awake here so the OnDropped multicast can open a channel, and go dormant once it has gone out.
+	const bool bHolstered = OwningCharacter && OwningCharacter->GetCurrentWeapon() != this;
+	SetNetDormancy(bHolstered && CVarWeaponDormancy.GetValueOnGameThread() != 0 ? DORM_DormantAll : DORM_Awake);
+
+	UGSReplicationGraph::NotifyWeaponRoutingChanged(this);
+}
+
+void AGSWeapon::OnReturnedToPool()
+{
+	// Pooled weapons were picked up as ammo, so they are still lying in the world as pickups
+	CollisionComp->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	ResetWeapon();
+}
+
+void AGSWeapon::OnAcquiredFromPool(AGSHeroCharacter* InOwner)
+{
+	// Start with the ammo of a freshly spawned weapon of this class
+	const AGSWeapon* Defaults = GetClass()->GetDefaultObject<AGSWeapon>();
+	SetMaxPrimaryClipAmmo(Defaults->MaxPrimaryClipAmmo);
+	SetPrimaryClipAmmo(Defaults->PrimaryClipAmmo);
+	SetMaxSecondaryClipAmmo(Defaults->MaxSecondaryClipAmmo);
+	SetSecondaryClipAmmo(Defaults->SecondaryClipAmmo);
+
+	ResetWeapon();
+
+	SetOwner(InOwner);
+	SetInstigator(InOwner);
 }
 
 void AGSWeapon::NotifyActorBeginOverlap(AActor* Other)
@@ -293,6 +355,20 @@ void AGSWeapon::OnDropped_Implementation(FVector NewLocation)
 		WeaponMesh3P->CastShadow = true;
 		WeaponMesh3P->SetVisibility(true, true);
 	}
+
+	// Nothing changes while the weapon lies on the ground. Wait a frame so the multicast is sent before the channel closes.
+	if (HasAuthority())
+	{
+		GetWorldTimerManager().SetTimerForNextTick(this, &AGSWeapon::GoDormantOnGround);
+	}
+}
+
+void AGSWeapon::GoDormantOnGround()
+{
+	if (!OwningCharacter && CVarWeaponDormancy.GetValueOnGameThread() != 0)
+	{
+		SetNetDormancy(DORM_DormantAll);
+	}
 }
 
 bool AGSWeapon::OnDropped_Validate(FVector NewLocation)
@@ -324,6 +400,9 @@ void AGSWeapon::SetPrimaryClipAmmo(int32 NewPrimaryClipAmmo)
 {
 	int32 OldPrimaryClipAmmo = PrimaryClipAmmo;
 	PrimaryClipAmmo = NewPrimaryClipAmmo;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AGSWeapon, PrimaryClipAmmo, this);
+	UGSNetUpdateFrequencySubsystem::NotifyReplicatedStateChanged(this);
+	FlushNetDormancy();
 	OnPrimaryClipAmmoChanged.Broadcast(OldPrimaryClipAmmo, PrimaryClipAmmo);
 }
 
@@ -331,6 +410,9 @@ void AGSWeapon::SetMaxPrimaryClipAmmo(int32 NewMaxPrimaryClipAmmo)
 {
 	int32 OldMaxPrimaryClipAmmo = MaxPrimaryClipAmmo;
 	MaxPrimaryClipAmmo = NewMaxPrimaryClipAmmo;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AGSWeapon, MaxPrimaryClipAmmo, this);
+	UGSNetUpdateFrequencySubsystem::NotifyReplicatedStateChanged(this);
+	FlushNetDormancy();
 	OnMaxPrimaryClipAmmoChanged.Broadcast(OldMaxPrimaryClipAmmo, MaxPrimaryClipAmmo);
 }
 
@@ -338,6 +420,9 @@ void AGSWeapon::SetSecondaryClipAmmo(int32 NewSecondaryClipAmmo)
 {
 	int32 OldSecondaryClipAmmo = SecondaryClipAmmo;
 	SecondaryClipAmmo = NewSecondaryClipAmmo;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AGSWeapon, SecondaryClipAmmo, this);
+	UGSNetUpdateFrequencySubsystem::NotifyReplicatedStateChanged(this);
+	FlushNetDormancy();
 	OnSecondaryClipAmmoChanged.Broadcast(OldSecondaryClipAmmo, SecondaryClipAmmo);
 }
 
@@ -345,12 +430,20 @@ void AGSWeapon::SetMaxSecondaryClipAmmo(int32 NewMaxSecondaryClipAmmo)
 {
 	int32 OldMaxSecondaryClipAmmo = MaxSecondaryClipAmmo;
 	MaxSecondaryClipAmmo = NewMaxSecondaryClipAmmo;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AGSWeapon, MaxSecondaryClipAmmo, this);
+	UGSNetUpdateFrequencySubsystem::NotifyReplicatedStateChanged(this);
+	FlushNetDormancy();
 	OnMaxSecondaryClipAmmoChanged.Broadcast(OldMaxSecondaryClipAmmo, MaxSecondaryClipAmmo);
 }
 
 TSubclassOf<UGSHUDReticle> AGSWeapon::GetPrimaryHUDReticleClass() const
 {
-	return PrimaryHUDReticleClass;
+	return Cast<UClass>(UGSWeaponAssetSubsystem::LoadCosmeticAsset(this, PrimaryHUDReticleClass.ToSoftObjectPath()));
+}
+
+UPaperSprite* AGSWeapon::GetPrimaryIcon() const
+{
+	return Cast<UPaperSprite>(UGSWeaponAssetSubsystem::LoadCosmeticAsset(this, PrimaryIcon.ToSoftObjectPath()));
 }
 
 bool AGSWeapon::HasInfiniteAmmo() const
@@ -360,17 +453,39 @@ bool AGSWeapon::HasInfiniteAmmo() const
 
 UAnimMontage* AGSWeapon::GetEquip1PMontage() const
 {
-	return Equip1PMontage;
+	return Cast<UAnimMontage>(UGSWeaponAssetSubsystem::FindResidentCosmeticAsset(this, Equip1PMontage.ToSoftObjectPath()));
 }
 
 UAnimMontage* AGSWeapon::GetEquip3PMontage() const
 {
-	return Equip3PMontage;
+	return Cast<UAnimMontage>(UGSWeaponAssetSubsystem::FindResidentCosmeticAsset(this, Equip3PMontage.ToSoftObjectPath()));
 }
 
 USoundCue* AGSWeapon::GetPickupSound() const
 {
-	return PickupSound;
+	return Cast<USoundCue>(UGSWeaponAssetSubsystem::LoadCosmeticAsset(this, PickupSound.ToSoftObjectPath()));
+}
+
+void AGSWeapon::GetCosmeticAssetPaths(TArray<FSoftObjectPath>& OutPaths) const
+{
+	const FSoftObjectPath Paths[] = {
+		PrimaryIcon.ToSoftObjectPath(),
+		SecondaryIcon.ToSoftObjectPath(),
+		PrimaryClipIcon.ToSoftObjectPath(),
+		SecondaryClipIcon.ToSoftObjectPath(),
+		Equip1PMontage.ToSoftObjectPath(),
+		Equip3PMontage.ToSoftObjectPath(),
+		PickupSound.ToSoftObjectPath(),
+		PrimaryHUDReticleClass.ToSoftObjectPath()
+	};
+
+	for (const FSoftObjectPath& Path : Paths)
+	{
+		if (!Path.IsNull())
+		{
+			OutPaths.AddUnique(Path);
+		}
+	}
 }
 
 FText AGSWeapon::GetDefaultStatusText() const
@@ -413,10 +528,33 @@ void AGSWeapon::BeginPlay()
 	}
 
 	Super::BeginPlay();
+
+	if (UGSWeaponAssetSubsystem* WeaponAssets = GetWorld()->GetSubsystem<UGSWeaponAssetSubsystem>())
+	{
+		WeaponAssets->RegisterWeapon(this);
+	}
+
+	if (HasAuthority())
+	{
+		if (UGSNetUpdateFrequencySubsystem* NetUpdateFrequency = GetWorld()->GetSubsystem<UGSNetUpdateFrequencySubsystem>())
+		{
+			NetUpdateFrequency->RegisterActor(this);
+		}
+	}
 }
 
 void AGSWeapon::EndPlay(EEndPlayReason::Type EndPlayReason)
 {
+	if (UGSNetUpdateFrequencySubsystem* NetUpdateFrequency = GetWorld()->GetSubsystem<UGSNetUpdateFrequencySubsystem>())
+	{
+		NetUpdateFrequency->UnregisterActor(this);
+	}
+
+	if (UGSWeaponAssetSubsystem* WeaponAssets = GetWorld()->GetSubsystem<UGSWeaponAssetSubsystem>())
+	{
+		WeaponAssets->UnregisterWeapon(this);
+	}
+
 	if (LineTraceTargetActor)
 	{
 		LineTraceTargetActor->Destroy();
@@ -11,6 +11,9 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FWaitInteractableTargetDelegate, con
 
 /**
  * Performs a line trace on a timer, looking for an Actor that implements IGSInteractable that is available for interaction.
+ * Scans are skipped while the view, the trace start and the interactables around them haven't changed since the last
+ * trace, for at most GS.Interaction.MaxScanCacheAge seconds. Interactables report availability changes through
+ * UGSInteractableSubsystem::NotifyAvailabilityChanged().
  * The StartLocations are hardcoded for GASShooterALS since we can be in first and third person so we have to check every time
  * we trace. If you only have one start location, you should make it more generic with a parameter on your AbilityTask node.
  */
@@ -30,9 +33,11 @@ class GASSHOOTERALS_API UGSAT_WaitInteractableTarget : public UAbilityTask
 	* @param MaxRange How far to trace.
 	* @param TimerPeriod Period of trace timer.
 	* @param bShowDebug Draws debug lines for traces.
+	* @param ViewAngleThreshold Degrees the view has to turn before we trace again.
+	* @param ViewDistanceThreshold Distance the view or trace start has to move before we trace again.
 	*/
 	UFUNCTION(BlueprintCallable, meta = (HidePin = "OwningAbility", DefaultToSelf = "OwningAbility", BlueprintInternalUseOnly = "true", HideSpawnParms = "Instigator"), Category = "Ability|Tasks")
-	static UGSAT_WaitInteractableTarget* WaitForInteractableTarget(UGameplayAbility* OwningAbility, FName TaskInstanceName, FCollisionProfileName TraceProfile, float MaxRange = 200.0f, float TimerPeriod = 0.1f, bool bShowDebug = true);
+	static UGSAT_WaitInteractableTarget* WaitForInteractableTarget(UGameplayAbility* OwningAbility, FName TaskInstanceName, FCollisionProfileName TraceProfile, float MaxRange = 200.0f, float TimerPeriod = 0.1f, bool bShowDebug = true, float ViewAngleThreshold = 0.5f, float ViewDistanceThreshold = 5.0f);
 
 	virtual void Activate() override;
 
@@ -49,6 +54,24 @@ protected:
 
 	bool bTraceAffectsAimPitch;
 
+	// Half angle in degrees around the view direction that UGSInteractableSubsystem checks for interactables before we trace
+	float CandidateConeHalfAngle;
+
+	float ViewAngleThreshold;
+	float ViewDistanceThreshold;
+
+	// What the last trace saw. We don't trace again until one of these changes.
+	bool bHasScanCache;
+	bool bScanCacheDirty;
+	float CachedScanTime;
+	FVector CachedViewLocation;
+	FVector CachedViewDir;
+	FVector CachedTraceStart;
+	int32 CachedNumCandidates;
+	uint32 CachedCandidateRevision;
+
+	FDelegateHandle AvailabilityChangedHandle;
+
 	FCollisionProfileName TraceProfile;
 
 	FGameplayAbilityTargetDataHandle TargetData;
@@ -64,6 +87,19 @@ protected:
 
 	bool ClipCameraRayToAbilityRange(FVector CameraLocation, FVector CameraDirection, FVector AbilityCenter, float AbilityRange, FVector& ClippedPosition) const;
 
+	void GetViewPoint(const FVector& TraceStart, FVector& OutViewLocation, FVector& OutViewDir) const;
+
+	/**
+	* Asks UGSInteractableSubsystem how many interactables could be hit from TraceStart and the newest revision among them.
+	* Returns INDEX_NONE if there is no subsystem.
+	*/
+	int32 CountInteractableCandidates(const AActor* InSourceActor, const FVector& TraceStart, const FVector& ViewDir, uint32& OutNewestRevision) const;
+
+	// Can we reuse the last trace's result for this view?
+	bool IsScanCacheValid(const FVector& ViewLocation, const FVector& ViewDir, const FVector& TraceStart, int32 NumCandidates, uint32 CandidateRevision) const;
+
+	void OnInteractableAvailabilityChanged(AActor* Interactable);
+
 	UFUNCTION()
 	void PerformTrace();
 
@@ -4,9 +4,12 @@
 
 #include "CoreMinimal.h"
 #include "AbilitySystemComponent.h"
+#include "Net/Serialization/FastArraySerializer.h"
 #include "GSAbilitySystemComponent.generated.h"
 
 class USkeletalMeshComponent;
+class UGSAbilitySystemComponent;
+struct FGameplayAbilityRepAnimMontageForMeshArray;
 
 /**
 * Data about montages that were played locally (all montages in case of server. predictive montages in case of client). Never replicated directly.
@@ -39,10 +42,11 @@ public:
 };
 
 /**
-* Data about montages that is replicated to simulated clients.
+* Data about montages that is replicated to simulated clients. One item per mesh in a fast array so only the meshes whose
+* montage changed are sent.
 */
 USTRUCT()
-struct GASSHOOTERALS_API FGameplayAbilityRepAnimMontageForMesh
+struct GASSHOOTERALS_API FGameplayAbilityRepAnimMontageForMesh : public FFastArraySerializerItem
 {
 	GENERATED_BODY();
 
@@ -53,12 +57,79 @@ public:
 	UPROPERTY()
 	FGameplayAbilityRepAnimMontage RepMontageInfo;
 
-	FGameplayAbilityRepAnimMontageForMesh() : Mesh(nullptr), RepMontageInfo()
+	// Server only. World time when RepMontageInfo.Position was last sent, used to tell how far clients have drifted.
+	float RepPositionTime;
+
+	FGameplayAbilityRepAnimMontageForMesh() : Mesh(nullptr), RepMontageInfo(), RepPositionTime(0.0f)
 	{
 	}
 
 	FGameplayAbilityRepAnimMontageForMesh(USkeletalMeshComponent* InMesh)
-		: Mesh(InMesh), RepMontageInfo()
+		: Mesh(InMesh), RepMontageInfo(), RepPositionTime(0.0f)
+	{
+	}
+
+	void PostReplicatedAdd(const FGameplayAbilityRepAnimMontageForMeshArray& InArraySerializer);
+	void PostReplicatedChange(const FGameplayAbilityRepAnimMontageForMeshArray& InArraySerializer);
+};
+
+USTRUCT()
+struct GASSHOOTERALS_API FGameplayAbilityRepAnimMontageForMeshArray : public FFastArraySerializer
+{
+	GENERATED_BODY();
+
+public:
+	// Will be max one element per skeletal mesh on the AvatarActor
+	UPROPERTY()
+	TArray<FGameplayAbilityRepAnimMontageForMesh> Items;
+
+	UPROPERTY(NotReplicated)
+	UGSAbilitySystemComponent* Owner;
+
+	FGameplayAbilityRepAnimMontageForMeshArray() : Owner(nullptr)
+	{
+	}
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FGameplayAbilityRepAnimMontageForMesh, FGameplayAbilityRepAnimMontageForMeshArray>(Items, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FGameplayAbilityRepAnimMontageForMeshArray> : public TStructOpsTypeTraitsBase2<FGameplayAbilityRepAnimMontageForMeshArray>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+/**
+* One shot's target data held back by target data bundling and sent to the server with the other shots of the same
+* ability activation.
+*/
+USTRUCT()
+struct GASSHOOTERALS_API FGSBundledTargetData
+{
+	GENERATED_BODY();
+
+public:
+	UPROPERTY()
+	FGameplayAbilityTargetDataHandle TargetData;
+
+	UPROPERTY()
+	FGameplayTag ApplicationTag;
+
+	// The prediction key the shot was fired with, the server processes the shot in this key's window
+	UPROPERTY()
+	FPredictionKey PredictionKey;
+
+	// Client world time when the shot was fired
+	UPROPERTY()
+	float Timestamp;
+
+	FGSBundledTargetData() : Timestamp(0.0f)
 	{
 	}
 };
@@ -70,6 +141,8 @@ UCLASS()
 class GASSHOOTERALS_API UGSAbilitySystemComponent : public UAbilitySystemComponent
 {
 	GENERATED_BODY()
+
+	friend struct FGameplayAbilityRepAnimMontageForMesh;
 	
 public:
 	UGSAbilitySystemComponent();
@@ -77,6 +150,10 @@ public:
 	bool bCharacterAbilitiesGiven = false;
 	bool bStartupEffectsApplied = false;
 
+	virtual void InitializeComponent() override;
+
+	virtual void BeginDestroy() override;
+
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
 	virtual bool GetShouldTick() const override;
@@ -85,6 +162,10 @@ public:
 
 	virtual void InitAbilityActorInfo(AActor* InOwnerActor, AActor* InAvatarActor) override;
 
+	// Also counts as a replicated state change of the owner for UGSNetUpdateFrequencySubsystem, so a PlayerState lowered
+	// to its floor replicates gameplay cues and effects without the floor's latency
+	virtual void ForceReplication() override;
+
 	virtual void NotifyAbilityEnded(FGameplayAbilitySpecHandle Handle, UGameplayAbility* Ability, bool bWasCancelled) override;
 
 	// Version of function in AbilitySystemGlobals that returns correct type
@@ -100,6 +181,11 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Abilities")
 	FGameplayAbilitySpecHandle FindAbilitySpecHandleForClass(TSubclassOf<UGameplayAbility> AbilityClass, UObject* OptionalSourceObject=nullptr);
 
+	typedef TArray<FGameplayAbilitySpecHandle, TInlineAllocator<4>> FAbilitySpecHandleList;
+
+	// Handles of every spec bound to InputID, in the order they were given
+	void FindAbilitySpecHandlesForInputID(int32 InputID, FAbilitySpecHandleList& OutHandles) const;
+
 	// Turn on RPC batching in ASC. Off by default.
 	virtual bool ShouldDoServerAbilityRPCBatch() const override { return true; }
 
@@ -126,10 +212,25 @@ public:
 	// latent ability tasks for example, then batching doesn't help and we should just activate normally.
 	// Single shots (semi auto fire) combine ActivateAbility, SendTargetData, and EndAbility into one RPC instead of three.
 	// Full auto shots combine ActivateAbility and SendTargetData into one RPC instead of two for the first bullet. Each subsequent
-	// bullet is one RPC for SendTargetData. We then send one final RPC for the EndAbility when we're done firing.
+	// bullet is one RPC for SendTargetData, unless the ability bundles target data (see SendTargetDataToServer()). We then send
+	// one final RPC for the EndAbility when we're done firing.
 	UFUNCTION(BlueprintCallable, Category = "Abilities")
 	virtual bool BatchRPCTryActivateAbility(FGameplayAbilitySpecHandle InAbilityHandle, bool EndAbilityImmediately);
 
+	/**
+	* Sends TargetData to the server like CallServerSetReplicatedTargetData(). If the ability has bBundleTargetData set or
+	* its weapon is in a bundled fire mode, and the shot isn't part of an RPC batch, it is held and sent with the ability's other shots at most every
+	* GS.Ability.ShotBundleInterval seconds. Each shot keeps its own prediction key and timestamp and the server processes
+	* them in order.
+	*/
+	virtual void SendTargetDataToServer(FGameplayAbilitySpecHandle AbilityHandle, FPredictionKey AbilityOriginalPredictionKey, const FGameplayAbilityTargetDataHandle& TargetData, FGameplayTag ApplicationTag, FPredictionKey CurrentPredictionKey);
+
+	// Sends every held shot now. Must be called before any other RPC about a bundling ability so the server sees them first.
+	void FlushTargetDataBundles();
+
+	// Server only. While the shots of a bundle are processed, how long before the bundle was sent the current shot was fired.
+	FORCEINLINE float GetBundledShotAge() const { return CurrentBundledShotAge; }
+
 	UFUNCTION(BlueprintCallable, Category = "GameplayCue", Meta = (AutoCreateRefTerm = "GameplayCueParameters", GameplayTagFilter = "GameplayCue"))
 	void ExecuteGameplayCueLocal(const FGameplayTag GameplayCueTag, const FGameplayCueParameters& GameplayCueParameters);
 
@@ -213,25 +314,86 @@ public:
 	// Returns amount of time left in current section
 	float GetCurrentMontageSectionTimeLeftForMesh(USkeletalMeshComponent* InMesh);
 
+	// Gives every skeletal mesh on the AvatarActor a montage slot so montage calls never have to add one. Done in
+	// InitAbilityActorInfo(), call it again if the AvatarActor gains skeletal meshes.
+	void RefreshMontageMeshSlots();
+
+	/**
+	* Times Iterations lookups of every mesh's montage data through the slot index against the linear scans it replaced,
+	* plus the GetCurrentMontageForMesh() and GetCurrentMontageSectionIDForMesh() calls built on it.
+	*/
+	void RunMontageLookupBenchmark(int32 Iterations);
+
 protected:
 	// ----------------------------------------------------------------------------------------------------------------
 	//	AnimMontage Support for multiple USkeletalMeshComponents on the AvatarActor.
 	//  Only one ability can be animating at a time though?
 	// ----------------------------------------------------------------------------------------------------------------	
 
-	// Set if montage rep happens while we don't have the animinstance associated with us yet
-	UPROPERTY()
-	bool bPendingMontageRepForMesh;
+	virtual void OnGiveAbility(FGameplayAbilitySpec& AbilitySpec) override;
+	virtual void OnRemoveAbility(FGameplayAbilitySpec& AbilitySpec) override;
+
+	// Kept up to date from OnGiveAbility() and OnRemoveAbility(), which the ability list lock defers until it is released.
+	// Specs given while locked aren't indexed yet and specs removed while locked are still indexed, which is what a scan
+	// of ActivatableAbilities would see too.
+	TMultiMap<int32, FGameplayAbilitySpecHandle> AbilitySpecHandlesByInputID;
+	TMultiMap<const UClass*, FGameplayAbilitySpecHandle> AbilitySpecHandlesByClass;
+
+	// Handle to its index in ActivatableAbilities.Items. Removing abilities reorders the items so this is rebuilt by the
+	// first lookup after the list changed.
+	mutable TMap<FGameplayAbilitySpecHandle, int32> AbilitySpecIndexByHandle;
+	mutable bool bAbilitySpecIndexDirty;
+
+	// Same as FindAbilitySpecFromHandle() without the scan
+	FGameplayAbilitySpec* FindIndexedAbilitySpec(FGameplayAbilitySpecHandle Handle);
+	const FGameplayAbilitySpec* FindIndexedAbilitySpec(FGameplayAbilitySpecHandle Handle) const;
+
+	// Index of Handle's spec in ActivatableAbilities.Items or INDEX_NONE, rebuilding AbilitySpecIndexByHandle if needed
+	int32 FindIndexedAbilitySpecIndex(FGameplayAbilitySpecHandle Handle) const;
+
+	struct FPendingTargetDataBundle
+	{
+		FGameplayAbilitySpecHandle AbilityHandle;
+		FPredictionKey AbilityOriginalPredictionKey;
+		TArray<FGSBundledTargetData> Shots;
+	};
+
+	// Client only. Shots waiting for FlushTargetDataBundles(), one bundle per ability activation.
+	TArray<FPendingTargetDataBundle> PendingTargetDataBundles;
+
+	// Bound to FWorldDelegates::OnWorldPostActorTick while shots are held
+	FDelegateHandle FlushTargetDataBundlesHandle;
+
+	// Client world time of the first shot held since the last flush
+	float OldestBundledShotTime;
+
+	float CurrentBundledShotAge;
+
+	bool ShouldBundleTargetData(FGameplayAbilitySpecHandle AbilityHandle) const;
+
+	// Flushes the held shots once the oldest has waited GS.Ability.ShotBundleInterval
+	void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerSetReplicatedTargetDataBundle(FGameplayAbilitySpecHandle AbilityHandle, FPredictionKey AbilityOriginalPredictionKey, const TArray<FGSBundledTargetData>& Shots, float SendTimestamp);
+	void ServerSetReplicatedTargetDataBundle_Implementation(FGameplayAbilitySpecHandle AbilityHandle, FPredictionKey AbilityOriginalPredictionKey, const TArray<FGSBundledTargetData>& Shots, float SendTimestamp);
+	bool ServerSetReplicatedTargetDataBundle_Validate(FGameplayAbilitySpecHandle AbilityHandle, FPredictionKey AbilityOriginalPredictionKey, const TArray<FGSBundledTargetData>& Shots, float SendTimestamp);
 
 	// Data structure for montages that were instigated locally (everything if server, predictive if client. replicated if simulated proxy)
 	// Will be max one element per skeletal mesh on the AvatarActor
 	UPROPERTY()
 	TArray<FGameplayAbilityLocalAnimMontageForMesh> LocalAnimMontageInfoForMeshes;
 
-	// Data structure for replicating montage info to simulated clients
-	// Will be max one element per skeletal mesh on the AvatarActor
-	UPROPERTY(ReplicatedUsing = OnRep_ReplicatedAnimMontageForMesh)
-	TArray<FGameplayAbilityRepAnimMontageForMesh> RepAnimMontageInfoForMeshes;
+	// Data structure for replicating montage info to simulated clients. Items are only marked dirty when the montage, play
+	// rate, next section or stopped state changes or the position drifts from where clients will have played it to.
+	UPROPERTY(Replicated)
+	FGameplayAbilityRepAnimMontageForMeshArray RepAnimMontageInfoForMeshes;
+
+	// Mesh to its slot in LocalAnimMontageInfoForMeshes. Slots are only added, so they stay valid until InitAbilityActorInfo().
+	TMap<const USkeletalMeshComponent*, int32> LocalAnimMontageSlotByMesh;
+
+	// Mesh to its slot in RepAnimMontageInfoForMeshes. Only the authority adds items, the same as LocalAnimMontageSlotByMesh.
+	TMap<const USkeletalMeshComponent*, int32> RepAnimMontageSlotByMesh;
 
 	// Finds the existing FGameplayAbilityLocalAnimMontageForMesh for the mesh or creates one if it doesn't exist
 	FGameplayAbilityLocalAnimMontageForMesh& GetLocalAnimMontageInfoForMesh(USkeletalMeshComponent* InMesh);
@@ -241,16 +403,19 @@ protected:
 	// Called when a prediction key that played a montage is rejected
 	void OnPredictiveMontageRejectedForMesh(USkeletalMeshComponent* InMesh, UAnimMontage* PredictiveMontage);
 
-	// Copy LocalAnimMontageInfo into RepAnimMontageInfo
+	// Copy LocalAnimMontageInfo into RepAnimMontageInfo, marking it dirty if clients need the change
 	void AnimMontage_UpdateReplicatedDataForMesh(USkeletalMeshComponent* InMesh);
-	void AnimMontage_UpdateReplicatedDataForMesh(FGameplayAbilityRepAnimMontageForMesh& OutRepAnimMontageInfo);
+	void AnimMontage_UpdateReplicatedDataForMesh(FGameplayAbilityRepAnimMontageForMesh& OutRepAnimMontageInfo, bool bForceDirty = false);
 
 	// Copy over playing flags for duplicate animation data
 	void AnimMontage_UpdateForcedPlayFlagsForMesh(FGameplayAbilityRepAnimMontageForMesh& OutRepAnimMontageInfo);	
 
-	UFUNCTION()
+	// Applies every replicated montage, used when montage rep arrived before we could handle it
 	virtual void OnRep_ReplicatedAnimMontageForMesh();
 
+	// Applies the replicated montage of one mesh. Called by the fast array when that mesh's item changes.
+	virtual void OnRep_ReplicatedAnimMontageForMesh(FGameplayAbilityRepAnimMontageForMesh& NewRepMontageInfoForMesh);
+
 	// Returns true if we are ready to handle replicated montage information
 	virtual bool IsReadyForReplicatedMontageForMesh();
 
@@ -6,6 +6,9 @@
 #include "AbilitySystemGlobals.h"
 #include "GSAbilitySystemGlobals.generated.h"
 
+class UGameplayEffect;
+struct FGameplayAttribute;
+
 /**
  * Child class of UAbilitySystemGlobals.
  * Do not try to get a reference to this or call into it during constructors of other UObjects. It will crash in packaged games.
@@ -37,6 +40,29 @@ public:
 	UPROPERTY()
 	FGameplayTag InteractingRemovalTag;
 
+	// UGSGameplayCueManifest asset that UGSGameplayCueManager preloads cues from. The manifest in DefaultGame.ini is used
+	// if it's not set.
+	UPROPERTY(config)
+	FSoftObjectPath GameplayCueManifestName;
+
+	// SetByCaller keys of GetBountyEffect()
+	UPROPERTY()
+	FGameplayTag BountyXPDataTag;
+
+	UPROPERTY()
+	FGameplayTag BountyGoldDataTag;
+
+	/**
+	* Instant gameplay effects built once and shared by every caller, driven by SetByCaller magnitudes.
+	* Use these instead of building a transient UGameplayEffect with NewObject for every application.
+	*/
+
+	// Adds the SetByCaller magnitude keyed by AmmoType to AmmoType's reserve ammo. Returns nullptr if AmmoType has no reserve ammo attribute.
+	UGameplayEffect* GetAmmoRefillEffect(const FGameplayTag& AmmoType);
+
+	// Adds the BountyXPDataTag and BountyGoldDataTag SetByCaller magnitudes to XP and Gold
+	UGameplayEffect* GetBountyEffect();
+
 	static UGSAbilitySystemGlobals& GSGet()
 	{
 		return dynamic_cast<UGSAbilitySystemGlobals&>(Get());
@@ -46,4 +72,15 @@ public:
 	virtual FGameplayEffectContext* AllocGameplayEffectContext() const override;
 
 	virtual void InitGlobalTags() override;
+
+protected:
+	UPROPERTY()
+	TMap<FGameplayTag, UGameplayEffect*> AmmoRefillEffects;
+
+	UPROPERTY()
+	UGameplayEffect* BountyEffect;
+
+	UGameplayEffect* MakeInstantEffect(FName Name);
+
+	static void AddSetByCallerModifier(UGameplayEffect* Effect, const FGameplayAttribute& Attribute, const FGameplayTag& DataTag);
 };
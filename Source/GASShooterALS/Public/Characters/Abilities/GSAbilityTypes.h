@@ -70,3 +70,146 @@ public:
 	void ClearTargets();
 };
 
+/**
+ * SingleTargetHit that only sends what our damage and GameplayCue paths read: the hit Actor, the bone as an index into
+ * the Actor's skeletal mesh, the quantized impact point and normal, the trace start and end, the physical material and
+ * whether it was a blocking hit. The rest of the FHitResult is rebuilt from those on the receiving side.
+ */
+USTRUCT()
+struct GASSHOOTERALS_API FGSTargetData_CompactHit : public FGameplayAbilityTargetData_SingleTargetHit
+{
+	GENERATED_BODY()
+
+public:
+	FGSTargetData_CompactHit() {}
+
+	FGSTargetData_CompactHit(const FHitResult& InHitResult) : FGameplayAbilityTargetData_SingleTargetHit(InHitResult) {}
+
+	virtual UScriptStruct* GetScriptStruct() const override
+	{
+		return FGSTargetData_CompactHit::StaticStruct();
+	}
+
+	virtual FString ToString() const override
+	{
+		return TEXT("FGSTargetData_CompactHit");
+	}
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FGSTargetData_CompactHit> : public TStructOpsTypeTraitsBase2<FGSTargetData_CompactHit>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
+/** One pellet of a FGSTargetData_SpreadShot that hit something */
+struct FGSSpreadShotHit
+{
+	// Index into the regenerated pellet cone
+	uint8 PelletIndex;
+
+	// Index into FGSTargetData_SpreadShot::HitActors. INDEX_NONE (255) for hits without an Actor.
+	uint8 ActorIndex;
+
+	// Index into the hit Actor's skeletal mesh reference skeleton, INDEX_NONE if no bone
+	int32 BoneIndex;
+
+	// Distance from the shot origin along the pellet direction
+	float Distance;
+
+	bool bBlockingHit;
+
+	FGSSpreadShotHit() : PelletIndex(0), ActorIndex(MAX_uint8), BoneIndex(INDEX_NONE), Distance(0.0f), bBlockingHit(false) {}
+};
+
+/**
+ * Compact target data for spread weapons. Instead of one FHitResult per pellet, the client sends the shot origin, the
+ * quantized aim direction, the cone angle and a shot index. The spread seed is derived from the ability's activation
+ * PredictionKey and the shot index so the server can regenerate the exact same pellet cone instead of trusting it.
+ * Only pellets that hit something are sent, as an actor index, bone index and distance along the pellet.
+ *
+ * AGSGATA_Trace expands this back into FGameplayAbilityTargetData_SingleTargetHits on the server before the ability
+ * sees it so abilities don't need to know about it.
+ */
+USTRUCT()
+struct GASSHOOTERALS_API FGSTargetData_SpreadShot : public FGameplayAbilityTargetData
+{
+	GENERATED_BODY()
+
+public:
+	FGSTargetData_SpreadShot() : ConeHalfAngle(0.0f), ShotIndex(0), NumPellets(0) {}
+
+	UPROPERTY()
+	FVector_NetQuantize10 Origin;
+
+	UPROPERTY()
+	FVector_NetQuantizeNormal AimDirection;
+
+	// Radians
+	UPROPERTY()
+	float ConeHalfAngle;
+
+	// Shots fired so far in this ability activation. Combined with the activation PredictionKey to make the seed.
+	UPROPERTY()
+	uint16 ShotIndex;
+
+	UPROPERTY()
+	uint8 NumPellets;
+
+	UPROPERTY()
+	TArray<TWeakObjectPtr<AActor>> HitActors;
+
+	TArray<FGSSpreadShotHit> Hits;
+
+	static int32 MakeSpreadSeed(const FPredictionKey& ActivationPredictionKey, uint16 InShotIndex);
+
+	/**
+	* Rounds the shot parameters to what the server will receive. The client must trace the quantized shot so that the
+	* server regenerates exactly the same pellets.
+	*/
+	static void QuantizeShot(FVector& InOutOrigin, FVector& InOutAimDirection, float& InOutConeHalfAngle);
+
+	// Adds a hit to the pellet, resolving the Actor and bone into indices
+	void AddHit(const FHitResult& HitResult, int32 PelletIndex);
+
+	// Regenerates every pellet's direction from the seed
+	void GeneratePelletDirections(int32 Seed, TArray<FVector>& OutDirections) const;
+
+	/**
+	* Rebuilds the HitResults the client saw, one list per pellet in pellet order. Pellets that didn't hit anything
+	* get a default HitResult at the end of their trace like AGSGATA_Trace::PerformTrace() does.
+	*/
+	void ExpandToHitResults(int32 Seed, float MaxRange, const FVector& HitResultTraceStart, TArray<FHitResult>& OutHitResults) const;
+
+	virtual TArray<TWeakObjectPtr<AActor>> GetActors() const override
+	{
+		return HitActors;
+	}
+
+	virtual UScriptStruct* GetScriptStruct() const override
+	{
+		return FGSTargetData_SpreadShot::StaticStruct();
+	}
+
+	virtual FString ToString() const override
+	{
+		return TEXT("FGSTargetData_SpreadShot");
+	}
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FGSTargetData_SpreadShot> : public TStructOpsTypeTraitsBase2<FGSTargetData_SpreadShot>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithCopy = true		// Hits isn't a UPROPERTY
+	};
+};
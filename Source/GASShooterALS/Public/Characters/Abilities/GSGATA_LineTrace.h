@@ -88,7 +88,8 @@ public:
 protected:
 
 	virtual void DoTrace(TArray<FHitResult>& HitResults, const UWorld* World, const FGameplayTargetDataFilterHandle FilterHandle, const FVector& Start, const FVector& End, FName ProfileName, const FCollisionQueryParams Params) override;
-	virtual void ShowDebugTrace(TArray<FHitResult>& HitResults, EDrawDebugTrace::Type DrawDebugType, float Duration = 2.0f) override;
+	virtual FTraceHandle DoAsyncTrace(UWorld* World, const FVector& Start, const FVector& End, FName ProfileName, const FCollisionQueryParams& Params, FTraceDelegate* InDelegate, uint32 UserData) override;
+	virtual void ShowDebugTrace(const TArray<FHitResult>& HitResults, EDrawDebugTrace::Type DrawDebugType, float Duration = 2.0f) override;
 
 #if ENABLE_DRAW_DEBUG
 	// Util for drawing result of multi line trace from KismetTraceUtils.h
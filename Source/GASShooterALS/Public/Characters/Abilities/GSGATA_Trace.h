@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "Abilities/GameplayAbilityTargetActor.h"
+#include "Characters/Abilities/GSPersistentTargetTracker.h"
 #include "CollisionQueryParams.h"
 #include "DrawDebugHelpers.h"
 #include "Engine/CollisionProfile.h"
@@ -81,6 +82,29 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta = (ExposeOnSpawn = true), Category = "Trace")
 	bool bUsePersistentHitResults;
 
+	// Which persistent target a new one replaces once MaxHitResultsPerTrace targets are tracked
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta = (ExposeOnSpawn = true), Category = "Trace")
+	EGSTargetEvictionPolicy PersistentTargetEvictionPolicy;
+
+	// Multi-trace weapons aim once per shot and trace every pellet back to back into reused buffers instead of
+	// re-aiming and moving the TargetActor for each pellet. All pellets share one spread increment per shot.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta = (ExposeOnSpawn = true), Category = "Trace")
+	bool bBatchMultiTraces;
+
+	// Client sends FGSTargetData_SpreadShot instead of one HitResult per trace. The spread seed comes from the ability's
+	// activation PredictionKey so the server regenerates the same cone. Always uses the batched, single aim path.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta = (ExposeOnSpawn = true), Category = "Trace")
+	bool bUseSeededSpreadTargetData;
+
+	// Server rewinds hit heroes to when the client fired and rejects target data whose hits don't line up
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta = (ExposeOnSpawn = true), Category = "Trace")
+	bool bValidateHitsWithLagCompensation;
+
+	// Ticking traces (bUsePersistentHitResults or bDebug) go through the world's async trace queue and are consumed the
+	// next frame instead of blocking the game thread. The aim lags the camera by one frame. Confirmation always traces synchronously.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta = (ExposeOnSpawn = true), Category = "Trace")
+	bool bUseAsyncTickTrace;
+
 	UFUNCTION(BlueprintCallable)
 	virtual void ResetSpread();
 
@@ -104,6 +128,8 @@ public:
 
 	virtual void CancelTargeting() override;
 
+	virtual bool OnReplicatedTargetDataReceived(FGameplayAbilityTargetDataHandle& Data) const override;
+
 	virtual void BeginPlay() override;
 
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
@@ -115,23 +141,154 @@ public:
 
 	virtual void AimWithPlayerController(const AActor* InSourceActor, FCollisionQueryParams Params, const FVector& TraceStart, FVector& OutTraceEnd, bool bIgnorePitch = false);
 
+	// Camera trace and pitch adjustment of AimWithPlayerController() without the spread. Returns false if there is no OwningAbility.
+	virtual bool GetAdjustedAimDirection(const AActor* InSourceActor, const FCollisionQueryParams& Params, const FVector& TraceStart, FVector& OutAimDir);
+
+	// Camera ray that GetAdjustedAimDirection() traces, clipped to MaxRange around TraceStart
+	void GetAimViewPoint(const FVector& TraceStart, FVector& OutViewStart, FVector& OutViewDir, FVector& OutViewEnd) const;
+
+	// Turns the camera ray's first hit (or nullptr) into the aim direction from TraceStart and grows the targeting spread
+	FVector AdjustAimDirection(const FVector& TraceStart, const FVector& ViewDir, const FVector& ViewEnd, const FHitResult* AimHit);
+
 	virtual bool ClipCameraRayToAbilityRange(FVector CameraLocation, FVector CameraDirection, FVector AbilityCenter, float AbilityRange, FVector& ClippedPosition);
 
 	virtual void StopTargeting();
 
+	// Actors currently tracked by bUsePersistentHitResults, oldest first. Same order as the reticles.
+	UFUNCTION(BlueprintPure)
+	TArray<AActor*> GetPersistentTargetActors() const;
+
+	const FGSPersistentTargetTracker& GetPersistentTargets() const { return PersistentTargets; }
+
+	// Heap memory held by the buffers PerformTrace() reuses between shots. Only grows while they're being sized.
+	SIZE_T GetTraceScratchAllocatedSize() const;
+
 protected:
 	// Trace End point, useful for debug drawing
 	FVector CurrentTraceEnd;
 	
+	// Reticles in use by the current targeting
 	TArray<TWeakObjectPtr<AGameplayAbilityWorldReticle>> ReticleActors;
-	TArray<FHitResult> PersistentHitResults;
+
+	// Hidden reticles from previous targeting, reused by the next StartTargeting() instead of spawning new ones.
+	// Grows to the most reticles ever needed at once and is only destroyed with this TargetActor.
+	TArray<TWeakObjectPtr<AGameplayAbilityWorldReticle>> ReticlePool;
+
+	// Lock-on targets for bUsePersistentHitResults. Capacity is MaxHitResultsPerTrace.
+	FGSPersistentTargetTracker PersistentTargets;
+
+	// Storage returned by PerformTrace(), kept between shots so it doesn't reallocate
+	TArray<FHitResult> PerformTraceHitResults;
+
+	// Scratch buffers for one pellet's hits and for the camera aim trace
+	TArray<FHitResult> PelletHitResults;
+	TArray<FHitResult> AimHitResults;
+
+	// Scratch buffer for bBatchMultiTraces
+	TArray<FVector> BatchTraceEnds;
+
+	// Pellet that produced each HitResult returned by the batched path
+	TArray<uint8> BatchHitPelletIndices;
+
+	// Quantized parameters of the last seeded shot, sent in FGSTargetData_SpreadShot
+	FVector LastShotOrigin;
+	FVector LastShotAimDirection;
+	float LastShotConeHalfAngle;
+
+	// Shots confirmed in the current ability activation
+	FPredictionKey SpreadShotPredictionKey;
+	uint16 SpreadShotIndex;
+
+	// Server only. Used to reject replayed and skipped seeded shots.
+	mutable FPredictionKey LastAcceptedSpreadShotKey;
+	mutable int32 LastAcceptedSpreadShotIndex;
+
+	// bUseAsyncTickTrace state. Results tagged with an older generation were requested by a previous targeting and are dropped.
+	FTraceDelegate AsyncAimTraceDelegate;
+	FTraceDelegate AsyncTargetTraceDelegate;
+	uint32 AsyncTraceGeneration;
+	bool bAsyncAimTracePending;
+	bool bAsyncTargetTracePending;
+
+	// Camera ray of the pending aim trace
+	FVector AsyncAimTraceStart;
+	FVector AsyncAimViewDir;
+	FVector AsyncAimViewEnd;
+
+	// Result of the last completed aim trace, used by the next target trace
+	bool bHasAsyncAimDirection;
+	FVector AsyncAimDirection;
+
+	// Pending target trace
+	FVector AsyncTargetTraceStart;
+	FVector AsyncTargetTraceEnd;
+
+	// Last completed target trace, returned by Tick() until the next one arrives
+	TArray<FHitResult> AsyncTickHitResults;
+
+	bool ShouldUseAsyncTickTrace() const;
+
+	// Consumes last frame's async results by way of the delegates and queues this frame's aim and target traces
+	void PerformAsyncTickTrace(AActor* InSourceActor);
+
+	void OnAsyncAimTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+	void OnAsyncTargetTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+
+	// Drops any queued async traces and forgets the last aim
+	void ResetAsyncTickTrace();
+
+	bool ShouldBatchMultiTraces() const;
+
+	bool UsesSeededSpreadTargetData() const;
+
+	// Seed for the next seeded shot. Restarts the shot count when the ability activation changes.
+	int32 GetSpreadSeed();
+
+	// Server only. Replaces any FGSTargetData_SpreadShot in Data with the SingleTargetHits it represents.
+	// Returns false if a shot is malformed or replayed.
+	bool ExpandSpreadShotTargetData(FGameplayAbilityTargetDataHandle& Data) const;
+
+	// Logs the size of Data against sending every HitResult as a SingleTargetHit. See GS.TargetData.LogBandwidth.
+	void LogTargetDataBandwidth(const TArray<FHitResult>& HitResults, FGameplayAbilityTargetDataHandle& Data) const;
 
 	virtual FGameplayAbilityTargetDataHandle MakeTargetData(const TArray<FHitResult>& HitResults) const;
-	virtual TArray<FHitResult> PerformTrace(AActor* InSourceActor);
+
+	// Returns storage owned by this TargetActor that stays valid until the next PerformTrace()
+	virtual const TArray<FHitResult>& PerformTrace(AActor* InSourceActor);
+
+	FCollisionQueryParams MakeTraceQueryParams(AActor* InSourceActor) const;
+
+	// StartLocation, or the player's ViewPoint if bTraceFromPlayerViewPoint
+	FVector GetTraceStartLocation() const;
+
+	// Removes hits on actors that fail FilterHandle and points the rest from StartLocation to End
+	void FilterHitResults(TArray<FHitResult>& InOutHitResults, const FGameplayTargetDataFilterHandle& FilterHandle, const FVector& End) const;
+
+	// Drops persistent targets that blocked, became invalid or moved out of range
+	void PurgePersistentHitResults(const FVector& TraceStart);
+
+	// Trims one trace's hits, feeds PersistentTargets or the trace's reticles and adds a default hit at TraceEnd if empty
+	void ProcessTraceHitResults(int32 TraceIndex, TArray<FHitResult>& TraceHitResults, const FVector& TraceEnd);
+
+	void UpdatePersistentReticles();
+
+	// Counts confirmations that had to grow a scratch buffer in "stat GSTrace"
+	void CheckTraceScratchGrowth(SIZE_T ScratchSizeBeforeTrace);
 
 	virtual void DoTrace(TArray<FHitResult>& HitResults, const UWorld* World, const FGameplayTargetDataFilterHandle FilterHandle, const FVector& Start, const FVector& End, FName ProfileName, const FCollisionQueryParams Params) PURE_VIRTUAL(AGSGATA_Trace, return;);
-	virtual void ShowDebugTrace(TArray<FHitResult>& HitResults, EDrawDebugTrace::Type DrawDebugType, float Duration = 2.0f) PURE_VIRTUAL(AGSGATA_Trace, return;);
+	virtual void ShowDebugTrace(const TArray<FHitResult>& HitResults, EDrawDebugTrace::Type DrawDebugType, float Duration = 2.0f) PURE_VIRTUAL(AGSGATA_Trace, return;);
+
+	// Queues the same trace as DoTrace() on the world's async trace queue. Results are unfiltered.
+	virtual FTraceHandle DoAsyncTrace(UWorld* World, const FVector& Start, const FVector& End, FName ProfileName, const FCollisionQueryParams& Params, FTraceDelegate* InDelegate, uint32 UserData) PURE_VIRTUAL(AGSGATA_Trace, return FTraceHandle(););
 
 	virtual AGameplayAbilityWorldReticle* SpawnReticleActor(FVector Location, FRotator Rotation);
+
+	// Fills ReticleActors with NumReticles hidden reticles, reusing pooled ones of the current ReticleClass first
+	virtual void AcquireReticleActors(int32 NumReticles);
+
+	// Hides ReticleActors and returns them to the ReticlePool
+	virtual void ReleaseReticleActors();
+
+	// Destroys both the active and pooled reticles
 	virtual void DestroyReticleActors();
 };
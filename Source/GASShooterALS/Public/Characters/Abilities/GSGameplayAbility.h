@@ -69,6 +69,12 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Ability")
 	bool bCannotActivateWhileInteracting;
 
+	// If true, the target data this ability sends to the server is always bundled into one RPC per
+	// GS.Ability.ShotBundleInterval instead of one per shot. Weapon abilities are also bundled while their weapon is in one
+	// of its BundledTargetDataFireModes.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Ability")
+	bool bBundleTargetData;
+
 	// Map of gameplay tags to gameplay effect containers
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "GameplayEffects")
 	TMap<FGameplayTag, FGSGameplayEffectContainer> EffectContainerMap;
@@ -117,6 +123,10 @@ public:
 
 	virtual bool CanActivateAbility(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayTagContainer* SourceTags = nullptr, const FGameplayTagContainer* TargetTags = nullptr, OUT FGameplayTagContainer* OptionalRelevantTags = nullptr) const override;
 
+	// Both send held target data bundles first so the server has every shot before the ability ends
+	virtual void CancelAbility(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo, bool bReplicateCancelAbility) override;
+	virtual void EndAbility(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo, bool bReplicateEndAbility, bool bWasCancelled) override;
+
 	virtual bool CheckCost(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, OUT FGameplayTagContainer* OptionalRelevantTags = nullptr) const override;
 
 	// Allows C++ and Blueprint abilities to override how cost is checked in case they don't use a GE like weapon ammo
@@ -170,8 +180,15 @@ protected:
 	UPROPERTY()
 	TArray<FAbilityMeshMontage> CurrentAbilityMeshMontages;
 
+	// Mesh to its slot in CurrentAbilityMeshMontages. Entries are only removed along with every slot when the avatar
+	// changes, so slots stay valid. Weak so a destroyed mesh's address can't alias a new one.
+	TMap<TWeakObjectPtr<const USkeletalMeshComponent>, int32> AbilityMeshMontageSlotByMesh;
+
 	bool FindAbillityMeshMontage(USkeletalMeshComponent* InMesh, FAbilityMeshMontage& InAbilityMontage);
 
+	// Returns the mesh's entry in CurrentAbilityMeshMontages or nullptr
+	FAbilityMeshMontage* FindAbillityMeshMontage(const USkeletalMeshComponent* InMesh);
+
 	/** Immediately jumps the active montage to a section */
 	UFUNCTION(BlueprintCallable, Category = "Ability|Animation")
 	void MontageJumpToSectionForMesh(USkeletalMeshComponent* InMesh, FName SectionName);
@@ -3,9 +3,40 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Engine/World.h"
 #include "GameplayCueManager.h"
 #include "GSGameplayCueManager.generated.h"
 
+class AGameplayCueNotify_Actor;
+class AGSWeapon;
+class UGSGameplayCueManifest;
+struct FStreamableHandle;
+
+DECLARE_STATS_GROUP(TEXT("GSGameplayCues"), STATGROUP_GSGameplayCues, STATCAT_Advanced);
+
+struct FGSQueuedLocalGameplayCue
+{
+	TWeakObjectPtr<AActor> TargetActor;
+	FGameplayTag GameplayCueTag;
+	EGameplayCueEvent::Type EventType;
+	FGameplayCueParameters Parameters;
+};
+
+/**
+ * Local cues waiting for the end of their world's frame. Keeps the latest queued index of every event type per target
+ * and cue so that duplicates can be merged without searching the queue.
+ */
+struct FGSLocalGameplayCueQueue
+{
+	struct FLatestEvents
+	{
+		int32 Index[EGameplayCueEvent::Removed + 1] = { INDEX_NONE, INDEX_NONE, INDEX_NONE, INDEX_NONE };
+	};
+
+	TArray<FGSQueuedLocalGameplayCue> Cues;
+	TMap<TPair<const AActor*, FGameplayTag>, FLatestEvents> LatestEventsByTargetAndTag;
+};
+
 /**
  * 
  */
@@ -24,4 +55,94 @@ public:
 		//return true; // Default	
 		return false;
 	}
+
+	virtual void OnCreated() override;
+	virtual void BeginDestroy() override;
+
+	// Measures cues that weren't loaded when they were first used and records cues for the manifest
+	virtual void HandleGameplayCue(AActor* TargetActor, FGameplayTag GameplayCueTag, EGameplayCueEvent::Type EventType, const FGameplayCueParameters& Parameters, EGameplayCueExecutionOptions Options = EGameplayCueExecutionOptions::Default) override;
+
+	// Preloads the cues the manifest lists for Weapon and the abilities it grants if the GSGameplayCueManager is in use
+	static void PreloadGameplayCuesForWeapon(const AGSWeapon* Weapon);
+
+	/**
+	* Async loads the notifies of Cues and keeps them loaded until the next map, so that their first use doesn't have to
+	* load them. Does nothing on dedicated servers since they don't play cues.
+	*/
+	void PreloadGameplayCues(const FGameplayTagContainer& Cues, const FString& Reason);
+
+	UGSGameplayCueManifest* GetManifest();
+
+	// Merges the cues recorded with GS.Cue.RecordManifest into the manifest, or logs them outside of the editor
+	void SaveRecordedManifest();
+
+	// Logs how many cues were preloaded and which ones still had to be loaded on first use
+	void LogPreloadReport() const;
+
+	// Queues the cue on the GSGameplayCueManager if that's the cue manager in use, otherwise handles it right away
+	static void HandleLocalGameplayCue(AActor* TargetActor, FGameplayTag GameplayCueTag, EGameplayCueEvent::Type EventType, const FGameplayCueParameters& Parameters);
+
+	/**
+	* Holds a non replicated cue until the end of the target's world frame and handles it there with the rest of the frame's
+	* local cues. A cue that is already queued for the same target is merged into the queued one instead of being handled
+	* twice. Executes merge when they're within GS.Cue.MergeDistance of each other and keep the larger magnitudes, adds
+	* and removes merge when nothing of the opposite kind was queued in between.
+	*/
+	void QueueLocalGameplayCue(AActor* TargetActor, FGameplayTag GameplayCueTag, EGameplayCueEvent::Type EventType, const FGameplayCueParameters& Parameters);
+
+	// Handles every local cue queued for World
+	void FlushLocalGameplayCues(UWorld* World);
+
+	// Caps the engine's recycled actor list per notify class and counts how often it is reused
+	virtual AGameplayCueNotify_Actor* GetInstancedCueActor(AActor* TargetActor, UClass* GameplayCueNotifyActorClass, const FGameplayCueParameters& Parameters) override;
+	virtual void NotifyGameplayCueActorFinished(AGameplayCueNotify_Actor* Actor) override;
+
+protected:
+	UPROPERTY(Transient)
+	UGSGameplayCueManifest* Manifest;
+
+	bool bManifestLoaded;
+
+	UPROPERTY(Transient)
+	UGSGameplayCueManifest* RecordedManifest;
+
+	// Keep the preloaded notifies in memory until the next map
+	TArray<TSharedPtr<FStreamableHandle>> CuePreloadHandles;
+	FGameplayTagContainer PreloadedCues;
+
+	// Cues known to be loaded since the last map load, so they don't have to be checked again
+	TSet<FGameplayTag> LoadedCues;
+
+	// Cues that weren't loaded yet when they were first used and how long it took from their first use until they loaded
+	TMap<FGameplayTag, double> CueFirstUseSeconds;
+
+	// Which of CueFirstUseSeconds were async loaded, making the cue late rather than hitching the game thread
+	TSet<FGameplayTag> AsyncFirstUseCues;
+
+	// First used cues whose async load hasn't completed yet
+	TSet<FGameplayTag> PendingFirstUseLoads;
+
+	TMap<const UWorld*, FGSLocalGameplayCueQueue> LocalCueQueues;
+
+	// Finished notify actors sitting in the engine's recycle list
+	TSet<TWeakObjectPtr<AGameplayCueNotify_Actor>> PooledCueActors;
+	TMap<const UClass*, int32> PooledCueActorCountByClass;
+
+	FDelegateHandle PostActorTickHandle;
+	FDelegateHandle WorldCleanupHandle;
+	FDelegateHandle WorldInitializedHandle;
+
+	void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+	void OnWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources);
+	void OnWorldInitialized(UWorld* World, const UWorld::InitializationValues IVS);
+	void OnCuePreloadComplete(FString Reason, int32 NumNotifies, double StartTime);
+	void OnFirstUseLoadComplete(FGameplayTag GameplayCueTag, double StartTime, bool bAsync);
+
+	// Adds the notify paths that handling GameplayCueTag runs, including its parents'. bOnlyUnloaded skips loaded ones.
+	void GetNotifyPaths(FGameplayTag GameplayCueTag, TArray<FSoftObjectPath>& OutPaths, bool bOnlyUnloaded);
+
+	void RecordGameplayCue(AActor* TargetActor, FGameplayTag GameplayCueTag, const FGameplayCueParameters& Parameters);
+
+	// Returns true if Cue was merged into one already in Queue
+	bool MergeQueuedLocalGameplayCue(FGSLocalGameplayCueQueue& Queue, const FGSQueuedLocalGameplayCue& Cue) const;
 };
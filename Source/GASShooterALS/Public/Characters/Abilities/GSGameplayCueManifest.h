@@ -0,0 +1,48 @@
+// Copyright 2020 Dan Kestranek.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "GameplayTagContainer.h"
+#include "GSGameplayCueManifest.generated.h"
+
+class AGSWeapon;
+class UGameplayAbility;
+
+/**
+ * Which GameplayCues each map, weapon and ability was seen using. UGSGameplayCueManager records it while playing with
+ * GS.Cue.RecordManifest 1, GS.Cue.SaveManifest merges the recording into the manifest, and the cue manager async loads
+ * from it when a map loads and when a weapon is picked up.
+ *
+ * The manifest is the asset set as GameplayCueManifestName in UGSAbilitySystemGlobals, or this class's defaults from
+ * DefaultGame.ini when no asset is set.
+ */
+UCLASS(BlueprintType, Config = Game)
+class GASSHOOTERALS_API UGSGameplayCueManifest : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	// Keyed by the map's package name without the PIE prefix, e.g. /Game/GASShooterALS/Maps/Playground
+	UPROPERTY(EditAnywhere, Config, Category = "GameplayCues")
+	TMap<FName, FGameplayTagContainer> CuesByMap;
+
+	UPROPERTY(EditAnywhere, Config, Category = "GameplayCues")
+	TMap<TSoftClassPtr<AGSWeapon>, FGameplayTagContainer> CuesByWeapon;
+
+	UPROPERTY(EditAnywhere, Config, Category = "GameplayCues")
+	TMap<TSoftClassPtr<UGameplayAbility>, FGameplayTagContainer> CuesByAbility;
+
+	static FName GetMapKey(const UWorld* World);
+
+	void GetCuesForMap(const UWorld* World, FGameplayTagContainer& OutCues) const;
+
+	// The weapon's own cues and the cues of the abilities it grants
+	void GetCuesForWeapon(const AGSWeapon* Weapon, FGameplayTagContainer& OutCues) const;
+
+	// Adds everything in Other to this manifest. Returns the number of cue tags that weren't in it yet.
+	int32 Append(const UGSGameplayCueManifest& Other);
+
+	void Reset();
+};
@@ -0,0 +1,122 @@
+// Copyright 2020 Dan Kestranek.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "GSPersistentTargetTracker.generated.h"
+
+UENUM(BlueprintType)
+enum class EGSTargetEvictionPolicy : uint8
+{
+	// A new target replaces the one that was acquired first
+	Oldest					UMETA(DisplayName = "Oldest"),
+	// A new target replaces the one farthest from the trace start. New targets farther than every tracked target are ignored.
+	Farthest				UMETA(DisplayName = "Farthest")
+};
+
+/**
+ * Fixed capacity set of HitResults used by trace TargetActors for lock-on style persistent targeting.
+ * Targets are kept in the order they were acquired in a ring buffer so evicting the oldest target is O(1), and hit
+ * Actors are indexed so checking whether an Actor is already tracked is O(1). HitResults without an Actor are allowed
+ * (the default end of trace hit) but aren't indexed.
+ *
+ * Storage is allocated in Init() and reused until the capacity grows. The ordering, dedupe and eviction rules are
+ * covered by the "GASShooterALS.Trace.PersistentTargetTracker" automation test.
+ */
+struct GASSHOOTERALS_API FGSPersistentTargetTracker
+{
+public:
+	FGSPersistentTargetTracker();
+
+	// Clears the tracker and sets how many targets it holds. Capacity is at least 1.
+	void Init(int32 InCapacity, EGSTargetEvictionPolicy InEvictionPolicy);
+
+	void Reset();
+
+	/**
+	* Tracks HitResult if its Actor isn't tracked yet. When full, a target is evicted according to the EvictionPolicy.
+	* Origin is used to measure distance for EGSTargetEvictionPolicy::Farthest.
+	* Returns false if HitResult was not added.
+	*/
+	bool Add(const FHitResult& HitResult, const FVector& Origin);
+
+	// Removes every target that Predicate returns true for in one pass, keeping the acquisition order. Returns the number removed.
+	template <typename PredicateType>
+	int32 RemoveAll(PredicateType Predicate)
+	{
+		int32 NumKept = 0;
+		for (int32 Index = 0; Index < Count; Index++)
+		{
+			const int32 Slot = GetSlot(Index);
+
+			if (Predicate(static_cast<const FHitResult&>(Slots[Slot])))
+			{
+				ClearSlot(Slot);
+				continue;
+			}
+
+			if (NumKept != Index)
+			{
+				MoveSlot(Slot, GetSlot(NumKept));
+			}
+
+			NumKept++;
+		}
+
+		const int32 NumRemoved = Count - NumKept;
+		Count = NumKept;
+		return NumRemoved;
+	}
+
+	bool Contains(const AActor* Actor) const;
+
+	// Copies the tracked HitResults, oldest first
+	void CopyTo(TArray<FHitResult>& OutHitResults) const;
+
+	void GetActors(TArray<AActor*>& OutActors) const;
+
+	FORCEINLINE int32 Num() const { return Count; }
+	FORCEINLINE int32 GetCapacity() const { return Capacity; }
+	FORCEINLINE bool IsFull() const { return Count >= Capacity; }
+	FORCEINLINE EGSTargetEvictionPolicy GetEvictionPolicy() const { return EvictionPolicy; }
+
+	// Index 0 is the oldest target
+	FORCEINLINE FHitResult& operator[](int32 Index)
+	{
+		check(Index >= 0 && Index < Count);
+		return Slots[GetSlot(Index)];
+	}
+
+	FORCEINLINE const FHitResult& operator[](int32 Index) const
+	{
+		check(Index >= 0 && Index < Count);
+		return Slots[GetSlot(Index)];
+	}
+
+protected:
+	TArray<FHitResult> Slots;
+
+	// Hit Actor to its index in Slots. Keyed by weak pointer so Actors destroyed while tracked can still be removed.
+	TMap<TWeakObjectPtr<AActor>, int32> SlotByActor;
+
+	// Slot of the oldest target
+	int32 Head;
+	int32 Count;
+	int32 Capacity;
+
+	EGSTargetEvictionPolicy EvictionPolicy;
+
+	FORCEINLINE int32 GetSlot(int32 Index) const
+	{
+		return (Head + Index) % Capacity;
+	}
+
+	// Index of the tracked target farthest from Origin
+	int32 FindFarthest(const FVector& Origin, float& OutDistanceSquared) const;
+
+	void RemoveAt(int32 Index);
+
+	void ClearSlot(int32 Slot);
+	void MoveSlot(int32 FromSlot, int32 ToSlot);
+};
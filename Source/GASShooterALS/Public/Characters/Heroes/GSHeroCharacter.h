@@ -6,8 +6,10 @@
 #include "Characters/GSCharacterBase.h"
 #include "Characters/Abilities/GSInteractable.h"
 #include "GameplayEffectTypes.h"
+#include "Net/Serialization/FastArraySerializer.h"
 #include "GSHeroCharacter.generated.h"
 
+class AGSHeroCharacter;
 class AGSWeapon;
 class UGameplayEffect;
 
@@ -25,12 +27,41 @@ enum class EGSHeroWeaponState : uint8
 };
 
 USTRUCT()
-struct GASSHOOTERALS_API FGSHeroInventory
+struct GASSHOOTERALS_API FGSHeroInventoryItem : public FFastArraySerializerItem
 {
-	GENERATED_USTRUCT_BODY()
+	GENERATED_BODY()
+
+	UPROPERTY()
+	AGSWeapon* Weapon;
 
+	// When the weapon was added. Clients receive and remove items in any order, so slots are sorted by this.
 	UPROPERTY()
-	TArray<AGSWeapon*> Weapons;
+	int32 Order;
+
+	FGSHeroInventoryItem() : Weapon(nullptr), Order(0) {}
+	FGSHeroInventoryItem(AGSWeapon* InWeapon, int32 InOrder) : Weapon(InWeapon), Order(InOrder) {}
+
+	void PostReplicatedAdd(const struct FGSHeroInventory& InArraySerializer);
+	// Weapons that weren't relevant yet when the item arrived replicate as null and show up here once they resolve
+	void PostReplicatedChange(const struct FGSHeroInventory& InArraySerializer);
+	void PreReplicatedRemove(const struct FGSHeroInventory& InArraySerializer);
+};
+
+/**
+ * Replicated per weapon, so picking up or dropping one weapon only sends that weapon.
+ * Weapons are addressed by slot, in the order they were added, which is the order NextWeapon() and PreviousWeapon() cycle through.
+ * We only ever hold one weapon of each class, so the weapon class index doubles as the lookup for a weapon's slot.
+ */
+USTRUCT()
+struct GASSHOOTERALS_API FGSHeroInventory : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FGSHeroInventoryItem> Items;
+
+	UPROPERTY(NotReplicated)
+	AGSHeroCharacter* Owner = nullptr;
 
 	// Consumable items
 
@@ -39,6 +70,50 @@ struct GASSHOOTERALS_API FGSHeroInventory
 	// Door keys
 
 	// Etc
+
+	int32 Num() const { return Items.Num(); }
+
+	AGSWeapon* GetWeapon(int32 Slot) const;
+
+	// Slot of InWeapon, or INDEX_NONE
+	int32 FindWeapon(const AGSWeapon* InWeapon) const;
+
+	// Whether we already hold a weapon of InWeapon's class
+	bool ContainsWeaponClass(const AGSWeapon* InWeapon) const;
+
+	// Server only
+	void AddWeapon(AGSWeapon* InWeapon);
+	bool RemoveWeapon(AGSWeapon* InWeapon);
+
+	// Slots are rebuilt on the next lookup after a removal or a replicated change
+	void MarkSlotsDirty() const { bSlotsDirty = true; }
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FGSHeroInventoryItem, FGSHeroInventory>(Items, DeltaParms, *this);
+	}
+
+protected:
+	// Indices into Items, sorted by Order
+	mutable TArray<int32> Slots;
+
+	// Weapon class to slot
+	mutable TMap<const UClass*, int32> SlotByClass;
+
+	mutable bool bSlotsDirty = false;
+
+	int32 NextOrder = 0;
+
+	void UpdateSlots() const;
+};
+
+template<>
+struct TStructOpsTypeTraits<FGSHeroInventory> : public TStructOpsTypeTraitsBase2<FGSHeroInventory>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
 };
 
 /**
@@ -48,6 +123,8 @@ UCLASS(Blueprintable, BlueprintType)
 class GASSHOOTERALS_API AGSHeroCharacter : public AGSCharacterBase, public IGSInteractable
 {
 	GENERATED_BODY()
+
+	friend struct FGSHeroInventoryItem;
 	
 public:
 	AGSHeroCharacter(const class FObjectInitializer& ObjectInitializer);
@@ -78,6 +155,11 @@ public:
 
 	virtual void FinishDying() override;
 
+	// Server only. Called by UGSActorPoolSubsystem in place of EndPlay() when a dead hero is pooled, and before it is
+	// possessed again on respawn in place of PostInitializeComponents().
+	virtual void OnReturnedToPool();
+	virtual void OnAcquiredFromPool();
+
 	UFUNCTION(BlueprintCallable, Category = "GASShooterALS|GSHeroCharacter")
 	virtual bool IsInFirstPersonPerspective() const;
 
@@ -235,7 +317,7 @@ protected:
 	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "GASShooterALS|UI")
 	class UWidgetComponent* UIFloatingStatusBarComponent;
 
-	UPROPERTY(ReplicatedUsing = OnRep_Inventory)
+	UPROPERTY(Replicated)
 	FGSHeroInventory Inventory;
 
 	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "GASShooterALS|Inventory")
@@ -272,6 +354,8 @@ protected:
 
 	// Tag changed delegate handles
 	FDelegateHandle WeaponChangingDelayReplicationTagChangedDelegateHandle;
+	FDelegateHandle KnockedDownTagChangedDelegateHandle;
+	FDelegateHandle InteractingTagChangedDelegateHandle;
 
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
@@ -300,6 +384,9 @@ protected:
 	// Server spawns default inventory
 	void SpawnDefaultInventory();
 
+	// Server adds Amount to the reserve ammo of AmmoType, like when picking up a weapon we already have
+	void GiveReserveAmmo(const FGameplayTag& AmmoType, int32 Amount);
+
 	void SetupStartupPerspective();
 
 	bool DoesWeaponExistInInventory(AGSWeapon* InWeapon);
@@ -324,12 +411,21 @@ protected:
 
 	// Tag changed callbacks
 	virtual void WeaponChangingDelayReplicationTagChanged(const FGameplayTag CallbackTag, int32 NewCount);
+	virtual void InteractionAvailabilityTagChanged(const FGameplayTag CallbackTag, int32 NewCount);
+
+	// Lets interaction scans know when IsAvailableForInteraction() may have changed
+	void BindInteractionAvailabilityTagEvents();
+	void UnbindInteractionAvailabilityTagEvents();
+
+	// Forgets the PlayerState's ability system component and attribute sets when we lose the PlayerState but aren't destroyed
+	void ClearAbilitySystemReferences();
 
 	UFUNCTION()
 	void OnRep_CurrentWeapon(AGSWeapon* LastWeapon);
 
-	UFUNCTION()
-	void OnRep_Inventory();
+	// Called on clients by FGSHeroInventoryItem as weapons replicate in and out of the inventory
+	void OnInventoryWeaponAdded(AGSWeapon* Weapon);
+	void OnInventoryWeaponRemoved(AGSWeapon* Weapon);
 
 	void OnAbilityActivationFailed(const UGameplayAbility* FailedAbility, const FGameplayTagContainer& FailTags);
 	
@@ -0,0 +1,98 @@
+// Copyright 2020 Dan Kestranek.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GSActorPoolSubsystem.generated.h"
+
+class AGSHeroCharacter;
+class AGSWeapon;
+class ASpectatorPawn;
+
+/**
+ * Server only. Keeps heroes, spectator pawns and weapons around across death and respawn instead of destroying them and
+ * spawning new ones, so a respawn doesn't cost a spawn, a fresh actor channel on every client and garbage for the collector.
+ * Released actors are hidden, stop ticking and colliding, and go net dormant. Acquiring one puts it back at the spawn
+ * transform and lets the actor reset itself through its OnAcquiredFromPool().
+ *
+ * The static functions fall back to spawning and destroying when there is no pool in the world or GS.Pool.Enabled is 0.
+ * Use "GS.Pool.Report" to log how many actors were spawned, reused and destroyed along with the number of garbage
+ * collections and live UObjects, and compare a bot soak with GS.Pool.Enabled on and off. "stat GSActorPool" shows the same counts.
+ */
+UCLASS(Config = Game)
+class GASSHOOTERALS_API UGSActorPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UGSActorPoolSubsystem();
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	static AGSHeroCharacter* AcquireHero(UWorld* World, TSubclassOf<AGSHeroCharacter> HeroClass, const FTransform& SpawnTransform);
+
+	static ASpectatorPawn* AcquireSpectator(UWorld* World, TSubclassOf<ASpectatorPawn> SpectatorClass, const FTransform& SpawnTransform);
+
+	// Not equipped or added to the inventory yet, like a weapon from SpawnActorDeferred() after FinishSpawning()
+	static AGSWeapon* AcquireWeapon(TSubclassOf<AGSWeapon> WeaponClass, AGSHeroCharacter* InOwner);
+
+	// Returns the actor to its class's pool, or destroys it if it can't be pooled. Pawns must already be unpossessed.
+	static void Release(AActor* Actor);
+
+	void LogReport() const;
+
+	void ResetCounters();
+
+protected:
+	enum class EPooledKind : uint8
+	{
+		Hero,
+		Spectator,
+		Weapon,
+		Other,
+		Count
+	};
+
+	struct FPoolCounters
+	{
+		int32 Spawned;
+		int32 Reused;
+		int32 Released;
+		int32 Destroyed;
+
+		FPoolCounters() : Spawned(0), Reused(0), Released(0), Destroyed(0) {}
+	};
+
+	// Released actors kept per class. Anything released while its class is full is destroyed.
+	UPROPERTY(Config)
+	int32 MaxPooledActorsPerClass;
+
+	TMap<const UClass*, TArray<TWeakObjectPtr<AActor>>> FreeActors;
+
+	FPoolCounters Counters[(uint8)EPooledKind::Count];
+
+	int32 NumGarbageCollections;
+
+	FDelegateHandle PostGarbageCollectHandle;
+
+	static EPooledKind GetKind(const AActor* Actor);
+
+	static const TCHAR* GetKindName(EPooledKind Kind);
+
+	// Pops a pooled actor of exactly this class and puts it at SpawnTransform, or returns nullptr if there is none
+	AActor* AcquireActor(UClass* Class, const FTransform& SpawnTransform);
+
+	void ReleaseActor(AActor* Actor);
+
+	void CountSpawned(EPooledKind Kind);
+
+	void ParkActor(AActor* Actor);
+	void UnparkActor(AActor* Actor, const FTransform& SpawnTransform);
+
+	void UpdateStats() const;
+
+	void OnPostGarbageCollect();
+};
@@ -0,0 +1,161 @@
+// Copyright 2020 Dan Kestranek.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "GSInteractableSubsystem.generated.h"
+
+class ULevel;
+
+DECLARE_STATS_GROUP(TEXT("GSInteractables"), STATGROUP_GSInteractables, STATCAT_Advanced);
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FGSInteractableAvailabilityChanged, AActor*);
+
+/**
+ * Sparse uniform grid of bounding spheres. Each entry is bucketed by its center, queries are widened by the largest
+ * radius ever added so big entries are never missed.
+ * Every add and every move stamps the entry with a new revision so callers can tell whether anything in a query changed.
+ */
+struct GASSHOOTERALS_API FGSInteractableGrid
+{
+public:
+	explicit FGSInteractableGrid(float InCellSize = 500.0f);
+
+	// Returns a handle for Update() and Remove()
+	int32 Add(const FVector& Location, float Radius, const AActor* Actor);
+
+	void Remove(int32 Handle);
+
+	// Moves the entry, changing cells only if it crossed a cell boundary
+	void Update(int32 Handle, const FVector& Location);
+
+	void Reset();
+
+	/**
+	* Is any entry other than IgnoreActor's within Range of Origin and inside the cone around Direction?
+	* The test is conservative. An entry passes if any part of its bounding sphere could be inside the cone.
+	*/
+	bool HasCandidate(const FVector& Origin, const FVector& Direction, float Range, float ConeHalfAngleRadians, const AActor* IgnoreActor) const;
+
+	// Same test as HasCandidate() but counts every candidate and returns the newest revision among them
+	int32 CountCandidates(const FVector& Origin, const FVector& Direction, float Range, float ConeHalfAngleRadians, const AActor* IgnoreActor, uint32& OutNewestRevision) const;
+
+	FORCEINLINE int32 Num() const { return Entries.Num() - FreeEntries.Num(); }
+
+protected:
+	struct FEntry
+	{
+		FVector Location;
+		float Radius;
+		const AActor* Actor;
+		FIntVector Cell;
+		uint32 Revision;
+		bool bInUse;
+	};
+
+	TArray<FEntry> Entries;
+	TArray<int32> FreeEntries;
+	TMap<FIntVector, TArray<int32>> Cells;
+	float CellSize;
+	float MaxRadius;
+	uint32 RevisionCounter;
+
+	FORCEINLINE FIntVector GetCell(const FVector& Location) const
+	{
+		return FIntVector(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize), FMath::FloorToInt(Location.Z / CellSize));
+	}
+
+	bool IsCandidate(const FEntry& Entry, const FVector& Origin, const FVector& Direction, float Range, float ConeHalfAngleRadians, const AActor* IgnoreActor) const;
+
+	// Calls Visitor with every candidate until it returns true. Returns true if a Visitor returned true.
+	template <typename VisitorType>
+	bool VisitCandidates(const FVector& Origin, const FVector& Direction, float Range, float ConeHalfAngleRadians, const AActor* IgnoreActor, VisitorType Visitor) const;
+};
+
+/**
+ * Keeps every Actor that implements IGSInteractable in a uniform grid so that interaction scans can tell that nothing
+ * interactable is nearby without tracing. Actors are found when they spawn, when a level is added to the world and on
+ * world BeginPlay. Movable ones are re-bucketed every tick and destroyed ones are dropped.
+ *
+ * Use "stat GSInteractables" for the query cost and skipped scans and "GS.Interactables.Benchmark [Players] [Interactables]"
+ * to compare grid queries against the traces they replace.
+ */
+UCLASS(Config = Game)
+class GASSHOOTERALS_API UGSInteractableSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	UGSInteractableSubsystem();
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+
+	// Actors that implement IGSInteractable are registered automatically. Only call these for Actors that start or stop
+	// being interactable some other way.
+	void RegisterInteractable(AActor* Actor);
+	void UnregisterInteractable(AActor* Actor);
+
+	// See FGSInteractableGrid::HasCandidate()
+	bool HasInteractableCandidate(const FVector& Origin, const FVector& Direction, float Range, float ConeHalfAngleRadians, const AActor* IgnoreActor) const;
+
+	// See FGSInteractableGrid::CountCandidates()
+	int32 CountInteractableCandidates(const FVector& Origin, const FVector& Direction, float Range, float ConeHalfAngleRadians, const AActor* IgnoreActor, uint32& OutNewestRevision) const;
+
+	/**
+	* Interactables call this when the result of IsAvailableForInteraction() may have changed so that scans watching them
+	* can retrace instead of polling. IGSInteractable calls it when an interacter registers or unregisters, so interactables
+	* that only change when they're interacted with don't need to.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Interactable")
+	void NotifyAvailabilityChanged(AActor* Interactable);
+
+	FGSInteractableAvailabilityChanged OnAvailabilityChanged;
+
+	/**
+	* NumPlayers random viewers scan for NumInteractables random interactables in a scratch grid. Logs the average grid
+	* query cost, how many scans the grid lets us skip and the cost of the two traces each scan would do in this world.
+	*/
+	void RunBenchmark(int32 NumPlayers, int32 NumInteractables) const;
+
+protected:
+	UPROPERTY(Config)
+	float CellSize;
+
+	FGSInteractableGrid Grid;
+
+	struct FInteractable
+	{
+		TWeakObjectPtr<AActor> Actor;
+
+		// Key in InteractableIndexByActor, still usable after the Actor is destroyed
+		const AActor* ActorKey;
+
+		int32 GridHandle;
+		bool bMovable;
+	};
+
+	TArray<FInteractable> Interactables;
+	TMap<const AActor*, int32> InteractableIndexByActor;
+
+	FDelegateHandle ActorSpawnedHandle;
+	FDelegateHandle LevelAddedHandle;
+
+	void OnActorSpawned(AActor* Actor);
+	void OnLevelAddedToWorld(ULevel* Level, UWorld* World);
+
+	void RegisterLevelInteractables(ULevel* Level);
+
+	void RemoveInteractableAt(int32 Index);
+};
@@ -0,0 +1,161 @@
+// Copyright 2020 Dan Kestranek.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "GSLagCompensationSubsystem.generated.h"
+
+class AGSHeroCharacter;
+class USkeletalMesh;
+
+/**
+ * Bone that is recorded in the rewind history. Approximated as a sphere around the bone's location.
+ */
+USTRUCT()
+struct GASSHOOTERALS_API FGSLagCompensationHitbox
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Config)
+	FName BoneName;
+
+	UPROPERTY(Config)
+	float Radius;
+
+	FGSLagCompensationHitbox() : Radius(0.0f) {}
+
+	FGSLagCompensationHitbox(FName InBoneName, float InRadius) : BoneName(InBoneName), Radius(InRadius) {}
+};
+
+/**
+ * One recorded tick of a hero's capsule.
+ */
+struct FGSLagCompensationFrame
+{
+	FVector CapsuleLocation;
+	FQuat CapsuleRotation;
+	float CapsuleRadius;
+	float CapsuleHalfHeight;
+};
+
+/**
+ * Server only. Keeps a short history of every hero's capsule and hitbox bone transforms so that hits sent by clients
+ * can be validated against the world as the client saw it when they fired instead of against current time collision.
+ *
+ * All history is stored in flat arrays that are allocated once in Initialize(). Recording a tick and rewinding a hero
+ * never allocates. Heroes register themselves in BeginPlay() and unregister in EndPlay().
+ *
+ * Use "stat GSLagCompensation" to see the record and rewind cost, and "GS.LagCompensation.Benchmark [Shots]" to measure
+ * the rewind cost per validated shot against the current history.
+ */
+UCLASS(Config = Game)
+class GASSHOOTERALS_API UGSLagCompensationSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	UGSLagCompensationSubsystem();
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+
+	void RegisterHero(AGSHeroCharacter* Hero);
+	void UnregisterHero(AGSHeroCharacter* Hero);
+
+	/**
+	* Server time that the shooter's view of the world corresponds to, based on their ping. ShotAge is how long before
+	* the shot's RPC was sent it was fired, for shots that were held in a bundle. The total rewind is clamped to MaxRewindTime.
+	*/
+	float GetRewindTimeForShooter(const AController* Shooter, float ShotAge = 0.0f) const;
+
+	/**
+	* Rewinds the hit Actor to RewindTime and checks that the hit lies on its capsule and, if the hit bone is a tracked
+	* hitbox, on that bone. Hits on Actors that aren't tracked always pass.
+	*/
+	bool ValidateHit(const FHitResult& HitResult, float RewindTime) const;
+
+	// Runs NumShots synthetic validations against the current history and returns the average cost in microseconds
+	double RunBenchmark(int32 NumShots) const;
+
+protected:
+	// Maximum number of heroes that can be tracked at one time
+	UPROPERTY(Config)
+	int32 MaxTrackedHeroes;
+
+	// Number of ticks of history kept per hero. At 60Hz, 64 frames is just over one second.
+	UPROPERTY(Config)
+	int32 MaxHistoryFrames;
+
+	// Never rewind further than this (seconds). Shots older than this are validated against the oldest frame.
+	UPROPERTY(Config)
+	float MaxRewindTime;
+
+	UPROPERTY(Config)
+	TArray<FGSLagCompensationHitbox> Hitboxes;
+
+	struct FHeroSlot
+	{
+		TWeakObjectPtr<AGSHeroCharacter> Hero;
+
+		// SkeletalMesh the BoneIndices were resolved against
+		TWeakObjectPtr<USkeletalMesh> CachedSkeletalMesh;
+
+		// Offset into BoneIndices, one entry per Hitbox
+		int32 BoneIndexOffset;
+
+		// Frames recorded since this hero registered, clamped to MaxHistoryFrames
+		int32 NumValidFrames;
+
+		FHeroSlot() : BoneIndexOffset(INDEX_NONE), NumValidFrames(0) {}
+	};
+
+	TArray<FHeroSlot> Slots;
+	TArray<int32> FreeSlots;
+	TMap<const AActor*, int32> SlotIndexByHero;
+
+	// Per slot bone indices, MaxTrackedHeroes * Hitboxes.Num()
+	TArray<int32> BoneIndices;
+
+	// Ring buffer shared by every slot since all heroes are recorded on the same tick
+	TArray<float> FrameTimestamps;
+	int32 FrameHead;
+
+	// MaxTrackedHeroes * MaxHistoryFrames
+	TArray<FGSLagCompensationFrame> Frames;
+
+	// MaxTrackedHeroes * MaxHistoryFrames * Hitboxes.Num()
+	TArray<FVector> HitboxLocations;
+
+	// Hitboxes.Num(). ValidateHit() rewinds into this so it doesn't allocate however many hitboxes are configured.
+	mutable TArray<FVector> RewoundHitboxLocations;
+
+	void RecordFrame(float Timestamp);
+
+	void RefreshBoneIndices(FHeroSlot& Slot, int32 SlotIndex);
+
+	/**
+	* Interpolates the slot's history at Time. OutHitboxLocations must have Hitboxes.Num() elements.
+	* Returns false if the slot has no history yet.
+	*/
+	bool RewindSlot(int32 SlotIndex, float Time, FGSLagCompensationFrame& OutFrame, TArrayView<FVector> OutHitboxLocations) const;
+
+	FORCEINLINE int32 GetFrameIndex(int32 SlotIndex, int32 RingIndex) const
+	{
+		return SlotIndex * MaxHistoryFrames + RingIndex;
+	}
+
+	FORCEINLINE int32 GetHitboxIndex(int32 SlotIndex, int32 RingIndex, int32 HitboxIndex) const
+	{
+		return GetFrameIndex(SlotIndex, RingIndex) * Hitboxes.Num() + HitboxIndex;
+	}
+};
@@ -0,0 +1,145 @@
+// Copyright 2020 Dan Kestranek.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "GSNetUpdateFrequencySubsystem.generated.h"
+
+class UAbilitySystemComponent;
+
+/**
+ * Floor and ceiling of the NetUpdateFrequency of actors of a class and its subclasses.
+ */
+USTRUCT()
+struct GASSHOOTERALS_API FGSNetUpdateFrequencyLimits
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Config)
+	TSubclassOf<AActor> ActorClass;
+
+	UPROPERTY(Config)
+	float MinNetUpdateFrequency;
+
+	UPROPERTY(Config)
+	float MaxNetUpdateFrequency;
+
+	FGSNetUpdateFrequencyLimits() : MinNetUpdateFrequency(0.0f), MaxNetUpdateFrequency(0.0f) {}
+
+	FGSNetUpdateFrequencyLimits(TSubclassOf<AActor> InActorClass, float InMinNetUpdateFrequency, float InMaxNetUpdateFrequency)
+		: ActorClass(InActorClass), MinNetUpdateFrequency(InMinNetUpdateFrequency), MaxNetUpdateFrequency(InMaxNetUpdateFrequency) {}
+};
+
+/**
+ * Server only. Adjusts the NetUpdateFrequency of registered actors between their class's floor and ceiling, based on how
+ * often their replicated state changed recently and how close the nearest other player is. Actors whose ability system
+ * component is firing a weapon or recently took damage stay at their ceiling.
+ *
+ * PlayerStates, weapons and projectiles register themselves in BeginPlay() and unregister in EndPlay(). Code that changes
+ * their replicated state calls NotifyReplicatedStateChanged(), which for PlayerStates includes every
+ * UGSAbilitySystemComponent ForceReplication(). Projectiles report bounces, stops and homing, not straight flight that
+ * clients extrapolate. The first change after an idle period forces a net update so an actor at its floor doesn't add
+ * latency.
+ *
+ * Use "stat GSNetUpdateFrequency" to see how many net updates per second are saved against the ceilings, and
+ * "GS.Net.AdaptiveFrequencyReport" to log the current frequency of every registered actor.
+ * Compare "stat net" with GS.Net.AdaptiveFrequency on and off for the bandwidth saved.
+ */
+UCLASS(Config = Game)
+class GASSHOOTERALS_API UGSNetUpdateFrequencySubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	UGSNetUpdateFrequencySubsystem();
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+
+	// Actors without configured limits for their class are ignored
+	void RegisterActor(AActor* Actor);
+	void UnregisterActor(AActor* Actor);
+
+	static void NotifyReplicatedStateChanged(AActor* Actor);
+
+	// Keeps actors using this ability system component at their ceiling for CombatDuration
+	static void NotifyDamaged(UAbilitySystemComponent* AbilitySystemComponent);
+
+	void LogReport() const;
+
+protected:
+	UPROPERTY(Config)
+	TArray<FGSNetUpdateFrequencyLimits> Limits;
+
+	// Seconds between frequency updates
+	UPROPERTY(Config)
+	float UpdateInterval;
+
+	// Replicated state changes per second that put an actor at its ceiling
+	UPROPERTY(Config)
+	float ChangeRateForCeiling;
+
+	// Other players closer than this (cm) don't lower the frequency
+	UPROPERTY(Config)
+	float NearViewerDistance;
+
+	// Other players further than this (cm) scale the frequency by FarViewerScale
+	UPROPERTY(Config)
+	float FarViewerDistance;
+
+	UPROPERTY(Config)
+	float FarViewerScale;
+
+	// Seconds an actor stays at its ceiling after its ability system component took damage
+	UPROPERTY(Config)
+	float CombatDuration;
+
+	struct FAdaptiveActor
+	{
+		TWeakObjectPtr<AActor> Actor;
+
+		// Key in ActorIndexByActor, which stays valid for removal after the actor is gone
+		const AActor* ActorKey;
+
+		float MinFrequency;
+		float MaxFrequency;
+		float CurrentFrequency;
+
+		// Smoothed over the last few updates
+		float ChangesPerSecond;
+
+		int32 ChangesSinceUpdate;
+
+		FAdaptiveActor() : ActorKey(nullptr), MinFrequency(0.0f), MaxFrequency(0.0f), CurrentFrequency(0.0f), ChangesPerSecond(0.0f), ChangesSinceUpdate(0) {}
+	};
+
+	TArray<FAdaptiveActor> Actors;
+	TMap<const AActor*, int32> ActorIndexByActor;
+
+	TMap<TWeakObjectPtr<const UAbilitySystemComponent>, float> LastDamageTimes;
+
+	float TimeSinceUpdate;
+
+	FGameplayTag WeaponIsFiringTag;
+
+	const FGSNetUpdateFrequencyLimits* FindLimits(const UClass* Class) const;
+
+	void UpdateFrequencies(float DeltaTime);
+
+	void ApplyFrequency(FAdaptiveActor& Entry, float NewFrequency);
+
+	bool IsInCombat(const AActor* Actor, float Now) const;
+
+	void RemoveActorAt(int32 Index);
+};
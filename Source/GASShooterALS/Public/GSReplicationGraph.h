@@ -0,0 +1,101 @@
+// Copyright 2020 Dan Kestranek.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "GSReplicationGraph.generated.h"
+
+class AGSHeroCharacter;
+class AGSWeapon;
+class UReplicationGraphNode_ActorList;
+class UReplicationGraphNode_AlwaysRelevant_ForConnection;
+class UReplicationGraphNode_GridSpatialization2D;
+
+DECLARE_STATS_GROUP(TEXT("GSReplicationGraph"), STATGROUP_GSReplicationGraph, STATCAT_Advanced);
+
+// How actors of a class are routed to the graph's nodes
+enum class EGSClassRepNodeMapping : uint32
+{
+	// Not routed to a node. Replicated some other way, like PlayerControllers through the connection's always relevant node.
+	NotRouted,
+	RelevantAllConnections,
+
+	// Routed to the spatial grid
+	Spatialize_Static,		// Never move
+	Spatialize_Dynamic,		// Move every frame
+	Spatialize_Dormancy,	// Static while dormant, dynamic while awake
+};
+
+// Where a weapon is currently routed
+struct FGSWeaponRoute
+{
+	// Equipped weapons replicate along with the hero holding them
+	TWeakObjectPtr<AGSHeroCharacter> DependsOn;
+
+	// The rest of an inventory only replicates to the hero's owner
+	TWeakObjectPtr<UReplicationGraphNode_AlwaysRelevant_ForConnection> OwnerNode;
+
+	// Weapons lying in the world are pickups
+	bool bSpatialized = false;
+
+	bool operator==(const FGSWeaponRoute& Other) const
+	{
+		return DependsOn == Other.DependsOn && OwnerNode == Other.OwnerNode && bSpatialized == Other.bSpatialized;
+	}
+};
+
+/**
+ * Replication graph for the project. Heroes, projectiles and pickups are routed to a 2D spatial grid so each connection
+ * only considers what's near its viewer. Characters are culled at GS.RepGraph.CharacterCullDistance rather than their
+ * own NetCullDistanceSquared so they stay relevant as far as they can be shot. PlayerStates go through a frequency
+ * limiter and other always relevant actors, like the GameState, through a single list shared by every connection.
+ * Weapons are routed by hand. The equipped weapon is a dependent of the hero holding it, the rest of an inventory only
+ * goes to the owning connection, and dropped weapons are spatialized like other pickups.
+ * Enabled through ReplicationDriverClassName in DefaultEngine.ini.
+ */
+UCLASS(Transient)
+class GASSHOOTERALS_API UGSReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+
+	// Called by AGSWeapon::UpdateReplicationState whenever a weapon's owner or the owner's current weapon changes
+	static void NotifyWeaponRoutingChanged(AGSWeapon* Weapon);
+
+	// Call on the server after changing an actor's NetUpdateFrequency at runtime. The graph otherwise keeps the class default.
+	static void NotifyActorNetUpdateFrequencyChanged(AActor* Actor);
+
+	void LogWeaponRoutes() const;
+
+protected:
+	UPROPERTY()
+	UReplicationGraphNode_GridSpatialization2D* GridNode;
+
+	UPROPERTY()
+	UReplicationGraphNode_ActorList* AlwaysRelevantNode;
+
+	TClassMap<EGSClassRepNodeMapping> ClassRepNodePolicies;
+
+	TMap<TWeakObjectPtr<AGSWeapon>, FGSWeaponRoute> WeaponRoutes;
+
+	EGSClassRepNodeMapping GetMappingPolicy(UClass* Class);
+
+	void InitClassReplicationInfo(FClassReplicationInfo& Info, UClass* Class, bool bSpatialize) const;
+
+	UReplicationGraphNode_AlwaysRelevant_ForConnection* GetAlwaysRelevantNodeForConnection(UNetConnection* Connection);
+
+	void RouteWeapon(AGSWeapon* Weapon);
+	void ApplyWeaponRoute(AGSWeapon* Weapon, const FGSWeaponRoute& Route, bool bAdd);
+
+	FORCEINLINE static bool IsSpatialized(EGSClassRepNodeMapping Mapping)
+	{
+		return Mapping >= EGSClassRepNodeMapping::Spatialize_Static;
+	}
+};
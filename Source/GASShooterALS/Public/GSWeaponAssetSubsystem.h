@@ -0,0 +1,97 @@
+// Copyright 2020 Dan Kestranek.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "GSWeaponAssetSubsystem.generated.h"
+
+class AGSWeapon;
+struct FStreamableHandle;
+
+/**
+ * Streams in the cosmetic assets of weapons before they're needed. Weapons only hold soft references to their icons,
+ * equip montages, pickup sound and HUD reticle, so nothing of a weapon is loaded until someone is about to see it.
+ *
+ * A weapon's assets start loading when a local player comes within PreloadDistance of it lying as a pickup, when it is
+ * added to a locally controlled hero's inventory, and the first time one of them is asked for. They stay loaded until
+ * the map ends. Dedicated servers never load them, see LoadCosmeticAsset().
+ *
+ * Use "GS.WeaponAssets.Report" for the memory each weapon's cosmetic assets take, and "stat GSWeaponAssets" for how
+ * often an asset still had to be loaded synchronously.
+ */
+UCLASS(Config = Game)
+class GASSHOOTERALS_API UGSWeaponAssetSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	UGSWeaponAssetSubsystem();
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+
+	// Async loads the cosmetic assets of Weapon's class unless they're already loading. Does nothing on dedicated servers.
+	static void PreloadWeaponAssets(const AGSWeapon* Weapon, const TCHAR* Reason);
+
+	/**
+	* Returns Weapon's asset at Path, loading it synchronously if it wasn't preloaded. Always nullptr on dedicated servers
+	* since they don't draw or play anything.
+	*/
+	static UObject* LoadCosmeticAsset(const AGSWeapon* Weapon, const FSoftObjectPath& Path);
+
+	/**
+	* Returns Weapon's asset at Path only if it's already loaded. Otherwise starts preloading Weapon's assets and returns
+	* nullptr, for assets that can be skipped once instead of hitching, like equip montages.
+	*/
+	static UObject* FindResidentCosmeticAsset(const AGSWeapon* Weapon, const FSoftObjectPath& Path);
+
+	// Weapons lying in the world are watched for local players coming near them. Called from BeginPlay() and EndPlay().
+	void RegisterWeapon(AGSWeapon* Weapon);
+	void UnregisterWeapon(AGSWeapon* Weapon);
+
+	// Logs which cosmetic assets of every loaded weapon class are resident and how much memory they take
+	void LogReport() const;
+
+protected:
+	// Local players closer than this (cm) to a weapon pickup start loading its assets
+	UPROPERTY(Config)
+	float PreloadDistance;
+
+	// Seconds between pickup distance checks
+	UPROPERTY(Config)
+	float UpdateInterval;
+
+	struct FWeaponPreload
+	{
+		TSharedPtr<FStreamableHandle> Handle;
+		FString Reason;
+		double StartTime;
+
+		// Negative until the load completes
+		double LoadSeconds;
+
+		FWeaponPreload() : StartTime(0.0), LoadSeconds(-1.0) {}
+	};
+
+	TMap<const UClass*, FWeaponPreload> Preloads;
+
+	// Pickups whose class hasn't been preloaded yet
+	TArray<TWeakObjectPtr<AGSWeapon>> Pickups;
+
+	float TimeSinceUpdate;
+
+	void RequestPreload(const AGSWeapon* Weapon, const TCHAR* Reason);
+
+	void OnPreloadComplete(const UClass* WeaponClass);
+
+	void UpdatePickups();
+};
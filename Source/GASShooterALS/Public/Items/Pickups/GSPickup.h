@@ -17,6 +17,8 @@ class GASSHOOTERALS_API AGSPickup : public AActor
 public:	
 	AGSPickup();
 
+	virtual void BeginPlay() override;
+
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
 	// Pickup on touch
@@ -8,6 +8,8 @@
 #include "GameplayEffectTypes.h"
 #include "GSPlayerState.generated.h"
 
+struct FGameplayEffectSpec;
+
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FGSOnGameplayAttributeValueChangedDelegate, FGameplayAttribute, Attribute, float, NewValue, float, OldValue);
 
 /**
@@ -133,9 +135,13 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	// Attribute changed callbacks
 	virtual void HealthChanged(const FOnAttributeChangeData& Data);
 
+	virtual void GameplayEffectAppliedToSelf(UAbilitySystemComponent* Source, const FGameplayEffectSpec& SpecApplied, FActiveGameplayEffectHandle ActiveHandle);
+
 	// Tag changed callbacks
 	virtual void KnockDownTagChanged(const FGameplayTag CallbackTag, int32 NewCount);
 };
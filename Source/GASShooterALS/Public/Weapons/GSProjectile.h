@@ -15,7 +15,19 @@ public:
 	// Sets default values for this actor's properties
 	AGSProjectile();
 
+	virtual void Tick(float DeltaSeconds) override;
+
 protected:
 	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "PBProjectile")
 	class UProjectileMovementComponent* ProjectileMovement;
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Server only. Changes of course that clients can't extrapolate from the last replicated velocity.
+	UFUNCTION()
+	void OnProjectileBounce(const FHitResult& ImpactResult, const FVector& ImpactVelocity);
+
+	UFUNCTION()
+	void OnProjectileStop(const FHitResult& ImpactResult);
 };
@@ -18,8 +18,10 @@ class AGSHeroCharacter;
 class UAnimMontage;
 class UGSAbilitySystemComponent;
 class UGSGameplayAbility;
+class UGSHUDReticle;
 class UPaperSprite;
 class USkeletalMeshComponent;
+class USoundCue;
 
 UCLASS(Blueprintable, BlueprintType)
 class GASSHOOTERALS_API AGSWeapon : public AActor, public IAbilitySystemInterface
@@ -43,23 +45,31 @@ public:
 	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "GASShooterALS|GSWeapon")
 	FGameplayTagContainer RestrictedPickupTags;
 	
+	// Cosmetic assets are soft references so they're only loaded where and when they're needed, see UGSWeaponAssetSubsystem.
+	// Use the getters, which load them on first use if they weren't preloaded.
+
 	// UI HUD Primary Icon when equipped. Using Sprites because of the texture atlas from ShooterGame.
 	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "GASShooterALS|UI")
-	UPaperSprite* PrimaryIcon;
+	TSoftObjectPtr<UPaperSprite> PrimaryIcon;
 
 	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "GASShooterALS|UI")
-	UPaperSprite* SecondaryIcon;
+	TSoftObjectPtr<UPaperSprite> SecondaryIcon;
 
 	// UI HUD Primary Clip Icon when equipped
 	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "GASShooterALS|UI")
-	UPaperSprite* PrimaryClipIcon;
+	TSoftObjectPtr<UPaperSprite> PrimaryClipIcon;
 
 	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "GASShooterALS|UI")
-	UPaperSprite* SecondaryClipIcon;
+	TSoftObjectPtr<UPaperSprite> SecondaryClipIcon;
 
 	UPROPERTY(BlueprintReadWrite, VisibleInstanceOnly, Category = "GASShooterALS|GSWeapon")
 	FGameplayTag FireMode;
 
+	// Fire modes whose shots are bundled into one target data RPC per GS.Ability.ShotBundleInterval, see
+	// UGSAbilitySystemComponent::SendTargetDataToServer(). Defaults to the full auto fire modes.
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "GASShooterALS|GSWeapon")
+	FGameplayTagContainer BundledTargetDataFireModes;
+
 	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "GASShooterALS|GSWeapon")
 	FGameplayTag PrimaryAmmoType;
 
@@ -97,6 +107,15 @@ public:
 
 	void SetOwningCharacter(AGSHeroCharacter* InOwningCharacter);
 
+	// Call on the server whenever the weapon is equipped, holstered, or added to or removed from an inventory.
+	// Updates the weapon's net dormancy and its route through the replication graph.
+	void UpdateReplicationState();
+
+	// Server only. Called by UGSActorPoolSubsystem when the weapon is pooled instead of destroyed, and when it is handed
+	// out again as if it was just spawned for InOwner's default inventory.
+	virtual void OnReturnedToPool();
+	virtual void OnAcquiredFromPool(AGSHeroCharacter* InOwner);
+
 	// Pickup on touch
 	virtual void NotifyActorBeginOverlap(class AActor* Other) override;
 
@@ -112,6 +131,11 @@ public:
 
 	virtual int32 GetAbilityLevel(EGSAbilityInputID AbilityID);
 
+	FORCEINLINE const TArray<TSubclassOf<UGSGameplayAbility>>& GetAbilities() const { return Abilities; }
+
+	// True while the current fire mode is one of BundledTargetDataFireModes
+	FORCEINLINE bool ShouldBundleTargetData() const { return FireMode.MatchesAnyExact(BundledTargetDataFireModes); }
+
 	// Resets things like fire mode to default
 	UFUNCTION(BlueprintCallable, Category = "GASShooterALS|GSWeapon")
 	virtual void ResetWeapon();
@@ -146,19 +170,27 @@ public:
 	virtual void SetMaxSecondaryClipAmmo(int32 NewMaxSecondaryClipAmmo);
 
 	UFUNCTION(BlueprintCallable, Category = "GASShooterALS|GSWeapon")
-	TSubclassOf<class UGSHUDReticle> GetPrimaryHUDReticleClass() const;
+	TSubclassOf<UGSHUDReticle> GetPrimaryHUDReticleClass() const;
+
+	UFUNCTION(BlueprintCallable, Category = "GASShooterALS|UI")
+	UPaperSprite* GetPrimaryIcon() const;
 
 	UFUNCTION(BlueprintCallable, Category = "GASShooterALS|GSWeapon")
 	virtual bool HasInfiniteAmmo() const;
 
+	// nullptr until the weapon's assets are loaded. Asking starts loading them.
 	UFUNCTION(BlueprintCallable, Category = "GASShooterALS|Animation")
 	UAnimMontage* GetEquip1PMontage() const;
 
+	// nullptr until the weapon's assets are loaded. Asking starts loading them.
 	UFUNCTION(BlueprintCallable, Category = "GASShooterALS|Animation")
 	UAnimMontage* GetEquip3PMontage() const;
 	
 	UFUNCTION(BlueprintCallable, Category = "GASShooterALS|Audio")
-	class USoundCue* GetPickupSound() const;
+	USoundCue* GetPickupSound() const;
+
+	// Icons, montages, sounds and the HUD reticle. Nothing the server needs to run the weapon.
+	void GetCosmeticAssetPaths(TArray<FSoftObjectPath>& OutPaths) const;
 
 	UFUNCTION(BlueprintCallable, Category = "GASShooterALS|GSWeapon")
 	FText GetDefaultStatusText() const;
@@ -193,7 +225,7 @@ protected:
 	bool bInfiniteAmmo;
 
 	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "GASShooterALS|UI")
-	TSubclassOf<class UGSHUDReticle> PrimaryHUDReticleClass;
+	TSoftClassPtr<UGSHUDReticle> PrimaryHUDReticleClass;
 
 	UPROPERTY()
 	AGSGATA_LineTrace* LineTraceTargetActor;
@@ -241,14 +273,14 @@ protected:
 	FText DefaultStatusText;
 
 	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "GASShooterALS|Animation")
-	UAnimMontage* Equip1PMontage;
+	TSoftObjectPtr<UAnimMontage> Equip1PMontage;
 
 	UPROPERTY(BlueprintReadonly, EditAnywhere, Category = "GASShooterALS|Animation")
-	UAnimMontage* Equip3PMontage;
+	TSoftObjectPtr<UAnimMontage> Equip3PMontage;
 
 	// Sound played when player picks it up
 	UPROPERTY(EditDefaultsOnly, Category = "GASShooterALS|Audio")
-	class USoundCue* PickupSound;
+	TSoftObjectPtr<USoundCue> PickupSound;
 
 	// Cache tags
 	FGameplayTag WeaponPrimaryInstantAbilityTag;
@@ -262,6 +294,10 @@ protected:
 	// Called when the player picks up this weapon
 	virtual void PickUpOnTouch(AGSHeroCharacter* InCharacter);
 
+	// Server only. Runs the frame after OnDropped so the multicast goes out before the weapon goes dormant.
+	// Does nothing if the weapon was picked up in the meantime.
+	void GoDormantOnGround();
+
 	UFUNCTION()
 	virtual void OnRep_PrimaryClipAmmo(int32 OldPrimaryClipAmmo);
 
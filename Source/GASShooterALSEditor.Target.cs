@@ -9,6 +9,7 @@ public class GASShooterALSEditorTarget : TargetRules
 	{
 		Type = TargetType.Editor;
 		DefaultBuildSettings = BuildSettingsVersion.V2;
+		bWithPushModel = true;
 		ExtraModuleNames.AddRange( new string[] { "GASShooterALS" } );
 	}
 }